@@ -1,20 +1,49 @@
 #ifndef ARENA_H
 #define ARENA_H
 
+#include "pool.h"
+#include "tile_grid.h"
 #include "utils.h"
 
 typedef enum {
     T_EMPTY = 0,
     T_OBSTACLE = 1,
     T_MARKER = 2,
-    T_R_START = 3
+    T_R_START = 3,
+    T_DEPOT = 4 // where markers are delivered to, when it is not the robot's start
 } ArenaTile;
 
+// markers left on the arena, kept in a dense array so they can be visited without scanning arenaGrid
+typedef struct {
+    Coord *positions; // the first numMarker entries are the markers left on the arena, in no particular order
+    int *slots; // hash table from a tile's position to its index in positions, -1 where empty
+    int capacity; // most markers the index can hold
+    int tableSize; // power of two, at least twice capacity
+} MarkerIndex;
+
+// a scripted change to the arena during the search, such as a door closing or an obstacle moving off a tile
+typedef struct {
+    long long step; // applied just before the robot's action with this number, counting from 0
+    int x;
+    int y;
+    int blocked; // 1 to put an obstacle on the tile, 0 to clear it
+} ObstacleEvent;
+
 typedef struct {
     int arenaWidth;
     int arenaHeight;
-    ArenaTile **arenaGrid;
+    TileGrid arenaGrid; // ArenaTile of each tile, through get_tile and set_tile
     int numMarker;
+    MarkerIndex markers;
+    Rng rng; // used for all random generation in this arena
+    const ObstacleEvent *events; // scripted changes in order of step, owned by the caller; NULL if the arena never changes
+    int numEvents;
+    int nextEvent; // index of the first event not yet applied
+    long long step; // actions taken so far, against which events are applied
+    int changes; // tiles changed by events so far
+    Coord depot; // tile markers are delivered to when the robot has a carrying capacity, {-1, -1} if there is none
+    int numDelivered; // markers dropped at the depot so far
+    long long emptyTiles; // tiles nothing has been put on while generating the arena, so placing obstacles and markers can fail rather than look for a free tile forever
 } Arena;
 
 // options for the type of obstacle formation
@@ -31,15 +60,29 @@ typedef enum {
     M_RANDOM = 1
 } MarkerFormation;
 
-void check_obstacle_marker_values(Arena*, ObstacleFormation, int, MarkerFormation, int);
+Status check_obstacle_marker_values(Arena*, ObstacleFormation, int, MarkerFormation, int);
 
 // functions to generate obstacles and markers
-void generate_obstacles(Arena*, int, ObstacleFormation);
-void generate_markers(Arena*, int, MarkerFormation);
+Status generate_obstacles(Arena*, int, ObstacleFormation);
+Status generate_markers(Arena*, int, MarkerFormation);
+
+// functions to add, remove and find markers through the marker index
+Status add_marker(Arena*, int, int);
+void remove_marker(Arena*, int, int);
+int is_marker_at(Arena*, int, int);
+Coord nearest_marker(Arena*, Coord, int);
+void place_depot(Arena*, Coord, Coord);
+
+// functions for obstacles that change during the search
+Status check_obstacle_events(Arena*, const ObstacleEvent*, int);
+int apply_obstacle_events(Arena*, Coord);
+int obstacle_events_pending(Arena*);
+Status load_obstacle_events(const char*, ObstacleEvent**, int*);
 
 // functions dealing with arena struct
-Arena* create_arena(int, int);
-void free_arena(Arena*);
+size_t arena_pool_size(int, int, int, GridLayout);
+Arena* create_arena(Pool*, int, int, int, unsigned int, GridLayout);
+void release_arena(Arena*);
 
 // function to determine arena size
 int determine_arena_width(int, char**);
@@ -0,0 +1,18 @@
+#ifndef ASYNC_OUTPUT_H
+#define ASYNC_OUTPUT_H
+
+#include "utils.h"
+
+#include <stddef.h>
+
+// what to do with a frame when the writer thread has fallen so far behind that the buffer is full
+typedef enum {
+    AO_BLOCK = 0, // wait for the writer, so every frame is shown
+    AO_DROP = 1 // throw away the whole frame, so the search never waits on the drawapp
+} OutputPolicy;
+
+Status start_async_output(size_t, OutputPolicy);
+void stop_async_output(void);
+long async_output_dropped_frames(void);
+
+#endif
@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include "arena.h"
+#include "async_output.h"
 
 // Arena defaults
 extern const int DEFAULT_ARENA_WIDTH;
@@ -18,6 +19,20 @@ extern const int OBJECT_PADDING;
 extern const int MAX_WINDOW_WIDTH;
 extern const int MAX_WINDOW_HEIGHT;
 extern const int TIME_INTERVAL;
+extern const int FRAME_SKIP;
+extern const int TARGET_DURATION;
+extern const int TERMINAL_OUTPUT;
+extern const int PROFILE_PHASES;
+extern const char *const VISIT_IMAGE_FILE;
+extern const char *const VISIT_CSV_FILE;
+extern const char *const OBSTACLE_EVENTS_FILE;
+extern const char *const SNAPSHOT_FILE;
+extern const int SNAPSHOT_INTERVAL;
+extern const char *const RESUME_FILE;
+extern const int ASYNC_OUTPUT;
+extern const int OUTPUT_BUFFER_SIZE;
+extern const OutputPolicy OUTPUT_POLICY;
+extern const char *const OUTPUT_SINK;
 
 // obstacle configuration
 extern const ObstacleFormation obstacleFormation;
@@ -27,4 +42,19 @@ extern const unsigned int numObstacles; // should not exceed 1/3 number of tiles
 extern const MarkerFormation markerFormation; // do not do M_EDGE if obstacles have been generated with O_CAVERN
 extern const unsigned int numMarkers;
 
+// search configuration
+extern const int senseRadius;
+extern const GridLayout gridLayout;
+extern const int knownArena;
+extern const int hierarchicalRoutes;
+extern const int jumpPointRoutes;
+extern const int incrementalRoutes;
+extern const int turnAwareRoutes;
+extern const int routeMoveCost;
+extern const int routeTurnCost;
+
+// delivery configuration
+extern const int carryCapacity;
+extern const Coord deliveryDepot;
+
 #endif
@@ -4,12 +4,27 @@
 #include "arena.h"
 #include "robot.h"
 
+// settings for drawing that can be changed at runtime; fill with default_draw_config() then override fields
+typedef struct {
+    int tileSize; // pixels across each tile
+    int timeInterval; // miliseconds to wait after each frame
+    int frameSkip; // draw every Nth robot action (marker pickups are always drawn), must be at least 1
+    int targetDuration; // miliseconds the whole search should take to animate, 0 to always wait timeInterval per frame
+    int terminal; // 1 to draw in the terminal with ANSI escape codes instead of for the drawapp
+} DrawConfig;
+
+void default_draw_config(DrawConfig*);
+void set_draw_config(const DrawConfig*);
+
 // calculate max dimensions
 int calculate_max_arena_width();
 int calculate_max_arena_height();
 
 // functions called from main
 void draw_background(Arena*);
+void begin_foreground(void);
+void redraw_obstacles(Arena*);
 void draw_foreground(Robot*, Arena*);
+void finish_drawing(Robot*, Arena*);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef DSTAR_H
+#define DSTAR_H
+
+#include "pool.h"
+#include "tile_grid.h"
+#include "utils.h"
+
+#define DSTAR_INFINITY (1 << 29) // more moves than any route can take
+#define DSTAR_MAX_CHANGES 1024 // tiles that can change between routes before the search starts again from scratch
+
+// an entry of the open set, whose key is (k1 << 32 | k2) so keys compare as one number
+typedef struct {
+    long long key;
+    int tile;
+} DStarEntry;
+
+// an incremental search (D* Lite) from a goal back towards the robot over its memory, kept between routes to the same goal so when tiles change only the distances they affect are worked out again
+typedef struct DStar {
+    int width;
+    int height;
+    int *g; // moves from each tile to the goal as last worked out
+    int *rhs; // moves from each tile to the goal going by its neighbours' g, which differs from g where the tile is out of date
+    int *searchMark; // equal to searchId where g and rhs are set, both are DSTAR_INFINITY elsewhere
+    int searchId;
+    DStarEntry *heap; // open set as a binary min-heap, which may hold stale entries for tiles pushed again
+    int heapSize;
+    int heapCapacity;
+    int changed[DSTAR_MAX_CHANGES]; // tiles that changed since the last route
+    int numChanged;
+    int overflowed; // 1 if more than DSTAR_MAX_CHANGES tiles changed, so the next route starts from scratch
+    int active; // 1 once a search towards goal has been started
+    Coord goal;
+    Coord last; // where the robot was when the keys were last brought up to date
+    int km; // added to every key to make up for the robot moving since the search started
+    int expansions; // tiles taken off the open set by the last route
+} DStar;
+
+size_t dstar_pool_size(int, int);
+DStar* create_dstar(Pool*, int, int);
+void dstar_tile_changed(DStar*, int, int);
+Status dstar_route(DStar*, const TileGrid*, Coord, Coord, Coord*, size_t, int*);
+
+// this function checks if any tiles have changed since the last route, in which case a route to the same goal may no longer be the shortest
+static inline int dstar_has_changes(const DStar *dstar)
+{
+    return dstar->active && (dstar->numChanged > 0 || dstar->overflowed);
+}
+
+#endif
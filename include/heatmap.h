@@ -0,0 +1,15 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "arena.h"
+#include "robot.h"
+#include "utils.h"
+
+int max_visit_count(Robot*);
+int revisit_count(Robot*);
+
+// functions to write the robot's visit counts to a file at the end of a run
+Status export_visits_ppm(Robot*, Arena*, const char*, int);
+Status export_visits_csv(Robot*, const char*);
+
+#endif
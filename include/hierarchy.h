@@ -0,0 +1,48 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "pool.h"
+#include "tile_grid.h"
+#include "utils.h"
+
+#define SECTOR_SHIFT 4 // the robot's memory is split into sectors of 16 by 16 tiles
+#define SECTOR_SIZE (1 << SECTOR_SHIFT)
+#define MAX_ENTRANCE_NODES (2*SECTOR_SIZE) // at most one per two tiles along each side
+#define MAX_SECTOR_NODES (MAX_ENTRANCE_NODES + 2) // with room for the start and goal of a query
+#define HIERARCHY_MIN_DISTANCE (2*SECTOR_SIZE) // routes shorter than this (ignoring obstacles) are searched tile by tile
+
+// a graph over the robot's memory for long routes (HPA*): each sector has nodes on the tiles where it can be crossed into its neighbours, joined by the shortest distances within the sector, so a route is searched sector by sector and only then filled in tile by tile
+typedef struct Hierarchy {
+    int width;
+    int height;
+    int sectorsWide;
+    int sectorsHigh;
+    int numSectors;
+    Coord *nodes; // tile of each node, indexed sector*MAX_SECTOR_NODES + slot
+    unsigned char *nodeSide; // the Direction each entrance node crosses out of its sector in
+    int *numNodes; // entrance nodes in each sector, while the start and goal are only added during a query
+    unsigned short *dist; // moves between each pair of nodes of a sector without leaving it, MAX_SECTOR_NODES*MAX_SECTOR_NODES per sector
+    unsigned char *dirty; // 1 for sectors whose nodes and distances are out of date, worked out again only once a route is searched into them
+    int *cost; // abstract search: cost from the start to each node
+    int *parent;
+    int *searchMark; // equal to searchId where cost and parent are valid for the current search
+    int searchId;
+    long long *heap; // open set as a binary min-heap of (priority << 32 | node)
+    int heapSize;
+    int heapCapacity;
+    int *localDist; // breadth first search within one sector, SECTOR_SIZE*SECTOR_SIZE
+    int *localParent;
+    int *queue;
+    unsigned char *localOpen; // 1 for each passable tile of loadedSector, copied from memory so searches within it are quick
+    int loadedSector; // -1 if none
+    int *abstractRoute; // nodes of the last abstract route, start to goal
+    long long rebuiltSectors; // sectors whose nodes have been worked out so far
+    int expansions; // nodes taken off the open set by the last search
+} Hierarchy;
+
+size_t hierarchy_pool_size(int, int);
+Hierarchy* create_hierarchy(Pool*, int, int);
+void hierarchy_tile_changed(Hierarchy*, int, int);
+Status hierarchical_route(Hierarchy*, const TileGrid*, Coord, Coord, Coord*, size_t, int*);
+
+#endif
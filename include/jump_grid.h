@@ -0,0 +1,31 @@
+#ifndef JUMP_GRID_H
+#define JUMP_GRID_H
+
+#include "pool.h"
+#include "tile_grid.h"
+#include "utils.h"
+
+#include <stdint.h>
+
+// the tiles the robot knows are blocked, one bit each packed 64 to a word along each row, so jump point search can scan a whole word of a row at once; rows are padded with blocked tiles past the right edge, and with a blocked row above and below the arena
+typedef struct JumpGrid {
+    int width;
+    int height;
+    int wordsPerRow;
+    uint64_t *blocked; // row y starts at (y + 1)*wordsPerRow
+} JumpGrid;
+
+size_t jump_grid_pool_size(int, int);
+JumpGrid* create_jump_grid(Pool*, int, int);
+void load_jump_grid(JumpGrid*, const TileGrid*);
+void jump_grid_set_blocked(JumpGrid*, int, int, int);
+int jump_grid_scan(const JumpGrid*, int, int, int);
+
+// this function checks if a tile is blocked, counting everything outside the arena as blocked
+static inline int jump_grid_blocked(const JumpGrid *grid, int x, int y)
+{
+    if (x < 0 || x >= grid->width || y < 0 || y >= grid->height) return 1;
+    return (grid->blocked[(size_t)(y + 1)*grid->wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef PATHFIND_H
+#define PATHFIND_H
+
+#include "dstar.h"
+#include "hierarchy.h"
+#include "jump_grid.h"
+#include "pool.h"
+#include "robot.h"
+#include "tile_grid.h"
+#include "utils.h"
+
+// workspace for route searches over a robot's memory plus the last route found; tiles are indexed y*width + x, and (tile, direction) states tile*4 + direction
+typedef struct Planner {
+    int width;
+    int height;
+    int turnAware; // 1 to search over (tile, direction) so routes cost turns as well as moves, 0 to count moves only
+    int moveCost; // cost of a forward move in a turn aware search
+    int turnCost; // cost of a 90 degree turn in a turn aware search
+    int *cost; // cost from the start to each tile (or state) in the current search
+    int *parent; // index of the tile (or state) each was reached from
+    int *searchMark; // equal to searchId where cost and parent are valid for the current search, so nothing needs clearing between searches
+    int searchId;
+    long long *heap; // open set as a binary min-heap of (priority << 32 | tile index)
+    int heapSize;
+    int heapCapacity;
+    Coord *route; // tiles to move through in order, not including the start
+    int routeLength;
+    int routeNext; // index in route of the next tile to move onto
+    Coord routeGoal;
+    int expansions; // tiles taken off the open set by the last search (nodes for a route through the hierarchy)
+    Hierarchy *hierarchy; // used for long routes when not turn aware, NULL to always search tile by tile
+    JumpGrid *jumpGrid; // used for routes to a tile when not turn aware (and not long enough for the hierarchy), NULL to expand every tile
+    DStar *dstar; // used for every route to a tile when not turn aware, so a route to the same goal is repaired as tiles change rather than searched again, NULL to search afresh each time
+} Planner;
+
+size_t planner_pool_size(int, int);
+Planner* create_planner(Pool*, int, int);
+
+// searches treat every in bounds tile not known to be blocked as passable, so a failed search means the goal cannot be reached
+Status plan_route_to_tile(Planner*, const TileGrid*, Coord, Direction, Coord);
+Status plan_route_to_unknown(Planner*, const TileGrid*, Coord, Direction);
+Status plan_route_over_known(Planner*, const TileGrid*, Coord, Coord);
+
+void planner_tile_blocked(Planner*, int, int);
+void planner_tile_opened(Planner*, int, int);
+
+int route_finished(Planner*);
+Coord next_route_tile(Planner*);
+void advance_route(Planner*);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// bump allocator: every allocation is carved from one block and they are all released together by resetting it
+typedef struct {
+    unsigned char *block;
+    size_t capacity;
+    size_t used;
+} Pool;
+
+Pool* create_pool(size_t);
+void* pool_alloc(Pool*, size_t);
+size_t pool_aligned_size(size_t);
+void pool_reset(Pool*);
+void free_pool(Pool*);
+
+#endif
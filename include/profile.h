@@ -0,0 +1,31 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+// the phases of a run that can be timed
+typedef enum {
+    PF_GENERATE_OBSTACLES = 0,
+    PF_GENERATE_MARKERS = 1,
+    PF_PLACE_ROBOT = 2,
+    PF_DRAW_BACKGROUND = 3,
+    PF_REACH_START_STEP = 4,
+    PF_SPIRAL_STEP = 5,
+    PF_BACKTRACK_STEP = 6,
+    PF_MOVE_TO_UNKNOWN_STEP = 7,
+    PF_ROUTE_STEP = 8, // following a planned route or tour, including planning it
+    PF_DRAW_FOREGROUND = 9,
+    PF_SENSE_MARKERS = 10, // looking for markers in range and planning a route to one
+    PF_OBSTACLE_EVENTS = 11, // applying scripted obstacle changes and sensing the tiles around the robot
+    PF_DELIVER = 12, // planning a route back to the depot, or dropping off markers there
+    PF_NUM_PHASES = 13
+} ProfilePhase;
+
+// time a phase with: long long start = profile_start(); ... profile_stop(PF_..., start);
+void profile_enable(int);
+long long profile_start(void);
+void profile_stop(ProfilePhase, long long);
+void reset_profile(void);
+void print_profile(FILE*);
+
+#endif
@@ -2,14 +2,40 @@
 #define ROBOT_H
 
 #include "arena.h"
+#include "tile_grid.h"
 #include "utils.h"
 
+#include <stdint.h>
+
 typedef enum {
     R_UNKNOWN = 0,
     R_VISITED = 1,
     R_BLOCKED = 2
 } RobotTile;
 
+// states of the spiral algorithm, stored in the robot so it can be advanced one action at a time
+typedef enum {
+    SP_REACH_START = 0,
+    SP_SPIRAL = 1,
+    SP_BACKTRACK = 2,
+    SP_MOVE_TO_UNKNOWN = 3,
+    SP_DONE = 4,
+    SP_FOLLOW_ROUTE = 5,
+    SP_TOUR = 6 // heading for each marker of a planned tour in turn rather than spiralling
+} SpiralState;
+
+// what a planned route in SP_FOLLOW_ROUTE leads to, which decides how to replan if it is blocked and what to do at its end
+typedef enum {
+    RT_MARKER = 0, // a sensed marker, then back to the spiral
+    RT_PATH_TILE = 1, // a tile on the path stack that is not adjacent, then carry on backtracking
+    RT_UNKNOWN = 2, // the nearest unknown tile once backtracking has reached the start, then back to the spiral
+    RT_TOUR_STOP = 3, // the next marker of a planned tour, then on to the one after
+    RT_DEPOT = 4 // the depot, to drop off the markers being carried, then back to the spiral or the tour
+} RouteKind;
+
+struct Planner; // defined in pathfind.h
+struct Tour; // defined in tour.h
+
 typedef struct {
     int x;
     int y;
@@ -17,8 +43,25 @@ typedef struct {
     int markerCount;
     int arenaWidth;
     int arenaHeight;  
-    RobotTile **memory;
+    TileGrid memory; // RobotTile of each tile, through get_tile and set_tile
+    int knownTiles; // number of tiles in memory that are not R_UNKNOWN
+    TileGrid visitCounts; // times the robot has moved onto each tile, saturating at UINT16_MAX rather than wrapping
     Stack *path;
+    SpiralState spiralState;
+    Coord spiralTarget; // adjacent tile being turned towards in SP_BACKTRACK or SP_MOVE_TO_UNKNOWN, {-1, -1} if none
+    struct Planner *planner; // used for routes in SP_FOLLOW_ROUTE, NULL for the pure spiral
+    RouteKind routeKind;
+    struct Tour *tour; // order to visit the markers in when they are known up front, NULL to search for them
+    int senseRadius; // markers within this many tiles (straight line) are sensed and moved to directly, 0 to turn off
+    int changesSeen; // the arena's count of changed tiles when the robot last forgot its blocked tiles
+    Coord unreachableMarker; // a sensed marker the robot could not route to, not tried again until the arena changes; {-1, -1} if none
+    int unreachableChanges; // the arena's count of changed tiles when unreachableMarker was given up on
+    int carryCapacity; // markers the robot carries before taking them back to the arena's depot, 0 to keep every marker it picks up
+    int trips; // times the robot has dropped off markers at the depot
+    SpiralState resumeState; // state the robot broke off from to head for the depot
+    int moveCount; // number of forward moves made
+    int turnCount; // number of turns made
+    int render; // 1 if each action should be drawn to the drawapp, 0 to run headless
 } Robot;
 
 // functions to move the robot, sense its environemtn and deal with its memory of the arena
@@ -29,8 +72,9 @@ void turn_right(Robot*);
 int is_at_marker(Robot*, Arena*);
 int can_move_forward(Robot*, Arena*);
 void pickup_marker(Robot*, Arena*);
-void drop_marker(Robot*, Arena*);
+Status drop_marker(Robot*, Arena*);
 int get_marker_carry_count(Robot*);
+int can_carry_marker(Robot*);
 int get_marker_arena_count(Arena*);
 int check_forward_tile_unknown(Robot*);
 int check_left_tile_unknown(Robot*);
@@ -38,19 +82,26 @@ void mark_current_tile_visited(Robot*);
 void mark_ahead_tile_obstacle(Robot*);
 int is_surrounded_by_known(Robot*);
 Coord adjacent_unvisited_tile(Robot*);
-int num_unknown_tiles(Robot*);
+long long num_unknown_tiles(Robot*);
+Coord sense_marker(Robot*, Arena*);
+void learn_arena_obstacles(Robot*, Arena*);
+void sense_adjacent_tiles(Robot*, Arena*);
+void forget_blocked_tiles(Robot*);
+void forget_current_tile(Robot*);
 
 // functions dealing with robot struct
-Robot* create_robot(Arena*);
-void free_robot(Robot*);
-void place_robot(int, char**, Robot*, Arena*);
+size_t robot_pool_size(int, int, GridLayout);
+Robot* create_robot(Pool*, Arena*);
+void release_robot(Robot*);
+Status place_robot(Robot*, Arena*, Coord, Direction);
+
+// functions for reading the robot's start from the command line
+Direction parse_direction(const char*);
+void determine_robot_start(int, char**, Coord*, Direction*);
 
 // functions for dealing with robot's path stack
-void setup_path_stack(Robot*);
-void push_pos_to_path(Robot*);
+Status setup_path_stack(Robot*);
+Status push_pos_to_path(Robot*);
 Coord backtrack_path_tile(Robot*);
 
-// main algorithm to find markers
-void find_markers(Robot*, Arena*);
-
 #endif
\ No newline at end of file
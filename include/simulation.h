@@ -0,0 +1,59 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "arena.h"
+#include "drawing.h"
+#include "pool.h"
+#include "robot.h"
+#include "utils.h"
+
+// everything needed to set up one simulation; fill with default_sim_config() then override fields
+typedef struct {
+    int arenaWidth;
+    int arenaHeight;
+    ObstacleFormation obstacleFormation;
+    int numObstacles;
+    MarkerFormation markerFormation;
+    int numMarkers;
+    unsigned int seed;
+    Coord start; // {-1, -1} for a random start position
+    Direction startDirection; // -1 for a random start direction
+    int senseRadius; // markers within this many tiles are sensed and routed to directly, 0 for the pure spiral
+    int turnAwareRoutes; // 1 to plan routes that cost turns as well as moves and to backtrack by routing to the quickest unknown tile
+    int routeMoveCost; // cost of a forward move when turnAwareRoutes is set
+    int routeTurnCost; // cost of a 90 degree turn when turnAwareRoutes is set
+    int hierarchicalRoutes; // 1 to find long routes through a graph of 16x16 sectors (HPA*) rather than tile by tile, when routes are planned and not turn aware
+    int jumpPointRoutes; // 1 to find routes to a tile with jump point search rather than A* over every tile, when routes are planned and not turn aware
+    int incrementalRoutes; // 1 to find routes to a tile with an incremental search (D* Lite) that is repaired as tiles change, when routes are planned and not turn aware
+    const ObstacleEvent *obstacleEvents; // changes to the arena during the search in order of step, which must outlive the simulation; NULL for none
+    int numObstacleEvents;
+    int knownArena; // 1 to give the robot the obstacles and markers up front so it follows the shortest tour instead of searching
+    int carryCapacity; // markers the robot carries before taking them back to the depot, 0 to keep every marker it picks up
+    Coord depot; // tile markers are taken back to when carryCapacity is set, {-1, -1} for the robot's start
+    GridLayout gridLayout; // G_SPARSE to store the arena and robot's memory in chunks allocated as they are used, for huge arenas that are mostly empty; G_TILED or G_MORTON to store them in blocks
+    int render; // 1 to draw to the drawapp through stdout, 0 to run headless
+    DrawConfig draw; // tile size and animation timing, only used when rendering
+} SimConfig;
+
+typedef struct {
+    SimConfig config;
+    Pool *pool; // holds the arena, robot and path stack (apart from sparse chunks and a growing stack), reused by sim_reset
+    Arena *arena;
+    Robot *robot;
+    ObstacleEvent *ownedEvents; // copy of the obstacle events restored from a snapshot, freed with the simulation; NULL otherwise
+    Status status; // S_OK while running, S_DONE once all markers are found (and delivered, with a carrying capacity), otherwise the error that stopped it
+} Simulation;
+
+struct Snapshot; // defined in snapshot.h
+
+void default_sim_config(SimConfig*);
+
+// functions to create, advance and free a simulation
+Status sim_create(const SimConfig*, Simulation**);
+Status sim_reset(Simulation*, const SimConfig*);
+Status sim_restore(const struct Snapshot*, const DrawConfig*, Simulation**);
+Status sim_step(Simulation*);
+Status sim_run(Simulation*);
+void sim_destroy(Simulation*);
+
+#endif
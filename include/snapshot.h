@@ -0,0 +1,29 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "arena.h"
+#include "simulation.h"
+#include "utils.h"
+
+#include <stddef.h>
+
+#define SNAPSHOT_VERSION 2 // raised whenever the format changes, so older snapshots are refused rather than misread
+
+// the whole state of a simulation part way through, packed into bytes so it can be written to a file and restored later, any number of times
+typedef struct Snapshot {
+    unsigned char *data; // from malloc, grown as it is written; NULL while empty
+    size_t size;
+    size_t capacity;
+} Snapshot;
+
+// functions to take and read snapshots
+Status take_snapshot(const Simulation*, Snapshot*);
+Status read_snapshot_config(const Snapshot*, SimConfig*, ObstacleEvent**);
+Status restore_snapshot_state(Simulation*, const Snapshot*);
+void free_snapshot(Snapshot*);
+
+// functions to keep snapshots in files
+Status save_snapshot(const Snapshot*, const char*);
+Status load_snapshot(const char*, Snapshot*);
+
+#endif
@@ -4,6 +4,8 @@
 #include "robot.h"
 #include "arena.h"
 
-void spiral_algorithm(Robot*, Arena*);
+// main algorithm to find markers, either run to completion or one action at a time
+Status spiral_step_once(Robot*, Arena*);
+Status find_markers(Robot*, Arena*);
 
-#endif
\ No newline at end of file
+#endif
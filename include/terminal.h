@@ -0,0 +1,15 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include "arena.h"
+#include "robot.h"
+
+#define TERMINAL_MAX_ARENA_SIZE 1000 // the arena is not limited by a window in the terminal, only by this
+
+// drawing the simulation in a terminal with ANSI escape codes instead of for the drawapp
+void terminal_draw_background(Arena*);
+void terminal_draw_foreground(Robot*, Arena*);
+void terminal_sleep(int);
+void terminal_finish(void);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+
+#include "pool.h"
+#include "utils.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_SHIFT 6 // sparse grids are split into chunks of 64 by 64 tiles
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define TILED_BLOCK_SHIFT 3 // tiled grids store 8 by 8 blocks of tiles together, one cache line for a byte grid
+#define MORTON_BLOCK_SHIFT 6 // morton grids store 64 by 64 blocks of tiles together, each in Z-order
+#define CACHE_LINE_SIZE 64
+
+// how a tile grid stores its tiles
+typedef enum {
+    G_DENSE = 0, // one block from the pool holding every tile
+    G_SPARSE = 1, // a directory of chunks, each allocated the first time a tile in it is set to something other than 0
+    G_TILED = 2, // one block holding every tile, stored in 8 by 8 blocks so the tiles above and below are usually in the same cache line
+    G_MORTON = 3 // one block holding every tile, stored in 64 by 64 blocks with the tiles of each in Z-order (x and y bits interleaved)
+} GridLayout;
+
+// a width by height grid of small values that all start at 0; read and written through get_tile and set_tile so the layout can change without the callers knowing
+typedef struct {
+    int width;
+    int height;
+    int cellSize; // bytes per tile, 1 or 2
+    GridLayout layout;
+    unsigned char *cells; // G_DENSE: every tile, indexed y*width + x; G_TILED and G_MORTON: every tile, block by block
+    unsigned char **chunks; // G_SPARSE: chunksWide*chunksHigh chunks, NULL where nothing has been set
+    int chunksWide;
+    int chunksHigh;
+    int blockShift; // G_TILED and G_MORTON: log2 of the width of a block
+    int blocksWide; // G_TILED and G_MORTON: blocks across the padded width
+    size_t numChunks; // chunks allocated so far
+    int failed; // 1 once a chunk could not be allocated, so a write has been lost
+} TileGrid;
+
+size_t tile_grid_pool_size(int, int, int, GridLayout);
+Status create_tile_grid(TileGrid*, Pool*, int, int, int, GridLayout);
+void release_tile_grid(TileGrid*);
+size_t tile_grid_bytes(const TileGrid*);
+void set_sparse_tile(TileGrid*, int, int, unsigned int);
+int is_chunk_empty(const TileGrid*, int, int);
+const char* grid_layout_name(GridLayout);
+int parse_grid_layout(const char*, GridLayout*);
+
+#ifdef TILE_GRID_TRACE
+void tile_grid_trace(const void*); // called with the address of every tile read or written, so a benchmark can model the cache
+#define TRACE_TILE(address) tile_grid_trace(address)
+#else
+#define TRACE_TILE(address)
+#endif
+
+// this function spreads the low 8 bits of v out to the even bits, so interleaving x and y gives a Z-order index
+static inline unsigned int spread_bits(unsigned int v)
+{
+    v = (v | (v << 4)) & 0x0F0F;
+    v = (v | (v << 2)) & 0x3333;
+    return (v | (v << 1)) & 0x5555;
+}
+
+// this function returns where tile (x, y) is in the cells of a grid that holds every tile (not G_SPARSE)
+static inline size_t tile_index(const TileGrid *grid, int x, int y)
+{
+    if (grid->layout == G_DENSE) return (size_t)y*grid->width + x;
+
+    int shift = grid->blockShift;
+    int mask = (1 << shift) - 1;
+    size_t block = (size_t)(y >> shift)*grid->blocksWide + (x >> shift);
+    unsigned int offset = grid->layout == G_TILED ? (unsigned int)(((y & mask) << shift) | (x & mask)) : spread_bits(x & mask) | (spread_bits(y & mask) << 1);
+    return (block << (2*shift)) + offset;
+}
+
+// this function returns the value of tile (x, y); pre-requisite: (x, y) is in bounds
+static inline unsigned int get_tile(const TileGrid *grid, int x, int y)
+{
+    const unsigned char *cells = grid->cells;
+    size_t i;
+    if (grid->layout == G_SPARSE) {
+        cells = grid->chunks[(y >> CHUNK_SHIFT)*grid->chunksWide + (x >> CHUNK_SHIFT)];
+        if (cells == NULL) return 0;
+        i = (y & (CHUNK_SIZE - 1))*CHUNK_SIZE + (x & (CHUNK_SIZE - 1));
+    }
+    else {
+        i = tile_index(grid, x, y);
+    }
+    TRACE_TILE(cells + i*grid->cellSize);
+    return grid->cellSize == 1 ? cells[i] : ((const uint16_t *)cells)[i];
+}
+
+// this function sets tile (x, y) to value, which must fit in the grid's cell size; pre-requisite: (x, y) is in bounds
+static inline void set_tile(TileGrid *grid, int x, int y, unsigned int value)
+{
+    if (grid->layout == G_SPARSE) {
+        set_sparse_tile(grid, x, y, value);
+        return;
+    }
+    size_t i = tile_index(grid, x, y);
+    TRACE_TILE(grid->cells + i*grid->cellSize);
+    if (grid->cellSize == 1) grid->cells[i] = value;
+    else ((uint16_t *)grid->cells)[i] = value;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include "arena.h"
+#include "pool.h"
+#include "utils.h"
+
+// an order to visit every marker in when their positions and the obstacles are known up front; stop 0 is the robot's start and stops 1 onwards are the markers
+typedef struct Tour {
+    int width;
+    int height;
+    int maxMarkers;
+    int numMarkers;
+    Coord *stops;
+    int *order; // stop indices in visiting order, order[0] is always the start
+    int next; // index in order of the next stop to head for
+    int *dist; // moves between each pair of stops, (maxMarkers + 1) squared
+    int length; // total moves of the planned tour
+    int *stopAt; // stop index on each tile, -1 if none; tiles are indexed y*width + x
+    int *bfsDist; // moves from the current search's source to each tile, -1 if not reached
+    int *queue;
+    int *heldKarp; // shortest cost over (set of markers visited, last marker) for the exact order
+    unsigned char *heldKarpParent;
+} Tour;
+
+size_t tour_pool_size(int, int, int);
+Tour* create_tour(Pool*, int, int, int);
+
+Status plan_marker_tour(Tour*, Arena*, Coord);
+Coord next_tour_stop(Tour*, Arena*);
+
+#endif
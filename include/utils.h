@@ -1,6 +1,8 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "pool.h"
+
 typedef struct {
     double x;
     double y;
@@ -18,8 +20,29 @@ typedef enum {
     WEST = 3
 } Direction;
 
-Direction random_direction();
-int random_coord(int);
+// status codes returned by functions that can fail, so callers decide how to handle errors instead of the program exiting
+typedef enum {
+    S_OK = 0,
+    S_DONE = 1,
+    S_ERR_ALLOC = -1,
+    S_ERR_CONFIG = -2,
+    S_ERR_UNREACHABLE = -3,
+    S_ERR_STACK = -4,
+    S_ERR_INTERNAL = -5,
+    S_ERR_IO = -6
+} Status;
+
+const char* status_string(Status);
+
+// random number generator state, kept per arena so that simulations do not share the global rand() state
+typedef struct {
+    unsigned int state;
+} Rng;
+
+void seed_rng(Rng*, unsigned int);
+unsigned int next_random(Rng*);
+Direction random_direction(Rng*);
+int random_coord(Rng*, int);
 int min(int, int);
 int max(int, int);
 int check_coord_in_bounds(Coord, int, int);
@@ -31,12 +54,17 @@ typedef struct {
     int top;
     unsigned int capacity;
     Coord *array;
+    int growable; // 1 if array is from malloc and doubles when full, rather than a fixed block from the pool
 } Stack;
 
-Stack* create_stack(unsigned int capacity);
-void push(Stack*, Coord);
+size_t stack_pool_size(unsigned int capacity);
+Stack* create_stack(Pool*, unsigned int capacity);
+Stack* create_growing_stack(Pool*, unsigned int capacity);
+void release_stack(Stack*);
+Status push(Stack*, Coord);
 Coord pop(Stack*);
 Coord peek(Stack*);
-void free_stack(Stack*);
+int stack_size(Stack*);
+void clear_stack(Stack*);
 
 #endif
\ No newline at end of file
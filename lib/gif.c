@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gif.h"
+#include "raster.h"
+
+#define GIF_MAX_CODES 4096
+#define GIF_HASH_SIZE 5003 // prime a bit larger than GIF_MAX_CODES
+#define GIF_MIN_CODE_SIZE 8
+
+// the palette is the drawapp's named colours then a 6x6x6 colour cube for anything set with RG
+static const unsigned char namedColours[][3] =
+{
+  {0, 0, 0}, {0, 0, 255}, {0, 255, 255}, {64, 64, 64}, {128, 128, 128}, {0, 255, 0}, {192, 192, 192},
+  {255, 0, 255}, {255, 200, 0}, {255, 175, 175}, {255, 0, 0}, {255, 255, 255}, {255, 255, 0}
+};
+#define GIF_NUM_NAMED (int)(sizeof(namedColours) / sizeof(namedColours[0]))
+
+typedef struct
+{
+  FILE* file;
+  int width;
+  int height;
+  unsigned char* previous; // palette indices of the last frame that differed from the one before it, not yet written
+  unsigned char* latest; // palette indices of the newest frame
+  RasterRect pendingRect; // part of previous that changed from the frame before it
+  unsigned char* drawnBlocks; // raster blocks combined again for the newest frame
+  unsigned char* changedBlocks; // raster blocks where latest may differ from previous
+  long pendingDelay; // miliseconds previous stays on screen, including any identical frames after it
+  int hasPending;
+  long lastSlept;
+  long framesSkipped;
+  long framesWritten;
+  // LZW encoder state
+  int hashCodes[GIF_HASH_SIZE];
+  int hashKeys[GIF_HASH_SIZE];
+  unsigned char block[256];
+  int blockLength;
+  unsigned long bits;
+  int numBits;
+} GifWriter;
+
+// palette
+
+static unsigned char cubeLevel(int value)
+{
+  return (unsigned char)((value + 25) / 51); // nearest of 0, 51, ..., 255
+}
+
+static unsigned char paletteIndex(const unsigned char* rgb)
+{
+  for (int i = 0; i < GIF_NUM_NAMED; i++)
+  {
+    if (memcmp(rgb, namedColours[i], 3) == 0) return i;
+  }
+  return GIF_NUM_NAMED + cubeLevel(rgb[0]) * 36 + cubeLevel(rgb[1]) * 6 + cubeLevel(rgb[2]);
+}
+
+static void writePalette(FILE* file)
+{
+  unsigned char palette[256 * 3];
+  memset(palette, 0, sizeof(palette));
+  memcpy(palette, namedColours, sizeof(namedColours));
+  for (int i = 0; i < 216; i++)
+  {
+    palette[(GIF_NUM_NAMED + i) * 3] = (i / 36) * 51;
+    palette[(GIF_NUM_NAMED + i) * 3 + 1] = (i / 6 % 6) * 51;
+    palette[(GIF_NUM_NAMED + i) * 3 + 2] = (i % 6) * 51;
+  }
+  fwrite(palette, 1, sizeof(palette), file);
+}
+
+// writing
+
+static void writeShort(FILE* file, int value)
+{
+  fputc(value & 0xff, file);
+  fputc((value >> 8) & 0xff, file);
+}
+
+static void writeHeader(GifWriter* gif)
+{
+  fwrite("GIF89a", 1, 6, gif->file);
+  writeShort(gif->file, gif->width);
+  writeShort(gif->file, gif->height);
+  fputc(0xf7, gif->file); // global palette of 256 colours
+  fputc(0, gif->file);
+  fputc(0, gif->file);
+  writePalette(gif->file);
+  // loop forever
+  fwrite("\x21\xff\x0bNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, gif->file);
+}
+
+static void flushBlock(GifWriter* gif)
+{
+  if (gif->blockLength == 0) return;
+  fputc(gif->blockLength, gif->file);
+  fwrite(gif->block, 1, gif->blockLength, gif->file);
+  gif->blockLength = 0;
+}
+
+static void writeCode(GifWriter* gif, int code, int codeSize)
+{
+  gif->bits |= (unsigned long)code << gif->numBits;
+  gif->numBits += codeSize;
+  while (gif->numBits >= 8)
+  {
+    gif->block[gif->blockLength++] = gif->bits & 0xff;
+    if (gif->blockLength == 255) flushBlock(gif);
+    gif->bits >>= 8;
+    gif->numBits -= 8;
+  }
+}
+
+// compresses the rectangle of palette indices with GIF's variable width LZW
+static void writeImageData(GifWriter* gif, const unsigned char* indices, RasterRect rect)
+{
+  int clearCode = 1 << GIF_MIN_CODE_SIZE;
+  int endCode = clearCode + 1;
+  int nextCode = clearCode + 2;
+  int codeSize = GIF_MIN_CODE_SIZE + 1;
+  for (int i = 0; i < GIF_HASH_SIZE; i++) gif->hashKeys[i] = -1;
+  gif->blockLength = 0;
+  gif->bits = 0;
+  gif->numBits = 0;
+
+  fputc(GIF_MIN_CODE_SIZE, gif->file);
+  writeCode(gif, clearCode, codeSize);
+  int prefix = -1;
+  for (int y = rect.top; y < rect.bottom; y++)
+  {
+    const unsigned char* row = indices + (size_t)y * gif->width;
+    for (int x = rect.left; x < rect.right; x++)
+    {
+      int pixel = row[x];
+      if (prefix < 0)
+      {
+        prefix = pixel;
+        continue;
+      }
+
+      // follow the string already in the table if there is one
+      int key = (prefix << 8) | pixel;
+      int slot = key % GIF_HASH_SIZE;
+      while (gif->hashKeys[slot] != -1 && gif->hashKeys[slot] != key) slot = (slot + 1) % GIF_HASH_SIZE;
+      if (gif->hashKeys[slot] == key)
+      {
+        prefix = gif->hashCodes[slot];
+        continue;
+      }
+
+      writeCode(gif, prefix, codeSize);
+      if (nextCode < GIF_MAX_CODES)
+      {
+        if (nextCode == (1 << codeSize)) codeSize++;
+        gif->hashKeys[slot] = key;
+        gif->hashCodes[slot] = nextCode++;
+      }
+      else
+      {
+        // the table is full, so start it again
+        writeCode(gif, clearCode, codeSize);
+        for (int i = 0; i < GIF_HASH_SIZE; i++) gif->hashKeys[i] = -1;
+        nextCode = clearCode + 2;
+        codeSize = GIF_MIN_CODE_SIZE + 1;
+      }
+      prefix = pixel;
+    }
+  }
+  if (prefix >= 0) writeCode(gif, prefix, codeSize);
+  writeCode(gif, endCode, codeSize);
+  if (gif->numBits > 0) writeCode(gif, 0, 8 - gif->numBits);
+  flushBlock(gif);
+  fputc(0, gif->file);
+}
+
+static void writePendingFrame(GifWriter* gif)
+{
+  if (!gif->hasPending) return;
+  RasterRect rect = gif->pendingRect;
+  int delay = (gif->pendingDelay + 5) / 10; // GIF delays are in hundredths of a second
+
+  // graphic control: leave the frame in place for the next to draw over
+  fwrite("\x21\xf9\x04\x04", 1, 4, gif->file);
+  writeShort(gif->file, delay);
+  fputc(0, gif->file);
+  fputc(0, gif->file);
+
+  fputc(0x2c, gif->file);
+  writeShort(gif->file, rect.left);
+  writeShort(gif->file, rect.top);
+  writeShort(gif->file, rect.right - rect.left);
+  writeShort(gif->file, rect.bottom - rect.top);
+  fputc(0, gif->file);
+  writeImageData(gif, gif->previous, rect);
+  gif->hasPending = 0;
+  gif->framesWritten++;
+}
+
+// the smallest rectangle holding every pixel that differs between previous and latest, only looking in the changed blocks; empty if they are the same
+static RasterRect changedRect(const GifWriter* gif, const Raster* raster)
+{
+  RasterRect rect = {gif->width, gif->height, 0, 0};
+  for (int block = 0; block < raster->blocksWide * raster->blocksHigh; block++)
+  {
+    if (!gif->changedBlocks[block]) continue;
+    RasterRect area = rasterBlockRect(raster, block);
+    for (int y = area.top; y < area.bottom; y++)
+    {
+      const unsigned char* before = gif->previous + (size_t)y * gif->width;
+      const unsigned char* after = gif->latest + (size_t)y * gif->width;
+      if (memcmp(before + area.left, after + area.left, area.right - area.left) == 0) continue;
+
+      int left = area.left;
+      while (before[left] == after[left]) left++;
+      int right = area.right;
+      while (before[right - 1] == after[right - 1]) right--;
+      if (left < rect.left) rect.left = left;
+      if (right > rect.right) rect.right = right;
+      if (y < rect.top) rect.top = y;
+      if (y + 1 > rect.bottom) rect.bottom = y + 1;
+    }
+  }
+  return rect;
+}
+
+static void gifFrame(void* state, Raster* raster, int frame)
+{
+  GifWriter* gif = (GifWriter*)state;
+  if (gif->file == NULL) return;
+  if (frame == 0)
+  {
+    // the GIF is sized by the first frame; the simulation only sets the window size once
+    size_t numPixels = (size_t)raster->width * raster->height;
+    gif->width = raster->width;
+    gif->height = raster->height;
+    gif->previous = (unsigned char*)malloc(numPixels);
+    gif->latest = (unsigned char*)malloc(numPixels);
+    gif->drawnBlocks = (unsigned char*)malloc(raster->blocksWide * raster->blocksHigh);
+    gif->changedBlocks = (unsigned char*)calloc(raster->blocksWide * raster->blocksHigh, 1);
+    if (gif->previous == NULL || gif->latest == NULL || gif->drawnBlocks == NULL || gif->changedBlocks == NULL)
+    {
+      fprintf(stderr, "Could not allocate GIF frames\n");
+      fclose(gif->file);
+      gif->file = NULL;
+      return;
+    }
+    writeHeader(gif);
+  }
+  if (raster->width != gif->width || raster->height != gif->height) return;
+
+  // only the blocks drawn on since the last frame need converting to the palette
+  int numBlocks = raster->blocksWide * raster->blocksHigh;
+  memset(gif->drawnBlocks, 0, numBlocks);
+  const unsigned char* pixels = rasterPixels(raster, gif->drawnBlocks);
+  const unsigned char* lastRgb = NULL;
+  unsigned char lastIndex = 0;
+  for (int block = 0; block < numBlocks; block++)
+  {
+    if (!gif->drawnBlocks[block]) continue;
+    gif->changedBlocks[block] = 1;
+    RasterRect area = rasterBlockRect(raster, block);
+    for (int y = area.top; y < area.bottom; y++)
+    {
+      for (int x = area.left; x < area.right; x++)
+      {
+        size_t i = (size_t)y * gif->width + x;
+        const unsigned char* rgb = pixels + i * 3;
+        if (lastRgb == NULL || memcmp(rgb, lastRgb, 3) != 0)
+        {
+          lastIndex = paletteIndex(rgb);
+          lastRgb = rgb;
+        }
+        gif->latest[i] = lastIndex;
+      }
+    }
+  }
+
+  long delay = raster->slept - gif->lastSlept;
+  gif->lastSlept = raster->slept;
+  RasterRect rect = {0, 0, gif->width, gif->height};
+  if (frame > 0)
+  {
+    rect = changedRect(gif, raster);
+    if (rect.right <= rect.left)
+    {
+      // nothing changed, so the last frame just stays up for longer
+      gif->pendingDelay += delay;
+      gif->framesSkipped++;
+      return;
+    }
+  }
+
+  writePendingFrame(gif);
+  for (int block = 0; block < numBlocks; block++)
+  {
+    if (!gif->changedBlocks[block]) continue;
+    RasterRect area = rasterBlockRect(raster, block);
+    for (int y = area.top; y < area.bottom; y++)
+    {
+      size_t start = (size_t)y * gif->width + area.left;
+      memcpy(gif->previous + start, gif->latest + start, area.right - area.left);
+    }
+    gif->changedBlocks[block] = 0;
+  }
+  gif->pendingRect = rect;
+  gif->pendingDelay = delay;
+  gif->hasPending = 1;
+}
+
+static void gifFinish(void* state, Raster* raster)
+{
+  GifWriter* gif = (GifWriter*)state;
+  if (gif->file != NULL)
+  {
+    gif->pendingDelay += raster->slept - gif->lastSlept;
+    writePendingFrame(gif);
+    fputc(0x3b, gif->file);
+    fclose(gif->file);
+    fprintf(stderr, "Wrote %ld GIF frames, skipping %ld unchanged\n", gif->framesWritten, gif->framesSkipped);
+  }
+  free(gif->previous);
+  free(gif->latest);
+  free(gif->drawnBlocks);
+  free(gif->changedBlocks);
+  free(gif);
+}
+
+OutputSink* openGifSink(const char* path)
+{
+  GifWriter* gif = (GifWriter*)calloc(1, sizeof(GifWriter));
+  if (gif == NULL) return NULL;
+  gif->file = fopen(path, "wb");
+  if (gif->file == NULL)
+  {
+    fprintf(stderr, "Could not open %s to write a GIF\n", path);
+    free(gif);
+    return NULL;
+  }
+  OutputSink* sink = openRasterSink(gifFrame, gifFinish, gif);
+  if (sink == NULL)
+  {
+    fclose(gif->file);
+    free(gif);
+  }
+  return sink;
+}
@@ -0,0 +1,9 @@
+#ifndef GIF_H
+#define GIF_H
+
+#include "output_sink.h"
+
+// a raster sink writing the whole run as an animated GIF to the path; frames identical to the one before are merged into it, and each frame only stores the rectangle that changed
+OutputSink* openGifSink(const char*);
+
+#endif
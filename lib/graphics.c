@@ -1,8 +1,64 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include "graphics.h"
 
+static void (*outputWriter)(const char*, int) = NULL;
+static OutputSink* outputSink = NULL;
+
+void setOutputWriter(void (*writer)(const char*, int))
+{
+  outputWriter = writer;
+}
+
+void setOutputSink(OutputSink* sink)
+{
+  outputSink = sink;
+}
+
+void writeOutput(const char* text, int length)
+{
+  if (outputSink == NULL) fwrite(text, 1, length, stdout);
+  else outputSink->write(outputSink, text, length);
+}
+
+void flushOutput(void)
+{
+  if (outputSink == NULL) fflush(stdout);
+  else outputSink->flush(outputSink);
+}
+
+static void emit(const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  if (outputWriter == NULL && outputSink == NULL)
+  {
+    vprintf(format, args);
+    va_end(args);
+    return;
+  }
+
+  char buffer[1024];
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  void (*write)(const char*, int) = outputWriter != NULL ? outputWriter : writeOutput;
+  if (length < (int)sizeof(buffer))
+  {
+    write(buffer, length);
+    return;
+  }
+
+  char* large = (char*)malloc(length + 1);
+  if (large == NULL) return;
+  va_start(args, format);
+  vsnprintf(large, length + 1, format, args);
+  va_end(args);
+  write(large, length);
+  free(large);
+}
+
 char* replaceNewlineWithEntity(const char* s)
 {
   if (s == NULL) return NULL;
@@ -45,94 +101,94 @@ char* replaceNewlineWithEntity(const char* s)
 
 void setLineWidth(int width)
 {
-  printf("LW %i\n", width);
+  emit("LW %i\n", width);
 }
 
 void drawLine(int x1, int x2, int x3, int x4)
 {
-  printf("DL %i %i %i %i\n", x1, x2, x3, x4);
+  emit("DL %i %i %i %i\n", x1, x2, x3, x4);
 }
 
 void drawRect(int x1, int x2, int x3, int x4)
 {
-  printf("DR %i %i %i %i\n", x1, x2, x3, x4);
+  emit("DR %i %i %i %i\n", x1, x2, x3, x4);
 }
 
 void drawRectRotated(int x, int y, int width, int height, int angle)
 {
-  printf("DT %i %i %i %i %i\n", x, y, width, height, angle);
+  emit("DT %i %i %i %i %i\n", x, y, width, height, angle);
 }
 
 void fillRect(int x1, int x2, int x3, int x4)
 {
-  printf("FR %i %i %i %i\n", x1, x2, x3, x4);
+  emit("FR %i %i %i %i\n", x1, x2, x3, x4);
 }
 
 void fillRectRotated(int x, int y, int width, int height, int angle)
 {
-  printf("FT %i %i %i %i %i\n", x, y, width, height, angle);
+  emit("FT %i %i %i %i %i\n", x, y, width, height, angle);
 }
 
 void drawOval(int x, int y, int width, int height)
 {
-  printf("DO %i %i %i %i\n",x,y,width,height);
+  emit("DO %i %i %i %i\n",x,y,width,height);
 }
 
 void fillOval(int x, int y, int width, int height)
 {
-  printf("FO %i %i %i %i\n",x,y,width,height);
+  emit("FO %i %i %i %i\n",x,y,width,height);
 }
 
 void drawArc(int x, int y, int width, int height, int startAngle, int arcAngle)
 {
-  printf("DA %i %i %i %i %i %i\n",x,y,width,height, startAngle, arcAngle);
+  emit("DA %i %i %i %i %i %i\n",x,y,width,height, startAngle, arcAngle);
 }
 
 void fillArc(int x, int y, int width, int height, int startAngle, int arcAngle)
 {
-  printf("FA %i %i %i %i %i %i\n",x,y,width,height, startAngle, arcAngle);
+  emit("FA %i %i %i %i %i %i\n",x,y,width,height, startAngle, arcAngle);
 }
 
 void drawPolygon(int count, int x[], int y[])
 {
-  printf("DP ");
-  printf("%d ", count);
+  emit("DP ");
+  emit("%d ", count);
   for (int n = 0 ; n < count ; n++)
   {
-    printf("%d %d ", x[n], y[n]);
+    emit("%d %d ", x[n], y[n]);
   }
-  printf("\n");
+  emit("\n");
 }
 
 void fillPolygon(int count, int x[], int y[])
 {
-  printf("FP ");
-  printf("%d ", count);
+  emit("FP ");
+  emit("%d ", count);
   for (int n = 0 ; n < count ; n++)
   {
-    printf("%d %d ", x[n], y[n]);
+    emit("%d %d ", x[n], y[n]);
   }
-  printf("\n");
+  emit("\n");
 }
 
 void drawString(char* s, int x, int y)
 {
-  printf("DS %i %i @%s\n",x,y,s);
+  emit("DS %i %i @%s\n",x,y,s);
 }
 
 void drawStringRotated(char* s, int x, int y, int angle)
 {
-  printf("SR %i %i %i @%s\n",x,y,angle,s);
+  emit("SR %i %i %i @%s\n",x,y,angle,s);
 }
 
 void setStringTextSize(int size)
 {
-  printf("SZ %i\n", size);
+  emit("SZ %i\n", size);
 }
 
 void displayImage(char* fileName, int x, int y)
 {
-  printf("DI %i %i @%s\n", x, y, fileName );
+  emit("DI %i %i @%s\n", x, y, fileName );
 }
 
 void setColour(colour c)
@@ -154,40 +210,40 @@ void setColour(colour c)
     case white : colourName = "white"; break;
     case yellow : colourName = "yellow"; break;
   }
-  printf("SC %s\n", colourName);
+  emit("SC %s\n", colourName);
 }
 
 void setRGBColour(int red, int green, int blue)
 {
-  printf("RG %i %i %i\n", red, green, blue);
+  emit("RG %i %i %i\n", red, green, blue);
 }
 
 void clear(void)
 {
-  printf("CL\n");
+  emit("CL\n");
 }
 
 void setWindowSize(int width, int height)
 {
-  printf("SW %i %i\n", width, height);
+  emit("SW %i %i\n", width, height);
 }
 
 void sleep(int time)
 {
-  printf("SL %i\n", time);
+  emit("SL %i\n", time);
 }
 
 void foreground(void)
 {
-  printf("FG\n");
+  emit("FG\n");
 }
 
 void background(void)
 {
-  printf("BG\n");
+  emit("BG\n");
 }
 
 void message(char *s)
 {
-  printf("MS @%s\n", replaceNewlineWithEntity(s));
+  emit("MS @%s\n", replaceNewlineWithEntity(s));
 }
\ No newline at end of file
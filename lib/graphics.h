@@ -1,3 +1,5 @@
+#include "output_sink.h"
+
 enum colour {black,blue,cyan,darkgray,gray,green,lightgray,magenta,orange,pink,red,white,yellow};
 typedef enum colour colour;
 
@@ -32,3 +34,12 @@ void sleep(int);
 
 void message(char*);
 
+// send everything drawn to writer instead of printing it to stdout, NULL to go back to stdout
+void setOutputWriter(void (*)(const char*, int));
+
+// print to sink instead of stdout, NULL to go back to stdout; the caller still owns the sink
+void setOutputSink(OutputSink*);
+// pass text straight to the current sink, for whatever setOutputWriter handed the drawing to
+void writeOutput(const char*, int);
+void flushOutput(void);
+
@@ -0,0 +1,308 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gif.h"
+#include "output_sink.h"
+#include "raster.h"
+
+static OutputSink* newSink(void (*write)(OutputSink*, const char*, int), void (*flush)(OutputSink*), void (*close)(OutputSink*), void* state)
+{
+  OutputSink* sink = (OutputSink*)malloc(sizeof(OutputSink));
+  if (sink == NULL) return NULL;
+  sink->write = write;
+  sink->flush = flush;
+  sink->close = close;
+  sink->state = state;
+  return sink;
+}
+
+// stdout and file sinks
+
+static void fileWrite(OutputSink* sink, const char* text, int length)
+{
+  fwrite(text, 1, length, (FILE*)sink->state);
+}
+
+static void fileFlush(OutputSink* sink)
+{
+  fflush((FILE*)sink->state);
+}
+
+static void fileClose(OutputSink* sink)
+{
+  FILE* file = (FILE*)sink->state;
+  if (file == stdout) fflush(file);
+  else fclose(file);
+}
+
+OutputSink* openStdoutSink(void)
+{
+  return newSink(fileWrite, fileFlush, fileClose, stdout);
+}
+
+OutputSink* openFileSink(const char* path)
+{
+  FILE* file = fopen(path, "w");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Could not open %s for the drawing output\n", path);
+    return NULL;
+  }
+  OutputSink* sink = newSink(fileWrite, fileFlush, fileClose, file);
+  if (sink == NULL) fclose(file);
+  return sink;
+}
+
+// null sink
+
+static void nullWrite(OutputSink* sink, const char* text, int length)
+{
+  (void)sink;
+  (void)text;
+  (void)length;
+}
+
+static void nullFlush(OutputSink* sink)
+{
+  (void)sink;
+}
+
+static void nullClose(OutputSink* sink)
+{
+  (void)sink;
+}
+
+OutputSink* openNullSink(void)
+{
+  return newSink(nullWrite, nullFlush, nullClose, NULL);
+}
+
+// Unix domain socket sink: one viewer at a time can attach, and is sent the window size and the last complete background first so it can join part way through
+
+typedef struct
+{
+  char* data;
+  int length;
+  int capacity;
+} TextBuffer;
+
+typedef struct
+{
+  int listenFd;
+  int viewerFd;
+  char* path;
+  TextBuffer line; // the command being written, until its newline arrives
+  TextBuffer windowSize; // the last SW command
+  TextBuffer section; // the BG ... FG section being recorded
+  TextBuffer background; // the last complete BG ... FG section
+  int recordingBackground;
+} SocketSink;
+
+static int appendText(TextBuffer* buffer, const char* text, int length)
+{
+  if (buffer->length + length > buffer->capacity)
+  {
+    int capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 4096;
+    while (capacity < buffer->length + length) capacity *= 2;
+    char* data = (char*)realloc(buffer->data, capacity);
+    if (data == NULL) return 0;
+    buffer->data = data;
+    buffer->capacity = capacity;
+  }
+  memcpy(buffer->data + buffer->length, text, length);
+  buffer->length += length;
+  return 1;
+}
+
+static int sendAll(int fd, const char* text, int length)
+{
+  while (length > 0)
+  {
+    ssize_t sent = send(fd, text, length, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (errno == EINTR) continue;
+      return 0;
+    }
+    text += sent;
+    length -= sent;
+  }
+  return 1;
+}
+
+static int isCommand(const char* line, int length, const char* command)
+{
+  return length >= 3 && memcmp(line, command, 2) == 0 && (line[2] == ' ' || line[2] == '\n');
+}
+
+// takes one whole command, newline included, and keeps what a viewer attaching later needs: the window size and the last complete background, replacing the one before once a new one ends
+static void recordCommand(SocketSink* socketSink, const char* line, int length)
+{
+  if (isCommand(line, length, "SW"))
+  {
+    socketSink->windowSize.length = 0;
+    appendText(&socketSink->windowSize, line, length);
+    return;
+  }
+  if (isCommand(line, length, "BG") && !socketSink->recordingBackground)
+  {
+    socketSink->section.length = 0;
+    socketSink->recordingBackground = 1;
+  }
+  if (!socketSink->recordingBackground) return;
+
+  appendText(&socketSink->section, line, length);
+  if (isCommand(line, length, "FG"))
+  {
+    TextBuffer finished = socketSink->section;
+    socketSink->section = socketSink->background;
+    socketSink->background = finished;
+    socketSink->recordingBackground = 0;
+  }
+}
+
+// splits what is written into whole commands, as the async writer passes spans of its buffer that can start or end part way through one
+static void recordBackground(SocketSink* socketSink, const char* text, int length)
+{
+  int start = 0;
+  for (int i = 0; i < length; i++)
+  {
+    if (text[i] != '\n') continue;
+    if (socketSink->line.length == 0)
+    {
+      recordCommand(socketSink, text + start, i + 1 - start);
+    }
+    else
+    {
+      appendText(&socketSink->line, text + start, i + 1 - start);
+      recordCommand(socketSink, socketSink->line.data, socketSink->line.length);
+      socketSink->line.length = 0;
+    }
+    start = i + 1;
+  }
+  if (start < length) appendText(&socketSink->line, text + start, length - start);
+}
+
+static void acceptViewer(SocketSink* socketSink)
+{
+  // only between whole commands and outside a background being drawn, so a new viewer starts from a complete picture
+  if (socketSink->viewerFd >= 0 || socketSink->line.length > 0 || socketSink->recordingBackground) return;
+  int fd = accept(socketSink->listenFd, NULL, NULL);
+  if (fd < 0) return; // nobody waiting, the listening socket does not block
+
+  if (!sendAll(fd, socketSink->windowSize.data, socketSink->windowSize.length) || !sendAll(fd, socketSink->background.data, socketSink->background.length))
+  {
+    close(fd);
+    return;
+  }
+  socketSink->viewerFd = fd;
+}
+
+static void socketWrite(OutputSink* sink, const char* text, int length)
+{
+  SocketSink* socketSink = (SocketSink*)sink->state;
+  acceptViewer(socketSink);
+  recordBackground(socketSink, text, length);
+  if (socketSink->viewerFd < 0) return;
+
+  if (!sendAll(socketSink->viewerFd, text, length))
+  {
+    // the viewer detached, so wait for another
+    close(socketSink->viewerFd);
+    socketSink->viewerFd = -1;
+  }
+}
+
+static void socketFlush(OutputSink* sink)
+{
+  acceptViewer((SocketSink*)sink->state);
+}
+
+static void socketClose(OutputSink* sink)
+{
+  SocketSink* socketSink = (SocketSink*)sink->state;
+  if (socketSink->viewerFd >= 0) close(socketSink->viewerFd);
+  close(socketSink->listenFd);
+  unlink(socketSink->path);
+  free(socketSink->path);
+  free(socketSink->line.data);
+  free(socketSink->windowSize.data);
+  free(socketSink->section.data);
+  free(socketSink->background.data);
+  free(socketSink);
+}
+
+OutputSink* openUnixSocketSink(const char* path)
+{
+  struct sockaddr_un address;
+  if (strlen(path) >= sizeof(address.sun_path))
+  {
+    fprintf(stderr, "Socket path %s is too long\n", path);
+    return NULL;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    fprintf(stderr, "Could not create a socket for the drawing output\n");
+    return NULL;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+  unlink(path); // left behind by an earlier run
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 1) != 0)
+  {
+    fprintf(stderr, "Could not listen on %s for the drawing output\n", path);
+    close(fd);
+    return NULL;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  SocketSink* socketSink = (SocketSink*)calloc(1, sizeof(SocketSink));
+  char* pathCopy = (char*)malloc(strlen(path) + 1);
+  OutputSink* sink = newSink(socketWrite, socketFlush, socketClose, socketSink);
+  if (socketSink == NULL || pathCopy == NULL || sink == NULL)
+  {
+    free(socketSink);
+    free(pathCopy);
+    free(sink);
+    close(fd);
+    unlink(path);
+    return NULL;
+  }
+  strcpy(pathCopy, path);
+  socketSink->listenFd = fd;
+  socketSink->viewerFd = -1;
+  socketSink->path = pathCopy;
+  return sink;
+}
+
+// choosing a sink
+
+OutputSink* openOutputSink(const char* spec)
+{
+  if (strcmp(spec, "stdout") == 0) return openStdoutSink();
+  if (strcmp(spec, "null") == 0) return openNullSink();
+  if (strncmp(spec, "file:", 5) == 0) return openFileSink(spec + 5);
+  if (strncmp(spec, "unix:", 5) == 0) return openUnixSocketSink(spec + 5);
+  if (strncmp(spec, "ppm:", 4) == 0) return openPpmSink(spec + 4);
+  if (strncmp(spec, "gif:", 4) == 0) return openGifSink(spec + 4);
+
+  fprintf(stderr, "Unknown drawing output %s, expected stdout, null, file:PATH, unix:PATH, ppm:PATH or gif:PATH\n", spec);
+  return NULL;
+}
+
+void closeOutputSink(OutputSink* sink)
+{
+  if (sink == NULL) return;
+  sink->close(sink);
+  free(sink);
+}
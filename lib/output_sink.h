@@ -0,0 +1,23 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+// somewhere the drawapp commands are written to, chosen at runtime
+typedef struct OutputSink OutputSink;
+struct OutputSink
+{
+  void (*write)(OutputSink*, const char*, int);
+  void (*flush)(OutputSink*);
+  void (*close)(OutputSink*);
+  void* state;
+};
+
+// "stdout", "null", "file:PATH", "unix:PATH", "ppm:PATH" (see raster.h) or "gif:PATH" (see gif.h); returns NULL if the sink could not be opened
+OutputSink* openOutputSink(const char*);
+void closeOutputSink(OutputSink*);
+
+OutputSink* openStdoutSink(void);
+OutputSink* openNullSink(void);
+OutputSink* openFileSink(const char*);
+OutputSink* openUnixSocketSink(const char*);
+
+#endif
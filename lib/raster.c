@@ -0,0 +1,500 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "raster.h"
+
+#define RASTER_MAX_POLYGON 64
+#define PI 3.141592653
+
+static const struct
+{
+  const char* name;
+  unsigned char rgb[3];
+} colourTable[] =
+{
+  {"black", {0, 0, 0}}, {"blue", {0, 0, 255}}, {"cyan", {0, 255, 255}}, {"darkgray", {64, 64, 64}},
+  {"gray", {128, 128, 128}}, {"green", {0, 255, 0}}, {"lightgray", {192, 192, 192}}, {"magenta", {255, 0, 255}},
+  {"orange", {255, 200, 0}}, {"pink", {255, 175, 175}}, {"red", {255, 0, 0}}, {"white", {255, 255, 255}},
+  {"yellow", {255, 255, 0}}
+};
+
+Raster* createRaster(void)
+{
+  Raster* raster = (Raster*)calloc(1, sizeof(Raster));
+  if (raster == NULL) return NULL;
+  raster->drawingForeground = 1; // like the drawapp, drawing goes on the foreground until background is called
+  return raster;
+}
+
+void freeRaster(Raster* raster)
+{
+  if (raster == NULL) return;
+  free(raster->background);
+  free(raster->foreground);
+  free(raster->covered);
+  free(raster->pixels);
+  free(raster->damagedBlocks);
+  free(raster->coveredBlocks);
+  free(raster);
+}
+
+static int resizeRaster(Raster* raster, int width, int height)
+{
+  if (width <= 0 || height <= 0) return 0;
+  size_t numPixels = (size_t)width * height;
+  unsigned char* background = (unsigned char*)malloc(numPixels * 3);
+  unsigned char* foreground = (unsigned char*)malloc(numPixels * 3);
+  unsigned char* covered = (unsigned char*)calloc(numPixels, 1);
+  unsigned char* pixels = (unsigned char*)malloc(numPixels * 3);
+  int blocksWide = (width + RASTER_BLOCK_SIZE - 1) >> RASTER_BLOCK_SHIFT;
+  int blocksHigh = (height + RASTER_BLOCK_SIZE - 1) >> RASTER_BLOCK_SHIFT;
+  unsigned char* damagedBlocks = (unsigned char*)malloc(blocksWide * blocksHigh);
+  unsigned char* coveredBlocks = (unsigned char*)calloc(blocksWide * blocksHigh, 1);
+  if (background == NULL || foreground == NULL || covered == NULL || pixels == NULL || damagedBlocks == NULL || coveredBlocks == NULL)
+  {
+    free(background);
+    free(foreground);
+    free(covered);
+    free(pixels);
+    free(damagedBlocks);
+    free(coveredBlocks);
+    return 0;
+  }
+  memset(background, 255, numPixels * 3);
+  memset(damagedBlocks, 1, blocksWide * blocksHigh);
+
+  free(raster->background);
+  free(raster->foreground);
+  free(raster->covered);
+  free(raster->pixels);
+  free(raster->damagedBlocks);
+  free(raster->coveredBlocks);
+  raster->background = background;
+  raster->foreground = foreground;
+  raster->covered = covered;
+  raster->pixels = pixels;
+  raster->width = width;
+  raster->height = height;
+  raster->blocksWide = blocksWide;
+  raster->blocksHigh = blocksHigh;
+  raster->damagedBlocks = damagedBlocks;
+  raster->coveredBlocks = coveredBlocks;
+  return 1;
+}
+
+// drawing on the current layer
+
+static void plot(Raster* raster, int x, int y)
+{
+  if (x < 0 || y < 0 || x >= raster->width || y >= raster->height) return;
+  size_t index = (size_t)y * raster->width + x;
+  unsigned char* layer = raster->drawingForeground ? raster->foreground : raster->background;
+  memcpy(layer + index * 3, raster->colour, 3);
+  int block = (y >> RASTER_BLOCK_SHIFT) * raster->blocksWide + (x >> RASTER_BLOCK_SHIFT);
+  raster->damagedBlocks[block] = 1;
+  if (raster->drawingForeground)
+  {
+    raster->covered[index] = 1;
+    raster->coveredBlocks[block] = 1;
+  }
+}
+
+static void fillSpan(Raster* raster, int y, int x0, int x1)
+{
+  if (y < 0 || y >= raster->height) return;
+  if (x0 < 0) x0 = 0;
+  if (x1 > raster->width) x1 = raster->width;
+  for (int x = x0; x < x1; x++) plot(raster, x, y);
+}
+
+static void fillRectangle(Raster* raster, int x, int y, int width, int height)
+{
+  for (int row = y; row < y + height; row++) fillSpan(raster, row, x, x + width);
+}
+
+static void drawLineSegment(Raster* raster, int x0, int y0, int x1, int y1)
+{
+  int dx = abs(x1 - x0);
+  int dy = -abs(y1 - y0);
+  int stepX = x0 < x1 ? 1 : -1;
+  int stepY = y0 < y1 ? 1 : -1;
+  int error = dx + dy;
+  while (1)
+  {
+    plot(raster, x0, y0);
+    if (x0 == x1 && y0 == y1) return;
+    int twice = 2 * error;
+    if (twice >= dy)
+    {
+      error += dy;
+      x0 += stepX;
+    }
+    if (twice <= dx)
+    {
+      error += dx;
+      y0 += stepY;
+    }
+  }
+}
+
+// fills the pixels whose centres are inside the polygon, using the even-odd rule like java.awt
+static void fillPolygonShape(Raster* raster, int count, const int* xs, const int* ys)
+{
+  int top = ys[0];
+  int bottom = ys[0];
+  for (int i = 1; i < count; i++)
+  {
+    if (ys[i] < top) top = ys[i];
+    if (ys[i] > bottom) bottom = ys[i];
+  }
+  if (top < 0) top = 0;
+  if (bottom > raster->height) bottom = raster->height;
+
+  double crossings[RASTER_MAX_POLYGON];
+  for (int y = top; y < bottom; y++)
+  {
+    double centreY = y + 0.5;
+    int numCrossings = 0;
+    for (int i = 0; i < count; i++)
+    {
+      int j = (i + 1) % count;
+      if ((ys[i] <= centreY) == (ys[j] <= centreY)) continue;
+      crossings[numCrossings++] = xs[i] + (centreY - ys[i]) * (xs[j] - xs[i]) / (double)(ys[j] - ys[i]);
+    }
+    for (int i = 1; i < numCrossings; i++)
+    {
+      double crossing = crossings[i];
+      int j = i - 1;
+      for (; j >= 0 && crossings[j] > crossing; j--) crossings[j + 1] = crossings[j];
+      crossings[j + 1] = crossing;
+    }
+    for (int i = 0; i + 1 < numCrossings; i += 2)
+    {
+      fillSpan(raster, y, (int)ceil(crossings[i] - 0.5), (int)ceil(crossings[i + 1] - 0.5));
+    }
+  }
+}
+
+// fills the pixels whose centres are inside the ellipse bounded by the rectangle and between the angles, which go anticlockwise from 3 o'clock in degrees
+static void fillArcShape(Raster* raster, int x, int y, int width, int height, int startAngle, int arcAngle)
+{
+  if (width <= 0 || height <= 0) return;
+  double radiusX = width / 2.0;
+  double radiusY = height / 2.0;
+  double centreX = x + radiusX;
+  double centreY = y + radiusY;
+  int whole = arcAngle >= 360 || arcAngle <= -360;
+  if (arcAngle < 0)
+  {
+    startAngle += arcAngle;
+    arcAngle = -arcAngle;
+  }
+
+  for (int row = y; row < y + height; row++)
+  {
+    double dy = (row + 0.5 - centreY) / radiusY;
+    for (int column = x; column < x + width; column++)
+    {
+      double dx = (column + 0.5 - centreX) / radiusX;
+      if (dx * dx + dy * dy > 1.0) continue;
+      if (!whole)
+      {
+        double angle = atan2(-dy, dx) * 180.0 / PI - startAngle;
+        angle = fmod(angle, 360.0);
+        if (angle < 0) angle += 360.0;
+        if (angle > arcAngle) continue;
+      }
+      plot(raster, column, row);
+    }
+  }
+}
+
+static void setNamedColour(Raster* raster, const char* name)
+{
+  for (size_t i = 0; i < sizeof(colourTable) / sizeof(colourTable[0]); i++)
+  {
+    if (strcmp(colourTable[i].name, name) == 0)
+    {
+      memcpy(raster->colour, colourTable[i].rgb, 3);
+      return;
+    }
+  }
+}
+
+RasterRect rasterBlockRect(const Raster* raster, int block)
+{
+  RasterRect rect;
+  rect.left = (block % raster->blocksWide) << RASTER_BLOCK_SHIFT;
+  rect.top = (block / raster->blocksWide) << RASTER_BLOCK_SHIFT;
+  rect.right = rect.left + RASTER_BLOCK_SIZE < raster->width ? rect.left + RASTER_BLOCK_SIZE : raster->width;
+  rect.bottom = rect.top + RASTER_BLOCK_SIZE < raster->height ? rect.top + RASTER_BLOCK_SIZE : raster->height;
+  return rect;
+}
+
+static void clearLayer(Raster* raster)
+{
+  int numBlocks = raster->blocksWide * raster->blocksHigh;
+  if (!raster->drawingForeground)
+  {
+    memset(raster->background, 255, (size_t)raster->width * raster->height * 3);
+    memset(raster->damagedBlocks, 1, numBlocks);
+    return;
+  }
+
+  for (int block = 0; block < numBlocks; block++)
+  {
+    if (!raster->coveredBlocks[block]) continue;
+    RasterRect rect = rasterBlockRect(raster, block);
+    for (int y = rect.top; y < rect.bottom; y++)
+    {
+      memset(raster->covered + (size_t)y * raster->width + rect.left, 0, rect.right - rect.left);
+    }
+    raster->coveredBlocks[block] = 0;
+    raster->damagedBlocks[block] = 1;
+  }
+}
+
+// text, images, line widths and messages have no effect on the picture here and are ignored; sleeps are only added up
+int rasterCommand(Raster* raster, const char* line)
+{
+  int a, b, c, d, e, f;
+  char name[32];
+  if (strncmp(line, "SW ", 3) == 0)
+  {
+    if (sscanf(line + 3, "%d %d", &a, &b) != 2) return 1;
+    return resizeRaster(raster, a, b);
+  }
+  if (strncmp(line, "FG", 2) == 0)
+  {
+    raster->drawingForeground = 1;
+    return 1;
+  }
+  if (strncmp(line, "BG", 2) == 0)
+  {
+    raster->drawingForeground = 0;
+    return 1;
+  }
+  if (strncmp(line, "SL ", 3) == 0)
+  {
+    if (sscanf(line + 3, "%d", &a) == 1 && a > 0) raster->slept += a;
+    return 1;
+  }
+  if (strncmp(line, "SC ", 3) == 0)
+  {
+    if (sscanf(line + 3, "%31s", name) == 1) setNamedColour(raster, name);
+    return 1;
+  }
+  if (strncmp(line, "RG ", 3) == 0)
+  {
+    if (sscanf(line + 3, "%d %d %d", &a, &b, &c) != 3) return 1;
+    raster->colour[0] = a;
+    raster->colour[1] = b;
+    raster->colour[2] = c;
+    return 1;
+  }
+  if (raster->width == 0) return 1; // nothing to draw on until the window size is set
+
+  if (strncmp(line, "CL", 2) == 0) clearLayer(raster);
+  else if (strncmp(line, "FR ", 3) == 0 && sscanf(line + 3, "%d %d %d %d", &a, &b, &c, &d) == 4) fillRectangle(raster, a, b, c, d);
+  else if (strncmp(line, "FO ", 3) == 0 && sscanf(line + 3, "%d %d %d %d", &a, &b, &c, &d) == 4) fillArcShape(raster, a, b, c, d, 0, 360);
+  else if (strncmp(line, "FA ", 3) == 0 && sscanf(line + 3, "%d %d %d %d %d %d", &a, &b, &c, &d, &e, &f) == 6) fillArcShape(raster, a, b, c, d, e, f);
+  else if (strncmp(line, "DL ", 3) == 0 && sscanf(line + 3, "%d %d %d %d", &a, &b, &c, &d) == 4) drawLineSegment(raster, a, b, c, d);
+  else if (strncmp(line, "DR ", 3) == 0 && sscanf(line + 3, "%d %d %d %d", &a, &b, &c, &d) == 4)
+  {
+    drawLineSegment(raster, a, b, a + c, b);
+    drawLineSegment(raster, a + c, b, a + c, b + d);
+    drawLineSegment(raster, a + c, b + d, a, b + d);
+    drawLineSegment(raster, a, b + d, a, b);
+  }
+  else if (strncmp(line, "FP ", 3) == 0)
+  {
+    int xs[RASTER_MAX_POLYGON];
+    int ys[RASTER_MAX_POLYGON];
+    int count, used;
+    const char* p = line + 3;
+    if (sscanf(p, "%d%n", &count, &used) != 1 || count < 3 || count > RASTER_MAX_POLYGON) return 1;
+    p += used;
+    for (int i = 0; i < count; i++)
+    {
+      if (sscanf(p, "%d %d%n", &xs[i], &ys[i], &used) != 2) return 1;
+      p += used;
+    }
+    fillPolygonShape(raster, count, xs, ys);
+  }
+  return 1;
+}
+
+const unsigned char* rasterPixels(Raster* raster, unsigned char* changedBlocks)
+{
+  int numBlocks = raster->blocksWide * raster->blocksHigh;
+  for (int block = 0; block < numBlocks; block++)
+  {
+    if (!raster->damagedBlocks[block]) continue;
+    RasterRect rect = rasterBlockRect(raster, block);
+    for (int y = rect.top; y < rect.bottom; y++)
+    {
+      size_t start = (size_t)y * raster->width + rect.left;
+      size_t end = start + (rect.right - rect.left);
+      memcpy(raster->pixels + start * 3, raster->background + start * 3, (end - start) * 3);
+      for (size_t i = start; i < end; i++)
+      {
+        if (raster->covered[i]) memcpy(raster->pixels + i * 3, raster->foreground + i * 3, 3);
+      }
+    }
+    raster->damagedBlocks[block] = 0;
+    if (changedBlocks != NULL) changedBlocks[block] = 1;
+  }
+  return raster->pixels;
+}
+
+// the raster sink: commands can arrive split anywhere, so they are gathered into whole lines first
+
+typedef struct
+{
+  Raster* raster;
+  char* line;
+  int lineLength;
+  int lineCapacity;
+  int drawnSinceFrame; // the foreground has been drawn on since the last frame was written
+  int frames;
+  RasterFrameWriter writeFrame;
+  void (*finish)(void*, Raster*);
+  void* state;
+} RasterSink;
+
+static void runLine(RasterSink* rasterSink)
+{
+  const char* line = rasterSink->line;
+  Raster* raster = rasterSink->raster;
+  if (strncmp(line, "CL", 2) == 0 && raster->drawingForeground && rasterSink->drawnSinceFrame)
+  {
+    rasterSink->writeFrame(rasterSink->state, raster, rasterSink->frames++);
+    rasterSink->drawnSinceFrame = 0;
+  }
+  if (!rasterCommand(raster, line))
+  {
+    fprintf(stderr, "Could not allocate a raster for %s\n", line);
+    return;
+  }
+  if (raster->drawingForeground && (line[0] == 'F' || line[0] == 'D') && strncmp(line, "FG", 2) != 0) rasterSink->drawnSinceFrame = 1;
+}
+
+static void rasterWrite(OutputSink* sink, const char* text, int length)
+{
+  RasterSink* rasterSink = (RasterSink*)sink->state;
+  for (int i = 0; i < length; i++)
+  {
+    if (text[i] == '\n')
+    {
+      rasterSink->line[rasterSink->lineLength] = '\0';
+      runLine(rasterSink);
+      rasterSink->lineLength = 0;
+      continue;
+    }
+    if (rasterSink->lineLength + 1 >= rasterSink->lineCapacity)
+    {
+      char* line = (char*)realloc(rasterSink->line, rasterSink->lineCapacity * 2);
+      if (line == NULL) continue;
+      rasterSink->line = line;
+      rasterSink->lineCapacity *= 2;
+    }
+    rasterSink->line[rasterSink->lineLength++] = text[i];
+  }
+}
+
+static void rasterFlush(OutputSink* sink)
+{
+  (void)sink;
+}
+
+static void rasterClose(OutputSink* sink)
+{
+  RasterSink* rasterSink = (RasterSink*)sink->state;
+  if (rasterSink->drawnSinceFrame) rasterSink->writeFrame(rasterSink->state, rasterSink->raster, rasterSink->frames++);
+  if (rasterSink->finish != NULL) rasterSink->finish(rasterSink->state, rasterSink->raster);
+  freeRaster(rasterSink->raster);
+  free(rasterSink->line);
+  free(rasterSink);
+}
+
+OutputSink* openRasterSink(RasterFrameWriter writeFrame, void (*finish)(void*, Raster*), void* state)
+{
+  RasterSink* rasterSink = (RasterSink*)calloc(1, sizeof(RasterSink));
+  OutputSink* sink = (OutputSink*)malloc(sizeof(OutputSink));
+  if (rasterSink != NULL)
+  {
+    rasterSink->raster = createRaster();
+    rasterSink->lineCapacity = 256;
+    rasterSink->line = (char*)malloc(rasterSink->lineCapacity);
+  }
+  if (rasterSink == NULL || sink == NULL || rasterSink->raster == NULL || rasterSink->line == NULL)
+  {
+    if (rasterSink != NULL)
+    {
+      freeRaster(rasterSink->raster);
+      free(rasterSink->line);
+    }
+    free(rasterSink);
+    free(sink);
+    fprintf(stderr, "Could not allocate a raster sink\n");
+    return NULL;
+  }
+  rasterSink->writeFrame = writeFrame;
+  rasterSink->finish = finish;
+  rasterSink->state = state;
+  sink->write = rasterWrite;
+  sink->flush = rasterFlush;
+  sink->close = rasterClose;
+  sink->state = rasterSink;
+  return sink;
+}
+
+// PPM images
+
+int writePpm(const char* path, const Raster* raster, const unsigned char* pixels)
+{
+  FILE* file = fopen(path, "wb");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Could not open %s to write an image\n", path);
+    return 0;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", raster->width, raster->height);
+  fwrite(pixels, 3, (size_t)raster->width * raster->height, file);
+  return fclose(file) == 0;
+}
+
+static void ppmFrame(void* state, Raster* raster, int frame)
+{
+  const char* pattern = (const char*)state;
+  if (strchr(pattern, '%') == NULL) return; // only the final picture is wanted
+
+  char path[1024];
+  snprintf(path, sizeof(path), pattern, frame);
+  writePpm(path, raster, rasterPixels(raster, NULL));
+}
+
+static void ppmFinish(void* state, Raster* raster)
+{
+  char* pattern = (char*)state;
+  if (strchr(pattern, '%') == NULL && raster->width > 0) writePpm(pattern, raster, rasterPixels(raster, NULL));
+  free(pattern);
+}
+
+OutputSink* openPpmSink(const char* path)
+{
+  // the path becomes the format for each frame's file name, so only allow a single number in it
+  const char* percent = strchr(path, '%');
+  if (percent != NULL && (percent[1 + strspn(percent + 1, "0123456789")] != 'd' || strchr(percent + 1, '%') != NULL))
+  {
+    fprintf(stderr, "Image path %s can only contain one %%d, e.g. frames/%%05d.ppm\n", path);
+    return NULL;
+  }
+  char* pattern = (char*)malloc(strlen(path) + 1);
+  if (pattern == NULL) return NULL;
+  strcpy(pattern, path);
+  OutputSink* sink = openRasterSink(ppmFrame, ppmFinish, pattern);
+  if (sink == NULL) free(pattern);
+  return sink;
+}
@@ -0,0 +1,54 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "output_sink.h"
+
+#define RASTER_BLOCK_SHIFT 4 // changes are tracked in blocks of 16 by 16 pixels
+#define RASTER_BLOCK_SIZE (1 << RASTER_BLOCK_SHIFT)
+
+// a rectangle of pixels, empty when right <= left
+typedef struct
+{
+  int left;
+  int top;
+  int right; // exclusive
+  int bottom;
+} RasterRect;
+
+// an in-memory copy of the drawapp window, drawn on by interpreting the same commands the drawapp reads
+typedef struct
+{
+  int width;
+  int height;
+  unsigned char* background; // RGB, 3 bytes per pixel
+  unsigned char* foreground;
+  unsigned char* covered; // 1 where the foreground has been drawn since it was last cleared
+  unsigned char* pixels; // the layers combined, filled in by rasterPixels
+  int blocksWide;
+  int blocksHigh;
+  unsigned char* damagedBlocks; // 1 for each block drawn on or cleared since rasterPixels was last called
+  unsigned char* coveredBlocks; // 1 for each block with covered pixels, so clearing the foreground only touches those
+  unsigned char colour[3];
+  int drawingForeground;
+  long slept; // total miliseconds of SL commands carried out, to time frames with
+} Raster;
+
+Raster* createRaster(void);
+void freeRaster(Raster*);
+// carry out one command line (without its newline); returns 0 if the window could not be resized
+int rasterCommand(Raster*, const char*);
+// the background with the foreground on top, 3 bytes per pixel row by row; only damaged blocks are combined again, and are set to 1 in changedBlocks if it is not NULL
+const unsigned char* rasterPixels(Raster*, unsigned char*);
+// the pixels of a block, clipped to the window
+RasterRect rasterBlockRect(const Raster*, int);
+
+// called for each finished frame, i.e. when the foreground is about to be cleared after being drawn on, and on close if it has been drawn on since
+typedef void (*RasterFrameWriter)(void*, Raster*, int);
+// a sink that draws into a raster and hands each frame to writeFrame (with the frame number), then calls finish once everything has been drawn
+OutputSink* openRasterSink(RasterFrameWriter, void (*)(void*, Raster*), void*);
+
+// a raster sink writing a PPM image; PATH containing a printf number (e.g. "frames/%05d.ppm") writes every frame, otherwise just the final picture
+OutputSink* openPpmSink(const char*);
+int writePpm(const char*, const Raster*, const unsigned char*);
+
+#endif
@@ -3,66 +3,79 @@
 #include "../include/arena.h"
 #include "../include/config.h"
 #include "../include/drawing.h"
+#include "../include/pool.h"
 #include "../include/robot.h"
+#include "../include/tile_grid.h"
 #include "../include/utils.h"
 
 #include "../lib/graphics.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
-// this function ensures that the values for obstacle and markers in config.c are correct
-void check_obstacle_marker_values(Arena *arena, ObstacleFormation of, int numObstacles, MarkerFormation mf, int numMarkers)
+// this function ensures that the values for obstacle and markers in config.c are correct, returning S_ERR_CONFIG if not
+Status check_obstacle_marker_values(Arena *arena, ObstacleFormation of, int numObstacles, MarkerFormation mf, int numMarkers)
 {
     if (of == O_CAVERN && mf == M_EDGE) {
         fprintf(stderr, "Obstacle formation is cavern and marker formation is edge which is incompatible\n");
-        exit(EXIT_FAILURE);
+        return S_ERR_CONFIG;
     }
-    if (numObstacles > (arena->arenaWidth * arena->arenaHeight)/3 && of != O_CAVERN) {
-        fprintf(stderr, "Number of obstacles: %d exceeds 1/3 number of tiles: %d\n", numObstacles, (arena->arenaWidth * arena->arenaHeight)/3);
-        exit(EXIT_FAILURE);
+    long long numTiles = (long long)arena->arenaWidth * arena->arenaHeight; // can be more than an int holds for a sparse arena
+    if (numObstacles > numTiles/3 && of != O_CAVERN) {
+        fprintf(stderr, "Number of obstacles: %d exceeds 1/3 number of tiles: %lld\n", numObstacles, numTiles/3);
+        return S_ERR_CONFIG;
     }
-    if (numMarkers > (2*arena->arenaWidth * arena->arenaHeight)/3) {
-        fprintf(stderr, "Number of markers: %d exceeds 2/3 number of tiles: %d\n", numMarkers, (2 * arena->arenaWidth * arena->arenaHeight)/3);
-        exit(EXIT_FAILURE);
+    if (numMarkers > 2*numTiles/3) {
+        fprintf(stderr, "Number of markers: %d exceeds 2/3 number of tiles: %lld\n", numMarkers, 2*numTiles/3);
+        return S_ERR_CONFIG;
     }
+    return S_OK;
 }
 
 // this function generates obstacles randomly; pre-requisites: arenaGrid is completely empty AND numObstacles is less than a third of the grid
-static void generate_obstacles_random(Arena *arena, int numObstacles) 
+static Status generate_obstacles_random(Arena *arena, int numObstacles) 
 {
     // make sure we aren't trying to place more obstacles than half the grid
-    if (numObstacles >= arena->arenaWidth*arena->arenaHeight/3) {
+    if (numObstacles >= (long long)arena->arenaWidth*arena->arenaHeight/3) {
         fprintf(stderr, "Number of obstacles cannot exceed 1/3 the grid.\n");
-        exit(EXIT_FAILURE);
+        return S_ERR_CONFIG;
+    }
+    if (numObstacles >= arena->emptyTiles) { // e.g. inside a small cavern, and the robot needs a tile too
+        fprintf(stderr, "Number of obstacles: %d does not leave a free tile of the %lld left\n", numObstacles, arena->emptyTiles);
+        return S_ERR_CONFIG;
     }
     // theoretically could become an infinite loop, but in reality unlikely to if only filling a third of the grid
     for (int i = 0; i < numObstacles; i++) {
         // generate (x, y) until (x, y) is an empty tile
         int x, y;
         do {
-            x = random_coord(arena->arenaWidth);
-            y = random_coord(arena->arenaHeight);
-        } while (arena->arenaGrid[y][x] != T_EMPTY);
+            x = random_coord(&arena->rng, arena->arenaWidth);
+            y = random_coord(&arena->rng, arena->arenaHeight);
+        } while (get_tile(&arena->arenaGrid, x, y) != T_EMPTY);
 
-        arena->arenaGrid[y][x] = T_OBSTACLE;
+        set_tile(&arena->arenaGrid, x, y, T_OBSTACLE);
+        arena->emptyTiles--;
     }
+    return S_OK;
 }
 
 // this function generates a vertical wall from the bottom of the screen to near the top with a length specified; pre-requisite: arenaGrid is completely empty
-static void generate_obstacles_wall(Arena* arena, int numObstacles)
+static Status generate_obstacles_wall(Arena* arena, int numObstacles)
 {
     if (numObstacles >= arena->arenaHeight) {
         fprintf(stderr, "For a single wall, the number of obstacles must be less than the arena height\n");
-        exit(EXIT_FAILURE);
+        return S_ERR_CONFIG;
     }
 
     int x = arena->arenaWidth/3;
 
     for (int i = 0; i < numObstacles; i++) {
-        arena->arenaGrid[arena->arenaHeight - 1 - i][x] = T_OBSTACLE;
+        set_tile(&arena->arenaGrid, x, arena->arenaHeight - 1 - i, T_OBSTACLE);
     }
+    arena->emptyTiles -= numObstacles;
+    return S_OK;
 }
 
 // this function creates a cavern by finding a central arenaGrid coordinate and determines whether each coordinate is within a set radius; pre-requisite: arenaGrid is completely empty
@@ -78,155 +91,420 @@ static void generate_obstacles_cavern(Arena *arena)
             double sqrDistToCentre = calc_squared_dist_coords(centreX, centreY, x + 0.5, y + 0.5);
 
             if (sqrDistToCentre >= radius * radius) {
-                arena->arenaGrid[y][x] = T_OBSTACLE;
+                set_tile(&arena->arenaGrid, x, y, T_OBSTACLE);
+                arena->emptyTiles--;
             }
         }
     }
 }
 
 // this function determines which function to use to generate obstacles and then calls it; pass numObstacles = 0 if not needed
-void generate_obstacles(Arena *arena, int numObstacles, ObstacleFormation formation)
+Status generate_obstacles(Arena *arena, int numObstacles, ObstacleFormation formation)
 {
     switch(formation) {
         case O_NONE:
-            break;
+            return S_OK;
         case O_RANDOM:
-            generate_obstacles_random(arena, numObstacles);
-            break;
+            return generate_obstacles_random(arena, numObstacles);
         case O_WALL:
-            generate_obstacles_wall(arena, numObstacles);
-            break;
+            return generate_obstacles_wall(arena, numObstacles);
         case O_CAVERN:
             generate_obstacles_cavern(arena);
-            break;
+            return S_OK;
         case O_CAVERN_RANDOM:
             generate_obstacles_cavern(arena);
-            generate_obstacles_random(arena, numObstacles);
-            break;
+            return generate_obstacles_random(arena, numObstacles);
     }
+    fprintf(stderr, "Unknown obstacle formation %d in generate_obstacles\n", formation);
+    return S_ERR_CONFIG;
 }
 
-// this function generates a single marker somewhere along the edge of the grid; pre-requisite: no obstacles placed
-static void generate_marker_edge(Arena *arena, int numMarkers)
+// this function counts the empty tiles around the edge of the grid
+static int count_empty_edge_tiles(Arena *arena)
+{
+    int count = 0;
+    for (int x = 0; x < arena->arenaWidth; x++) {
+        count += get_tile(&arena->arenaGrid, x, 0) == T_EMPTY;
+        count += get_tile(&arena->arenaGrid, x, arena->arenaHeight-1) == T_EMPTY;
+    }
+    for (int y = 1; y < arena->arenaHeight-1; y++) {
+        count += get_tile(&arena->arenaGrid, 0, y) == T_EMPTY;
+        count += get_tile(&arena->arenaGrid, arena->arenaWidth-1, y) == T_EMPTY;
+    }
+    return count;
+}
+
+// this function generates markers somewhere along the edge of the grid, returning S_ERR_CONFIG if obstacles have left too few edge tiles for them
+static Status generate_marker_edge(Arena *arena, int numMarkers)
 {
     numMarkers = min(numMarkers, (arena->arenaHeight + arena->arenaWidth - 2)); // cap half the possible spaces
+    int emptyEdgeTiles = count_empty_edge_tiles(arena);
+    if (numMarkers > emptyEdgeTiles) {
+        fprintf(stderr, "Number of markers: %d exceeds the %d empty tiles along the edge\n", numMarkers, emptyEdgeTiles);
+        return S_ERR_CONFIG;
+    }
     for (int i = 0; i < numMarkers; i++) {
-        int x, y;
+        int x = 0, y = 0;
 
         do { // randomly choose a number from 0 to 4 to represent top, right, bottom or left (heuristic as for not very similar width/height, vertical or horizontal tiles have significantly higher chance of being selected)
             // each option includes the first tile for the section (e.g. top includes top left, right includes top right)
-            int r = rand() % 4;
+            int r = next_random(&arena->rng) % 4;
             if (r % 2 == 0) { // deal with top/bottom first
-                int pos = random_coord(arena->arenaWidth-1); // pos is an x position along top or bottom edge
+                int pos = random_coord(&arena->rng, arena->arenaWidth-1); // pos is an x position along top or bottom edge
                 if (r == 0) { x = pos; y = 0; } // top
                 if (r == 2) { x = pos+1; y = arena->arenaHeight-1; } // bottom
             }
             else { // then left/right
-                int pos = random_coord(arena->arenaHeight-1); // pos is a y position along left or right edge
+                int pos = random_coord(&arena->rng, arena->arenaHeight-1); // pos is a y position along left or right edge
                 if (r == 1) { x = arena->arenaWidth-1; y = pos; } // right
                 if (r == 3) { x = 0; y = pos+1; } // left
             }
-        } while (arena->arenaGrid[y][x] != T_EMPTY); // account for obstacles
+        } while (get_tile(&arena->arenaGrid, x, y) != T_EMPTY); // account for obstacles
 
-        arena->arenaGrid[y][x] = T_MARKER;
+        add_marker(arena, x, y);
+        arena->emptyTiles--;
     }
+    return S_OK;
 }
 
-// this function generates markers randomly; pre-requesite: obstacles have already been spawned
-static void generate_markers_random(Arena *arena, int numMarkers)
+// this function generates markers randomly, returning S_ERR_CONFIG if there are fewer empty tiles than markers; pre-requesite: obstacles have already been spawned
+static Status generate_markers_random(Arena *arena, int numMarkers)
 {
-    numMarkers = min(numMarkers, 2*arena->arenaWidth*arena->arenaHeight/3);
+    if (numMarkers > 2*(long long)arena->arenaWidth*arena->arenaHeight/3) numMarkers = 2*(long long)arena->arenaWidth*arena->arenaHeight/3;
+    if (numMarkers > arena->emptyTiles) { // e.g. inside a small cavern
+        fprintf(stderr, "Number of markers: %d exceeds the %lld empty tiles left\n", numMarkers, arena->emptyTiles);
+        return S_ERR_CONFIG;
+    }
     for (int i = 0; i < numMarkers; i++) {
         // generate (x, y) until (x, y) is an empty tile
         int x, y;
         do {
-            x = random_coord(arena->arenaWidth);
-            y = random_coord(arena->arenaHeight);
-        } while (arena->arenaGrid[y][x] != T_EMPTY);
+            x = random_coord(&arena->rng, arena->arenaWidth);
+            y = random_coord(&arena->rng, arena->arenaHeight);
+        } while (get_tile(&arena->arenaGrid, x, y) != T_EMPTY);
 
-        arena->arenaGrid[y][x] = T_MARKER;
+        add_marker(arena, x, y);
+        arena->emptyTiles--;
     }
+    return S_OK;
 }
 
-// this function determines which function to use to generate markers and then calls it; pass numMarkers = 0 if not needed
-void generate_markers(Arena *arena, int numMarkers, MarkerFormation formation)
+// this function determines which function to use to generate markers and then calls it, returning S_ERR_CONFIG if there is no room for them; pass numMarkers = 0 if not needed; the number actually placed (which may be capped) is counted in numMarker
+Status generate_markers(Arena *arena, int numMarkers, MarkerFormation formation)
 {
+    numMarkers = min(numMarkers, arena->markers.capacity);
     switch(formation) {
         case M_EDGE:
-            generate_marker_edge(arena, numMarkers);
-            arena->numMarker = numMarkers;
-            break;
+            return generate_marker_edge(arena, numMarkers);
         case M_RANDOM:
-            generate_markers_random(arena, numMarkers);
-            arena->numMarker = numMarkers;
+            return generate_markers_random(arena, numMarkers);
+    }
+    fprintf(stderr, "Unknown marker formation %d in generate_markers\n", formation);
+    return S_ERR_CONFIG;
+}
+
+// functions for the marker index:
+
+// this function returns where in the hash table a position's search starts (fibonacci hashing)
+static int marker_hash(MarkerIndex *index, long long position)
+{
+    unsigned long long hash = (unsigned long long)position * 11400714819323198485ull;
+    return (int)(hash >> 32) & (index->tableSize - 1);
+}
+
+// this function returns a tile's position as used as the key of the marker hash table
+static long long marker_key(Arena *arena, int x, int y)
+{
+    return (long long)y * arena->arenaWidth + x;
+}
+
+// this function returns the hash table entry for a marker at (x, y), or the empty entry where it would go
+static int find_marker_entry(Arena *arena, int x, int y)
+{
+    MarkerIndex *index = &arena->markers;
+    long long key = marker_key(arena, x, y);
+    int entry = marker_hash(index, key);
+
+    // linear probing, the table is never more than half full so there is always an empty entry
+    while (index->slots[entry] != -1) {
+        Coord pos = index->positions[index->slots[entry]];
+        if (pos.x == x && pos.y == y) return entry;
+        entry = (entry + 1) & (index->tableSize - 1);
+    }
+    return entry;
+}
+
+// this function empties a hash table entry, shifting back later entries in its probe sequence so lookups do not stop early
+static void remove_marker_entry(Arena *arena, int entry)
+{
+    MarkerIndex *index = &arena->markers;
+    int mask = index->tableSize - 1;
+    int next = (entry + 1) & mask;
+
+    while (index->slots[next] != -1) {
+        Coord pos = index->positions[index->slots[next]];
+        int home = marker_hash(index, marker_key(arena, pos.x, pos.y));
+
+        // move the entry back if the gap lies between its home and where it is now (cyclically)
+        if (((next - home) & mask) >= ((next - entry) & mask)) {
+            index->slots[entry] = index->slots[next];
+            entry = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->slots[entry] = -1;
+}
+
+// this function places a marker on the arena at (x, y) and adds it to the index; pre-requisite: tile is empty; returns S_ERR_INTERNAL if the index is full
+Status add_marker(Arena *arena, int x, int y)
+{
+    MarkerIndex *index = &arena->markers;
+    if (arena->numMarker >= index->capacity) {
+        fprintf(stderr, "Marker index is full (%d markers) in add_marker\n", index->capacity);
+        return S_ERR_INTERNAL;
+    }
+
+    int slot = arena->numMarker++;
+    index->positions[slot] = (Coord){x, y};
+    index->slots[find_marker_entry(arena, x, y)] = slot;
+    set_tile(&arena->arenaGrid, x, y, T_MARKER);
+    return S_OK;
+}
+
+// this function takes the marker at (x, y) off the arena and out of the index, moving the last marker into its slot; pre-requisite: there is a marker at (x, y)
+void remove_marker(Arena *arena, int x, int y)
+{
+    MarkerIndex *index = &arena->markers;
+    int entry = find_marker_entry(arena, x, y);
+    int slot = index->slots[entry];
+    remove_marker_entry(arena, entry);
+
+    // fill the gap in the dense array with the last marker
+    int last = --arena->numMarker;
+    if (slot != last) {
+        Coord moved = index->positions[last];
+        index->positions[slot] = moved;
+        index->slots[find_marker_entry(arena, moved.x, moved.y)] = slot;
+    }
+    set_tile(&arena->arenaGrid, x, y, T_EMPTY);
+}
+
+// this function checks the index for a marker at (x, y)
+int is_marker_at(Arena *arena, int x, int y)
+{
+    return arena->markers.slots[find_marker_entry(arena, x, y)] != -1;
+}
+
+// this function returns the marker left on the arena closest (by number of tiles moved, ignoring obstacles) to a position within a straight line radius of it, or {-1, -1} if there are none; a radius of -1 allows any distance
+Coord nearest_marker(Arena *arena, Coord from, int radius)
+{
+    Coord nearest = {-1, -1};
+    int nearestDist = 0;
+    long long radiusSquared = (long long)radius * radius; // squares of distances across a wide arena do not fit in an int
+    for (int i = 0; i < arena->numMarker; i++) {
+        Coord pos = arena->markers.positions[i];
+        long long dx = pos.x - from.x;
+        long long dy = pos.y - from.y;
+        if (radius != -1 && dx*dx + dy*dy > radiusSquared) continue;
+
+        int dist = abs(pos.x - from.x) + abs(pos.y - from.y);
+        if (nearest.x == -1 || dist < nearestDist) {
+            nearest = pos;
+            nearestDist = dist;
+        }
+    }
+    return nearest;
+}
+
+// this function sets the tile markers are delivered to, reserving it so no marker or obstacle is put there later; a depot of {-1, -1}, or one on a tile that is already taken (with a warning), is put on the robot's start instead
+void place_depot(Arena *arena, Coord depot, Coord start)
+{
+    if (depot.x == -1 && depot.y == -1) depot = start;
+    if (depot.x != start.x || depot.y != start.y) {
+        if (get_tile(&arena->arenaGrid, depot.x, depot.y) != T_EMPTY) {
+            fprintf(stderr, "Depot set to the robot's start (%d, %d) as given tile (%d, %d) is not empty\n", start.x, start.y, depot.x, depot.y);
+            depot = start;
+        }
+        else {
+            set_tile(&arena->arenaGrid, depot.x, depot.y, T_DEPOT);
+            arena->emptyTiles--;
+        }
+    }
+    arena->depot = depot;
+}
+
+// functions for obstacles that change during the search:
+
+// this function checks that scripted events are in order of step and on tiles inside the arena, returning S_ERR_CONFIG if not
+Status check_obstacle_events(Arena *arena, const ObstacleEvent *events, int numEvents)
+{
+    for (int i = 0; i < numEvents; i++) {
+        Coord tile = {events[i].x, events[i].y};
+        if (!check_coord_in_bounds(tile, arena->arenaWidth, arena->arenaHeight)) {
+            fprintf(stderr, "Obstacle event %d at (%d, %d) is outside the arena\n", i, tile.x, tile.y);
+            return S_ERR_CONFIG;
+        }
+        if (events[i].step < 0 || (i > 0 && events[i].step < events[i-1].step)) {
+            fprintf(stderr, "Obstacle event %d at step %lld is out of order\n", i, events[i].step);
+            return S_ERR_CONFIG;
+        }
+    }
+    return S_OK;
+}
+
+// this function applies every event due by the current step and then counts the step; an obstacle is never put on the robot's tile, a marker or the robot's start, so those events are skipped; returns how many tiles changed
+int apply_obstacle_events(Arena *arena, Coord robot)
+{
+    int changed = 0;
+    while (arena->nextEvent < arena->numEvents && arena->events[arena->nextEvent].step <= arena->step) {
+        const ObstacleEvent *event = &arena->events[arena->nextEvent++];
+        ArenaTile tile = get_tile(&arena->arenaGrid, event->x, event->y);
+        if (event->blocked && tile == T_EMPTY && (event->x != robot.x || event->y != robot.y)) {
+            set_tile(&arena->arenaGrid, event->x, event->y, T_OBSTACLE);
+            changed++;
+        }
+        else if (!event->blocked && tile == T_OBSTACLE) {
+            set_tile(&arena->arenaGrid, event->x, event->y, T_EMPTY);
+            changed++;
+        }
+    }
+    arena->step++;
+    arena->changes += changed;
+    return changed;
+}
+
+// this function checks if any scripted events are still to come
+int obstacle_events_pending(Arena *arena)
+{
+    return arena->nextEvent < arena->numEvents;
+}
+
+// this function reads scripted events from a text file with one event per line, "<step> <x> <y> block" or "<step> <x> <y> clear", skipping blank lines and lines starting with #; the events are malloced and the caller has responsibility to free them
+Status load_obstacle_events(const char *path, ObstacleEvent **events, int *numEvents)
+{
+    *events = NULL;
+    *numEvents = 0;
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open obstacle events file %s\n", path);
+        return S_ERR_IO;
+    }
+
+    int capacity = 0;
+    char line[256];
+    int lineNumber = 0;
+    Status status = S_OK;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        ObstacleEvent event;
+        char action[16];
+        char first;
+        if (sscanf(line, " %c", &first) != 1 || first == '#') continue;
+        if (sscanf(line, "%lld %d %d %15s", &event.step, &event.x, &event.y, action) != 4 || (strcmp(action, "block") != 0 && strcmp(action, "clear") != 0)) {
+            fprintf(stderr, "Could not read obstacle event on line %d of %s\n", lineNumber, path);
+            status = S_ERR_CONFIG;
             break;
+        }
+        event.blocked = strcmp(action, "block") == 0;
+
+        if (*numEvents == capacity) { // double the array as events are read
+            capacity = capacity == 0 ? 64 : 2*capacity;
+            ObstacleEvent *grown = realloc(*events, capacity * sizeof(ObstacleEvent));
+            if (grown == NULL) {
+                fprintf(stderr, "Realloc returned null in load_obstacle_events\n");
+                status = S_ERR_ALLOC;
+                break;
+            }
+            *events = grown;
+        }
+        (*events)[(*numEvents)++] = event;
     }
+    fclose(file);
+
+    if (status != S_OK) {
+        free(*events);
+        *events = NULL;
+        *numEvents = 0;
+    }
+    return status;
 }
 
 // functions to deal with arena struct:
 
 // functions called from main:
 
-// this function allocates memory for robot's memory
-static void allocate_arena_grid(Arena *arena)
+// this function returns the size of the marker index hash table, the smallest power of two at least twice the capacity
+static int marker_table_size(int capacity)
 {
-    // get width and height for ease
-    int width = arena->arenaWidth;
-    int height = arena->arenaHeight;
-
-    // allocate memory for row pointers
-    arena->arenaGrid = calloc(height, sizeof(ArenaTile*));
-    if (arena->arenaGrid == NULL) {
-        printf("Malloc returned null for row pointers in allocate_arena_grid\n");
-        exit(EXIT_FAILURE);
-    }
-
-    // allocate each row
-    for (int i = 0; i < height; i++) {
-        arena->arenaGrid[i] = calloc(width, sizeof(ArenaTile));
-        if (arena->arenaGrid[i] == NULL) {
-            fprintf(stderr, "Calloc returned null for a row in arenaGrid in allocate_arena_grid\n");
-            // free already allocated memory
-            for (int j = 0; j < i; j++) {
-                free(arena->arenaGrid[j]);
-            }
-            free(arena->arenaGrid);
-            exit(EXIT_FAILURE);
-        }
+    int size = 1;
+    while (size < 2*capacity) size *= 2;
+    return size;
+}
+
+// this function allocates the marker index from the pool with every hash table entry empty, returning S_ERR_ALLOC on failure
+static Status allocate_marker_index(Pool *pool, Arena *arena, int capacity)
+{
+    MarkerIndex *index = &arena->markers;
+    index->capacity = capacity;
+    index->tableSize = marker_table_size(capacity);
+    index->positions = pool_alloc(pool, (capacity > 0 ? capacity : 1) * sizeof(Coord));
+    index->slots = pool_alloc(pool, index->tableSize * sizeof(int));
+    if (index->positions == NULL || index->slots == NULL) {
+        fprintf(stderr, "Pool has no space for marker index in allocate_marker_index\n");
+        return S_ERR_ALLOC;
+    }
+
+    for (int i = 0; i < index->tableSize; i++) {
+        index->slots[i] = -1;
     }
+    return S_OK;
+}
+
+// this function returns how many bytes of pool create_arena needs for an arena of the given size and grid layout holding up to maxMarkers markers
+size_t arena_pool_size(int width, int height, int maxMarkers, GridLayout layout)
+{
+    maxMarkers = max(maxMarkers, 0);
+    return pool_aligned_size(sizeof(Arena))
+        + tile_grid_pool_size(width, height, 1, layout)
+        + pool_aligned_size((maxMarkers > 0 ? maxMarkers : 1) * sizeof(Coord))
+        + pool_aligned_size(marker_table_size(maxMarkers) * sizeof(int));
 }
 
-// this function creates an arena struct; pre-requisite: arena dimensions already set; caller has responsibility to free
-Arena* create_arena(int width, int height)
+// this function creates an arena struct from the pool, able to hold up to maxMarkers markers, whose random generation uses the given seed; returns NULL if the pool does not have space; freed when the pool is reset, after release_arena for a sparse grid
+Arena* create_arena(Pool *pool, int width, int height, int maxMarkers, unsigned int seed, GridLayout layout)
 {
     // allocate memory
-    Arena* arena = malloc(sizeof(Arena));
+    Arena* arena = pool_alloc(pool, sizeof(Arena));
     if (arena == NULL) {
-        fprintf(stderr, "Malloc returned null in create_arena\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Pool has no space in create_arena\n");
+        return NULL;
     }
-    arena->numMarker = 0; // this will get changed to real value in later function
+    arena->numMarker = 0; // counted as markers are added
     arena->arenaWidth = width;
     arena->arenaHeight = height;
-    allocate_arena_grid(arena); // allocate memory for arenaGrid
+    seed_rng(&arena->rng, seed);
+    arena->events = NULL; // set by the caller if the arena changes during the search
+    arena->numEvents = 0;
+    arena->nextEvent = 0;
+    arena->step = 0;
+    arena->changes = 0;
+    arena->depot = (Coord){-1, -1}; // set by place_depot when markers are delivered
+    arena->numDelivered = 0;
+    arena->emptyTiles = (long long)width * height; // taken off as obstacles, the robot, the depot and markers are placed
+    if (create_tile_grid(&arena->arenaGrid, pool, width, height, 1, layout) != S_OK) { // every tile starts as T_EMPTY
+        return NULL;
+    }
+    if (allocate_marker_index(pool, arena, max(maxMarkers, 0)) != S_OK) {
+        return NULL;
+    }
 
     return arena;
 }
 
-// this function frees arenaGrid memory
-static void free_arena_grid(Arena *arena)
-{
-    for (int i = 0; i < arena->arenaHeight; i++) {
-        free(arena->arenaGrid[i]);
-    }
-    free(arena->arenaGrid);
-}
-
-// this function frees overall arena struct memory
-void free_arena(Arena *arena)
+// this function frees anything the arena allocated outside the pool, i.e. the chunks of a sparse grid; must be called before the pool is reset
+void release_arena(Arena *arena)
 {
-    free_arena_grid(arena);
-    free(arena);
+    release_tile_grid(&arena->arenaGrid);
 }
 
 // functions to determine arena size:
@@ -0,0 +1,225 @@
+// This file moves writing the drawapp commands to the output sink onto its own thread, so the search does not stall whenever the drawapp is slow to read them
+
+#include "../include/async_output.h"
+#include "../include/utils.h"
+
+#include "../lib/graphics.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// commands are gathered into a frame by the simulation thread and committed whole into a single producer single consumer ring buffer, which the writer thread drains to the output sink
+typedef struct {
+    char *ring;
+    size_t capacity; // a power of two
+    atomic_size_t head; // total bytes taken by the writer thread
+    atomic_size_t tail; // total bytes committed by the simulation thread
+    OutputPolicy policy;
+
+    char *frame; // commands since the last frame boundary, not yet committed
+    size_t frameLength;
+    size_t frameCapacity;
+    int holding; // the frame is complete but did not fit, so it waits for the next one to start before being dropped
+    long droppedFrames;
+
+    pthread_t writer;
+    pthread_mutex_t lock; // only used to sleep when the ring is full or empty
+    pthread_cond_t changed;
+    int stopping;
+    int running;
+} AsyncOutput;
+
+static AsyncOutput output;
+
+// functions run on the writer thread:
+
+// this function writes committed bytes to the output sink until the ring is empty and the simulation has stopped output
+static void* writer_thread(void *arg)
+{
+    (void)arg;
+    while (1) {
+        size_t head = atomic_load_explicit(&output.head, memory_order_relaxed);
+        size_t tail = atomic_load_explicit(&output.tail, memory_order_acquire);
+
+        if (head == tail) {
+            pthread_mutex_lock(&output.lock);
+            while (atomic_load_explicit(&output.tail, memory_order_acquire) == head && !output.stopping) {
+                pthread_cond_wait(&output.changed, &output.lock);
+            }
+            int done = output.stopping && atomic_load_explicit(&output.tail, memory_order_acquire) == head;
+            pthread_mutex_unlock(&output.lock);
+            if (done) break;
+            continue;
+        }
+
+        // write the bytes up to the end of the ring, the rest on the next loop
+        size_t start = head & (output.capacity - 1);
+        size_t length = tail - head;
+        if (length > output.capacity - start) length = output.capacity - start;
+        writeOutput(output.ring + start, length);
+        flushOutput();
+
+        atomic_store_explicit(&output.head, head + length, memory_order_release);
+        pthread_mutex_lock(&output.lock);
+        pthread_cond_signal(&output.changed);
+        pthread_mutex_unlock(&output.lock);
+    }
+    flushOutput();
+    return NULL;
+}
+
+// functions run on the simulation thread:
+
+// this function returns how many bytes can be committed without overwriting any the writer has not taken
+static size_t ring_space(void)
+{
+    return output.capacity - (atomic_load_explicit(&output.tail, memory_order_relaxed) - atomic_load_explicit(&output.head, memory_order_acquire));
+}
+
+// this function copies bytes into the ring, waiting for the writer thread whenever it is full
+static void ring_write(const char *bytes, size_t length)
+{
+    while (length > 0) {
+        size_t space = ring_space();
+        if (space == 0) {
+            pthread_mutex_lock(&output.lock);
+            while (ring_space() == 0) pthread_cond_wait(&output.changed, &output.lock);
+            pthread_mutex_unlock(&output.lock);
+            continue;
+        }
+
+        size_t tail = atomic_load_explicit(&output.tail, memory_order_relaxed);
+        size_t start = tail & (output.capacity - 1);
+        size_t chunk = length < space ? length : space;
+        if (chunk > output.capacity - start) chunk = output.capacity - start;
+        memcpy(output.ring + start, bytes, chunk);
+        atomic_store_explicit(&output.tail, tail + chunk, memory_order_release);
+
+        pthread_mutex_lock(&output.lock);
+        pthread_cond_signal(&output.changed);
+        pthread_mutex_unlock(&output.lock);
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+// this function commits the frame gathered so far, or drops it if the ring is full and it can be dropped; a complete frame that may be held is kept back instead, so the last frame drawn is never dropped
+static void commit_frame(int canHold)
+{
+    if (output.frameLength == 0) return;
+
+    // only foreground frames (starting with a clear) can be dropped, as the next one redraws everything they drew
+    int droppable = output.frameLength >= 3 && memcmp(output.frame, "CL\n", 3) == 0;
+    if (output.policy == AO_DROP && droppable && ring_space() < output.frameLength) {
+        if (canHold) {
+            output.holding = 1;
+            return;
+        }
+        output.droppedFrames++;
+    }
+    else {
+        ring_write(output.frame, output.frameLength);
+    }
+    output.frameLength = 0;
+    output.holding = 0;
+}
+
+// this function gathers one command from the graphics library into the current frame; frames end before a clear and after a sleep
+static void gather_command(const char *text, int length)
+{
+    if (length >= 2 && memcmp(text, "CL", 2) == 0) {
+        commit_frame(0); // a held frame is only dropped now that the next one redraws it
+    }
+    else if (output.holding) { // anything but a new frame must follow the held one, so wait for it to fit
+        ring_write(output.frame, output.frameLength);
+        output.frameLength = 0;
+        output.holding = 0;
+    }
+
+    if (output.frameLength + length > output.frameCapacity) {
+        size_t newCapacity = output.frameCapacity * 2;
+        while (newCapacity < output.frameLength + length) newCapacity *= 2;
+        char *frame = realloc(output.frame, newCapacity);
+        if (frame == NULL) { // cannot gather any more, so send what there is on
+            commit_frame(0);
+            ring_write(text, length);
+            return;
+        }
+        output.frame = frame;
+        output.frameCapacity = newCapacity;
+    }
+    memcpy(output.frame + output.frameLength, text, length);
+    output.frameLength += length;
+
+    if (length >= 2 && memcmp(text, "SL", 2) == 0) commit_frame(1);
+}
+
+// this function starts the writer thread and sends all drawing through it, with a ring buffer of at least the given size; returns S_ERR_ALLOC if it could not be started, leaving drawing going straight to the output sink
+Status start_async_output(size_t capacity, OutputPolicy policy)
+{
+    if (output.running) return S_OK;
+
+    output.capacity = 1;
+    while (output.capacity < capacity) output.capacity *= 2;
+    output.ring = malloc(output.capacity);
+    output.frameCapacity = 4096;
+    output.frame = malloc(output.frameCapacity);
+    if (output.ring == NULL || output.frame == NULL) {
+        fprintf(stderr, "Malloc returned null in start_async_output\n");
+        free(output.ring);
+        free(output.frame);
+        return S_ERR_ALLOC;
+    }
+    atomic_init(&output.head, 0);
+    atomic_init(&output.tail, 0);
+    output.policy = policy;
+    output.frameLength = 0;
+    output.holding = 0;
+    output.droppedFrames = 0;
+    output.stopping = 0;
+    pthread_mutex_init(&output.lock, NULL);
+    pthread_cond_init(&output.changed, NULL);
+
+    flushOutput(); // anything already printed must go before what the writer thread prints
+    if (pthread_create(&output.writer, NULL, writer_thread, NULL) != 0) {
+        fprintf(stderr, "Could not create writer thread in start_async_output\n");
+        pthread_mutex_destroy(&output.lock);
+        pthread_cond_destroy(&output.changed);
+        free(output.ring);
+        free(output.frame);
+        return S_ERR_ALLOC;
+    }
+    output.running = 1;
+    setOutputWriter(gather_command);
+    return S_OK;
+}
+
+// this function sends the last frame, waits for the writer thread to write everything and sends drawing straight to the output sink again
+void stop_async_output(void)
+{
+    if (!output.running) return;
+    setOutputWriter(NULL);
+    output.policy = AO_BLOCK; // never drop the last frame, as it is left on screen
+    commit_frame(0);
+
+    pthread_mutex_lock(&output.lock);
+    output.stopping = 1;
+    pthread_cond_signal(&output.changed);
+    pthread_mutex_unlock(&output.lock);
+    pthread_join(output.writer, NULL);
+
+    pthread_mutex_destroy(&output.lock);
+    pthread_cond_destroy(&output.changed);
+    free(output.ring);
+    free(output.frame);
+    output.running = 0;
+}
+
+// this function returns how many frames have been dropped because the buffer was full
+long async_output_dropped_frames(void)
+{
+    return output.droppedFrames;
+}
@@ -1,5 +1,6 @@
 #include "../include/config.h"
 #include "../include/arena.h"
+#include "../include/async_output.h"
 
 const int DEFAULT_ARENA_WIDTH = 16;
 const int DEFAULT_ARENA_HEIGHT = 16;
@@ -16,9 +17,35 @@ const int MAX_WINDOW_HEIGHT = 800; // good value for 1080p display
 
 // meant to be changed between program compilations
 const int TIME_INTERVAL = 60;
+const int FRAME_SKIP = 1; // draw every Nth robot action (marker pickups are always drawn), must be at least 1
+const int TARGET_DURATION = 0; // miliseconds the whole search should take to animate, 0 to always wait TIME_INTERVAL per frame
+const int TERMINAL_OUTPUT = 0; // 1 to draw in the terminal with ANSI escape codes instead of for the drawapp (run without piping into it), following the robot when the arena is bigger than the terminal
+const int PROFILE_PHASES = 0; // 1 to time each phase of the run and print a summary to stderr at exit
+const char *const VISIT_IMAGE_FILE = ""; // e.g. "visits.ppm" to write a heatmap of how many times each tile was moved onto at the end of the run, "" for none
+const char *const VISIT_CSV_FILE = ""; // e.g. "visits.csv" to write the same counts as CSV, "" for none
+const char *const OBSTACLE_EVENTS_FILE = ""; // e.g. "doors.txt" to change obstacles during the search, one "<step> <x> <y> block|clear" per line in order of step, "" for an arena that never changes
+const char *const SNAPSHOT_FILE = ""; // e.g. "run.snap" to save the whole state of the run every SNAPSHOT_INTERVAL actions and at the end, "" for none
+const int SNAPSHOT_INTERVAL = 10000;
+const char *const RESUME_FILE = ""; // e.g. "run.snap" to carry on from a snapshot saved there instead of starting a new run, if the file exists
+const int ASYNC_OUTPUT = 1; // 1 to write to the drawapp from a separate thread so the search does not wait on it, 0 to write directly
+const int OUTPUT_BUFFER_SIZE = 1 << 20; // bytes of drawing that can be waiting to be written
+const OutputPolicy OUTPUT_POLICY = AO_BLOCK; // AO_BLOCK to wait when the buffer is full, AO_DROP to skip frames instead
+const char *const OUTPUT_SINK = "stdout"; // where drawing goes: "stdout", "null", "file:PATH" to save it for replay, "ppm:PATH" or "gif:PATH" to render it to images, or "unix:PATH" to serve it on a socket a viewer can attach to; the DRAW_OUTPUT environment variable overrides this
 
 const ObstacleFormation obstacleFormation = O_RANDOM; // O_NONE, O_RANDOM, O_WALL, O_CAVERN
 const unsigned int numObstacles = 12; // has no impact when O_CAVERN, also must be less than 1/3 number of tiles in grid, does not matter when O_CAVERN
 
 const MarkerFormation markerFormation = M_RANDOM; // M_EDGE, M_RANDOM - M_RANDOM used in real usage, M_EDGE just for stage 1
-const unsigned int numMarkers = 8; // must be less than 2/3 number of tiles in grid
\ No newline at end of file
+const unsigned int numMarkers = 8; // must be less than 2/3 number of tiles in grid
+
+const int senseRadius = 0; // markers within this many tiles are sensed and moved to directly before carrying on with the spiral, 0 for the pure spiral
+const GridLayout gridLayout = G_DENSE; // G_DENSE to store every tile up front row by row, G_TILED or G_MORTON to store every tile up front in blocks so tiles above and below are closer in memory, G_SPARSE to store the arena and robot's memory in 64x64 chunks allocated as they are used, so huge mostly empty arenas only use memory for what is explored (route planning, tours and drawing still use memory for every tile)
+const int knownArena = 0; // 1 to give the robot the obstacles and markers up front so it follows the shortest tour to them instead of searching
+const int hierarchicalRoutes = 0; // 1 to find long routes (e.g. backtracking to a far tile on the path) through a graph of 16x16 sectors kept up to date as obstacles are found, rather than searching every tile; routes may be a few moves longer
+const int jumpPointRoutes = 0; // 1 to find routes with jump point search, which skips along open rows rather than expanding every tile (the routes are just as short)
+const int incrementalRoutes = 0; // 1 to find routes with an incremental search (D* Lite) that is repaired around tiles that change rather than searched again, most useful with OBSTACLE_EVENTS_FILE
+const int turnAwareRoutes = 0; // 1 to plan routes by moves and turns, and to backtrack by routing to the quickest unknown tile instead of retracing the path
+const int routeMoveCost = 1; // with routeTurnCost, how long a move and a turn take relative to each other, each is one frame by default
+const int routeTurnCost = 1;
+const int carryCapacity = 0; // markers the robot can carry before it has to take them back to the depot (and it takes the last ones back once every marker is picked up), 0 to keep every marker it picks up
+const Coord deliveryDepot = {-1, -1}; // tile markers are taken back to when carryCapacity is set, {-1, -1} for the robot's start
\ No newline at end of file
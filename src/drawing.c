@@ -3,6 +3,8 @@
 #include "../include/arena.h"
 #include "../include/config.h"
 #include "../include/drawing.h"
+#include "../include/profile.h"
+#include "../include/terminal.h"
 
 #include "../lib/graphics.h"
 
@@ -12,87 +14,140 @@
 
 #define PI 3.141592653
 
-// these are determined by arena dimensions and TILE_SIZE and BORDER_THICKNESS
+// these are determined by arena dimensions and tile size and BORDER_THICKNESS
 int WINDOW_WIDTH = 0;
 int WINDOW_HEIGHT = 0;
 
+// settings for drawing, set with set_draw_config before anything is drawn
+static DrawConfig drawConfig;
+
+// these keep track of the foreground animation so frames can be skipped and the sleep scaled to the target duration; reset in draw_background
+static int actionCount = 0; // calls to draw_foreground
+static int lastMarkerCount = 0; // markers on the arena when the last frame was drawn
+static int skippedFrame = 0; // 1 if the last action was not drawn, so finish_drawing has to draw it
+static long sleptTime = 0; // total miliseconds of sleep sent to drawapp
+
+// this function fills a draw config with the default values from config.c
+void default_draw_config(DrawConfig *config)
+{
+    config->tileSize = TILE_SIZE;
+    config->timeInterval = TIME_INTERVAL;
+    config->frameSkip = FRAME_SKIP;
+    config->targetDuration = TARGET_DURATION;
+    config->terminal = TERMINAL_OUTPUT;
+}
+
+// this function sets the settings used for drawing from now on
+void set_draw_config(const DrawConfig *config)
+{
+    drawConfig = *config;
+}
+
 // this function calculates window dimensions (width and height); pre-requesite: arenaWidth and arenaHeight are less than their maximum values
 static void calculate_window_dimensions(Arena *arena) 
 {
-    WINDOW_WIDTH = 2*BORDER_THICKNESS + TILE_SIZE*arena->arenaWidth;
-    WINDOW_HEIGHT = 2*BORDER_THICKNESS + TILE_SIZE*arena->arenaHeight;
+    WINDOW_WIDTH = 2*BORDER_THICKNESS + drawConfig.tileSize*arena->arenaWidth;
+    WINDOW_HEIGHT = 2*BORDER_THICKNESS + drawConfig.tileSize*arena->arenaHeight;
 }
 
-// this function calculates the maximum arenaWidth for the screen, taking into account tile size and display width
+// this function calculates the maximum arenaWidth for the screen, taking into account tile size and display width; the terminal scrolls so is not limited by the display
 int calculate_max_arena_width()
 {
-    return (MAX_WINDOW_WIDTH - 2*BORDER_THICKNESS) / TILE_SIZE; // integer division on purpose
+    if (drawConfig.terminal) return TERMINAL_MAX_ARENA_SIZE;
+    return (MAX_WINDOW_WIDTH - 2*BORDER_THICKNESS) / drawConfig.tileSize; // integer division on purpose
 }
 
-// this function calculates the maximum arenaHeight for the screen, taking into account tile size and max display height
+// this function calculates the maximum arenaHeight for the screen, taking into account tile size and max display height; the terminal scrolls so is not limited by the display
 int calculate_max_arena_height() 
 {
-    return (MAX_WINDOW_HEIGHT - 2*BORDER_THICKNESS) / TILE_SIZE; // integer division on purpose
+    if (drawConfig.terminal) return TERMINAL_MAX_ARENA_SIZE;
+    return (MAX_WINDOW_HEIGHT - 2*BORDER_THICKNESS) / drawConfig.tileSize; // integer division on purpose
 }
 
-// this function draws the red border around the screen
+// this function draws the red border around the screen, with the black outer edge of the grid drawn as one frame inside it rather than as four grid lines
 static void draw_border(Arena *arena) 
 {
     setColour(red);
     fillRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    setColour(black);
+    fillRect(BORDER_THICKNESS-1, BORDER_THICKNESS-1, WINDOW_WIDTH-2*BORDER_THICKNESS+2, WINDOW_HEIGHT-2*BORDER_THICKNESS+2);
     setColour(white);
-    fillRect(BORDER_THICKNESS, BORDER_THICKNESS, WINDOW_WIDTH-2*BORDER_THICKNESS, WINDOW_HEIGHT-2*BORDER_THICKNESS);
+    fillRect(BORDER_THICKNESS+1, BORDER_THICKNESS+1, WINDOW_WIDTH-2*BORDER_THICKNESS-2, WINDOW_HEIGHT-2*BORDER_THICKNESS-2);
 }
 
-// this function draws the black grid across the screen of width 2
+// this function draws the black inner grid lines across the screen of width 2; the outer edge is drawn by draw_border
 static void draw_grid(Arena *arena)
 {
     setColour(black);
     // vertical lines first
-    for (int i = 0; i < arena->arenaWidth + 1; i++) {
-        fillRect(BORDER_THICKNESS+i*TILE_SIZE-1, BORDER_THICKNESS, 2, WINDOW_HEIGHT-2*BORDER_THICKNESS);
+    for (int i = 1; i < arena->arenaWidth; i++) {
+        fillRect(BORDER_THICKNESS+i*drawConfig.tileSize-1, BORDER_THICKNESS, 2, WINDOW_HEIGHT-2*BORDER_THICKNESS);
     }
 
     // horizontal lines second
-    for (int i = 0; i < arena->arenaHeight + 1; i++) {
-        fillRect(BORDER_THICKNESS, BORDER_THICKNESS+i*TILE_SIZE-1, WINDOW_WIDTH-2*BORDER_THICKNESS, 2);
+    for (int i = 1; i < arena->arenaHeight; i++) {
+        fillRect(BORDER_THICKNESS, BORDER_THICKNESS+i*drawConfig.tileSize-1, WINDOW_WIDTH-2*BORDER_THICKNESS, 2);
     }
 }
 
-// this function draws a single obstacle at arena position (x, y)
-static void draw_obstacle(int x, int y) 
+// this function draws a block of obstacles covering arena positions (x0, y0) to (x1, y1) inclusive as one rectangle; pre-requisite: colour set
+static void draw_obstacle_block(int x0, int y0, int x1, int y1) 
 {
-    // convert arena position (x, y) to coordinates for top left of shape
-    int coordX = BORDER_THICKNESS + x*TILE_SIZE + OBJECT_PADDING;
-    int coordY = BORDER_THICKNESS + y*TILE_SIZE + OBJECT_PADDING;
-    int obstacle_size = TILE_SIZE-2*OBJECT_PADDING;
+    // convert arena positions to coordinates for top left of shape, padding only the outside of the block
+    int coordX = BORDER_THICKNESS + x0*drawConfig.tileSize + OBJECT_PADDING;
+    int coordY = BORDER_THICKNESS + y0*drawConfig.tileSize + OBJECT_PADDING;
+    int blockWidth = (x1-x0+1)*drawConfig.tileSize-2*OBJECT_PADDING;
+    int blockHeight = (y1-y0+1)*drawConfig.tileSize-2*OBJECT_PADDING;
 
-    // draw
-    setColour(black);
-    fillRect(coordX, coordY, obstacle_size, obstacle_size);
+    fillRect(coordX, coordY, blockWidth, blockHeight);
+}
+
+// this function checks if x0 to x1 on row y is a whole run of obstacles, i.e. with no obstacle just before or after it
+static int is_obstacle_run(Arena *arena, int y, int x0, int x1)
+{
+    if (y < 0 || y >= arena->arenaHeight) return 0;
+    if (x0 > 0 && get_tile(&arena->arenaGrid, x0-1, y) == T_OBSTACLE) return 0;
+    if (x1 < arena->arenaWidth-1 && get_tile(&arena->arenaGrid, x1+1, y) == T_OBSTACLE) return 0;
+    for (int x = x0; x <= x1; x++) {
+        if (get_tile(&arena->arenaGrid, x, y) != T_OBSTACLE) return 0;
+    }
+    return 1;
 }
 
-// this function iterates over arenaGrid and calls the function to render obstacles
+// this function iterates over arenaGrid and draws obstacles merged into as few rectangles as possible: runs along each row, then identical runs in the rows below
 static void draw_obstacles(Arena *arena)
 {
+    setColour(black);
     for (int y = 0; y < arena->arenaHeight; y++) {
-        for (int x = 0; x < arena->arenaWidth; x++) {
-            if (arena->arenaGrid[y][x] == T_OBSTACLE) {
-                draw_obstacle(x, y);
+        int x = 0;
+        while (x < arena->arenaWidth) {
+            if (get_tile(&arena->arenaGrid, x, y) != T_OBSTACLE) {
+                x++;
+                continue;
             }
+
+            // find the end of the run along the row
+            int x0 = x;
+            while (x+1 < arena->arenaWidth && get_tile(&arena->arenaGrid, x+1, y) == T_OBSTACLE) x++;
+            int x1 = x;
+            x++;
+
+            // a run identical to one in the row above has already been drawn as part of that block
+            if (is_obstacle_run(arena, y-1, x0, x1)) continue;
+
+            // extend the block down while the rows below have exactly the same run
+            int y1 = y;
+            while (is_obstacle_run(arena, y1+1, x0, x1)) y1++;
+
+            draw_obstacle_block(x0, y, x1, y1);
         }
     }
 }
 
-// this function returns a pointer to an array of Points representing the vertices of an equilateral triangle with its base at the bottom
-static Point* equ_triangle_coords(double triangle_circumrad)
+// this function fills an array of 3 Points with the vertices of an equilateral triangle with its base at the bottom
+static void equ_triangle_coords(double triangle_circumrad, Point vertices[3])
 {
     // a triangle's circumradius is the distance from the center to any vertex
-    Point *vertices = malloc(3 * sizeof(Point));
-    if (vertices == NULL) {
-        fprintf(stderr, "Malloc returned null in equ_triangle_coords\n");
-        exit(EXIT_FAILURE);
-    }
 
     vertices[0].x = triangle_circumrad*cos(PI/2);
     vertices[0].y = triangle_circumrad*sin(PI/2) - OBJECT_PADDING/2; // - OBJECT_PADDING/2 just to visually center it a bit better
@@ -100,20 +155,13 @@ static Point* equ_triangle_coords(double triangle_circumrad)
     vertices[1].y = triangle_circumrad*sin(-PI/6) - OBJECT_PADDING/2;
     vertices[2].x = triangle_circumrad*cos(7*PI/6);
     vertices[2].y = triangle_circumrad*sin(7*PI/6) - OBJECT_PADDING/2;
-
-    return vertices;
 }
 
-// this function returns a pointer to an array of Points representing the vertices of the rectangle with its base at the bottom
-static Point* rect_coords(double triangle_circumrad)
+// this function fills an array of 4 Points with the vertices of the rectangle with its base at the bottom
+static void rect_coords(double triangle_circumrad, Point vertices[4])
 {
     // a triangle's circumradius is the distance from the center to any vertex
     // not a feature of the rectangle, but used for scaling
-    Point *vertices = malloc(4 * sizeof(Point));
-    if (vertices == NULL) {
-        fprintf(stderr, "Malloc returned null in equ_triangle_coords\n");
-        exit(EXIT_FAILURE);
-    }
 
     vertices[0].x = -triangle_circumrad;
     vertices[0].y = triangle_circumrad*sin(-PI/6) - OBJECT_PADDING/2; // bottom of triangle
@@ -123,8 +171,6 @@ static Point* rect_coords(double triangle_circumrad)
     vertices[2].y = triangle_circumrad*sin(-PI/6) - OBJECT_PADDING/2 - triangle_circumrad*0.3;
     vertices[3].x = -triangle_circumrad;
     vertices[3].y = triangle_circumrad*sin(7*PI/6) - OBJECT_PADDING/2 - triangle_circumrad*0.3;
-
-    return vertices;
 }
 
 // this function rotates a single point around the origin
@@ -159,8 +205,8 @@ static void draw_triangle(Point* vertices, int x, int y)
     int numVertices = 3;
 
     // convert from arenaGrid x,y to coordinate x, y
-    int offsetX = BORDER_THICKNESS + x*TILE_SIZE + 0.5*TILE_SIZE;
-    int offsetY = BORDER_THICKNESS + y*TILE_SIZE + 0.5*TILE_SIZE;
+    int offsetX = BORDER_THICKNESS + x*drawConfig.tileSize + 0.5*drawConfig.tileSize;
+    int offsetY = BORDER_THICKNESS + y*drawConfig.tileSize + 0.5*drawConfig.tileSize;
 
     int xCoords[3];
     int yCoords[3];
@@ -180,8 +226,8 @@ static void draw_rectangle(Point* vertices, int x, int y)
     int numVertices = 4;
 
     // convert from arenaGrid x,y to coordinate x, y
-    int offsetX = BORDER_THICKNESS + x*TILE_SIZE + 0.5*TILE_SIZE;
-    int offsetY = BORDER_THICKNESS + y*TILE_SIZE + 0.5*TILE_SIZE;
+    int offsetX = BORDER_THICKNESS + x*drawConfig.tileSize + 0.5*drawConfig.tileSize;
+    int offsetY = BORDER_THICKNESS + y*drawConfig.tileSize + 0.5*drawConfig.tileSize;
 
     int xCoords[4];
     int yCoords[4];
@@ -205,52 +251,40 @@ static void draw_robot(Robot *robot)
     */
 
     // triangle radius is the distance from center to vertice
-    double triangle_circumrad = TILE_SIZE/2 - OBJECT_PADDING;
+    double triangle_circumrad = drawConfig.tileSize/2 - OBJECT_PADDING;
 
-    // generate cartesian vertices
-    Point* triVertices = equ_triangle_coords(triangle_circumrad);
-    if (triVertices == NULL) {
-        fprintf(stderr, "Malloc returned null for triangle vertices in equ_triangle_coords\n");
-        exit(EXIT_FAILURE);
-    }
-    Point* rectVertices  = rect_coords(triangle_circumrad);
-    if (rectVertices == NULL) {
-        fprintf(stderr, "Malloc returned null for rectangle vertices in equ_triangle_coords\n");
-        exit(EXIT_FAILURE);
-    }
+    // generate cartesian vertices on the stack as this is called every frame
+    Point triVertices[3];
+    Point rectVertices[4];
+    equ_triangle_coords(triangle_circumrad, triVertices);
+    rect_coords(triangle_circumrad, rectVertices);
 
     rotate_points(triVertices, 3, robot->direction*90); // rotate cartesian coords of triangle to match robots direction
     draw_triangle(triVertices, robot->x, robot->y); // now translate onto drawapp grid
 
     rotate_points(rectVertices, 4, robot->direction*90);
     draw_rectangle(rectVertices, robot->x, robot->y);
-
-    free(triVertices);
-    free(rectVertices);
 }
 
 // this function draws a single marker at arena position (x, y)
 static void draw_marker(int x, int y) 
 {
     // convert arena position (x, y) to coordinates for top left of shape
-    int coordX = BORDER_THICKNESS + x*TILE_SIZE + OBJECT_PADDING;
-    int coordY = BORDER_THICKNESS + y*TILE_SIZE + OBJECT_PADDING;
-    int obstacle_size = TILE_SIZE-2*OBJECT_PADDING;
+    int coordX = BORDER_THICKNESS + x*drawConfig.tileSize + OBJECT_PADDING;
+    int coordY = BORDER_THICKNESS + y*drawConfig.tileSize + OBJECT_PADDING;
+    int obstacle_size = drawConfig.tileSize-2*OBJECT_PADDING;
 
     // draw
     setColour(gray);
     fillArc(coordX, coordY, obstacle_size, obstacle_size, 0, 360);
 }
 
-// this function iterates over arenaGrid and calls the function to render markers
+// this function iterates over the marker index and calls the function to render markers
 static void draw_markers(Arena *arena)
 {
-    for (int y = 0; y < arena->arenaHeight; y++) {
-        for (int x = 0; x < arena->arenaWidth; x++) {
-            if (arena->arenaGrid[y][x] == T_MARKER) {
-                draw_marker(x, y);
-            }
-        }
+    for (int i = 0; i < arena->numMarker; i++) {
+        Coord pos = arena->markers.positions[i];
+        draw_marker(pos.x, pos.y);
     }
 }
 
@@ -260,19 +294,107 @@ static void draw_markers(Arena *arena)
 void draw_background(Arena *arena)
 {
     calculate_window_dimensions(arena);
+    actionCount = 0;
+    lastMarkerCount = arena->numMarker;
+    skippedFrame = 0;
+    sleptTime = 0;
+    if (drawConfig.terminal) {
+        terminal_draw_background(arena);
+        return;
+    }
     setWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     background();
-    printf("%d, %d\n", WINDOW_WIDTH, WINDOW_HEIGHT);
     draw_border(arena);
     draw_grid(arena);
     draw_obstacles(arena);
 }
 
-// this function draws the foreground - called once per robot moveent; pre-requisite: robot created, markers generated
-void draw_foreground(Robot *robot, Arena *arena)
+// this function draws the background again after obstacles have changed during the search; pre-requisite: begin_foreground called
+void redraw_obstacles(Arena *arena)
 {
+    if (drawConfig.terminal) return; // the terminal draws obstacles as part of each frame
+    background();
     clear();
-    draw_markers(arena);
-    draw_robot(robot); // draw robot second so that its on top of marker
-    sleep(TIME_INTERVAL);
+    draw_border(arena);
+    draw_grid(arena);
+    draw_obstacles(arena);
+    foreground();
+}
+
+// this function pauses on the background before the search starts and switches to drawing on the foreground - called once after draw_background
+void begin_foreground(void)
+{
+    if (drawConfig.terminal) {
+        terminal_sleep(500);
+        return;
+    }
+    sleep(500);
+    foreground();
+}
+
+// this function works out how long to sleep after a frame so that the whole search takes about the target duration, never waiting longer than the time interval
+static int frame_sleep_time(Robot *robot, Arena *arena)
+{
+    if (drawConfig.targetDuration <= 0) return drawConfig.timeInterval;
+
+    // the search stops at the last marker, which on average is found once m/(m+1) of the tiles are known for m randomly placed markers
+    int numTiles = robot->arenaWidth*robot->arenaHeight;
+    int totalMarkers = arena->numMarker + robot->markerCount + arena->numDelivered;
+    double tilesAtEnd = (double)numTiles * totalMarkers / (totalMarkers + 1);
+
+    // estimate the actions left from the actions per known tile so far, assuming about 1.5 per tile before there is enough progress to go on
+    double estimatedActions = 1.5*tilesAtEnd;
+    if (robot->knownTiles > numTiles/20) {
+        estimatedActions = (double)actionCount * tilesAtEnd / robot->knownTiles;
+    }
+    double framesLeft = (estimatedActions - actionCount) / drawConfig.frameSkip;
+    if (framesLeft < 1) framesLeft = 1;
+
+    long timeLeft = drawConfig.targetDuration - sleptTime;
+    if (timeLeft <= 0) return 0;
+    return min(drawConfig.timeInterval, (int)(timeLeft / framesLeft + 0.5));
+}
+
+// this function draws the markers and robot over the background, to the drawapp or the terminal
+static void draw_foreground_frame(Robot *robot, Arena *arena)
+{
+    if (drawConfig.terminal) {
+        terminal_draw_foreground(robot, arena);
+    }
+    else {
+        clear();
+        draw_markers(arena);
+        draw_robot(robot); // draw robot second so that its on top of marker
+    }
+}
+
+// this function draws the foreground - called once per robot action, but only every frameSkip actions are drawn unless a marker has been picked up; pre-requisite: robot created, markers generated
+void draw_foreground(Robot *robot, Arena *arena)
+{
+    actionCount++;
+    int pickedUp = arena->numMarker != lastMarkerCount;
+    skippedFrame = !pickedUp && actionCount % drawConfig.frameSkip != 0;
+    if (skippedFrame) return;
+    lastMarkerCount = arena->numMarker;
+    long long start = profile_start();
+
+    draw_foreground_frame(robot, arena);
+
+    int sleepTime = frame_sleep_time(robot, arena);
+    if (sleepTime > 0) {
+        if (drawConfig.terminal) terminal_sleep(sleepTime);
+        else sleep(sleepTime);
+        sleptTime += sleepTime;
+    }
+    profile_stop(PF_DRAW_FOREGROUND, start);
+}
+
+// this function tidies up once nothing more will be drawn, first drawing the robot's final state (without a sleep) if its last action was skipped; the drawapp keeps showing the last frame, the terminal needs its cursor back
+void finish_drawing(Robot *robot, Arena *arena)
+{
+    if (skippedFrame) {
+        draw_foreground_frame(robot, arena);
+        skippedFrame = 0;
+    }
+    if (drawConfig.terminal) terminal_finish();
 }
\ No newline at end of file
@@ -0,0 +1,327 @@
+// This file contains an incremental route search (D* Lite) over the robot's memory, which searches from the goal back to the robot and keeps its distances between routes, so when tiles appear or disappear part way along a route only the distances they affect are worked out again rather than the whole search
+
+#include "../include/dstar.h"
+#include "../include/pool.h"
+#include "../include/robot.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+// this function returns how many bytes of pool create_dstar needs for an arena of the given size
+size_t dstar_pool_size(int width, int height)
+{
+    size_t numTiles = (size_t)width * height;
+    return pool_aligned_size(sizeof(DStar))
+        + 3 * pool_aligned_size(numTiles * sizeof(int))
+        + pool_aligned_size(4 * numTiles * sizeof(DStarEntry));
+}
+
+// this function creates an incremental search from the pool for an arena of the given size; returns NULL if the pool does not have space; freed when the pool is reset
+DStar* create_dstar(Pool *pool, int width, int height)
+{
+    size_t numTiles = (size_t)width * height;
+    DStar *dstar = pool_alloc(pool, sizeof(DStar));
+    if (dstar == NULL) {
+        fprintf(stderr, "Pool has no space in create_dstar\n");
+        return NULL;
+    }
+
+    dstar->width = width;
+    dstar->height = height;
+    dstar->g = pool_alloc(pool, numTiles * sizeof(int));
+    dstar->rhs = pool_alloc(pool, numTiles * sizeof(int));
+    dstar->searchMark = pool_alloc(pool, numTiles * sizeof(int)); // zeroed, and searchId starts above 0
+    dstar->heapCapacity = 4 * numTiles;
+    dstar->heap = pool_alloc(pool, dstar->heapCapacity * sizeof(DStarEntry));
+    if (dstar->g == NULL || dstar->rhs == NULL || dstar->searchMark == NULL || dstar->heap == NULL) {
+        fprintf(stderr, "Pool has no space for search arrays in create_dstar\n");
+        return NULL;
+    }
+    dstar->searchId = 0;
+    dstar->heapSize = 0;
+    dstar->numChanged = 0;
+    dstar->overflowed = 0;
+    dstar->active = 0;
+    dstar->km = 0;
+    dstar->expansions = 0;
+    return dstar;
+}
+
+// this function is told each tile that becomes blocked or passable in the robot's memory, so the next route to the same goal can repair the search around it
+void dstar_tile_changed(DStar *dstar, int x, int y)
+{
+    if (!dstar->active) return; // the next route starts from scratch anyway
+    if (dstar->numChanged == DSTAR_MAX_CHANGES) {
+        dstar->overflowed = 1;
+        return;
+    }
+    dstar->changed[dstar->numChanged++] = y*dstar->width + x;
+}
+
+// functions for the distances:
+
+// this function gives a tile infinite g and rhs the first time the current search touches it
+static void touch(DStar *dstar, int tile)
+{
+    if (dstar->searchMark[tile] == dstar->searchId) return;
+    dstar->searchMark[tile] = dstar->searchId;
+    dstar->g[tile] = DSTAR_INFINITY;
+    dstar->rhs[tile] = DSTAR_INFINITY;
+}
+
+// this function returns g of a tile, which is infinite if the current search has not touched it
+static int g_of(DStar *dstar, int tile)
+{
+    return dstar->searchMark[tile] == dstar->searchId ? dstar->g[tile] : DSTAR_INFINITY;
+}
+
+// this function checks if a tile is in bounds and not known to be blocked, treating unknown tiles as passable like the planner does
+static int is_open(DStar *dstar, const TileGrid *memory, int x, int y)
+{
+    if (x < 0 || x >= dstar->width || y < 0 || y >= dstar->height) return 0;
+    return get_tile(memory, x, y) != R_BLOCKED;
+}
+
+// this function returns the key of a tile, which orders the open set by the shortest route through the tile from where the robot now is
+static long long key_of(DStar *dstar, int tile)
+{
+    int best = min(dstar->g[tile], dstar->rhs[tile]);
+    Coord coord = {tile % dstar->width, tile / dstar->width};
+    int estimate = abs(coord.x - dstar->last.x) + abs(coord.y - dstar->last.y);
+    return ((long long)(best + estimate + dstar->km) << 32) | (unsigned int)best;
+}
+
+// functions for the open set heap:
+
+// this function pushes an entry onto the heap without checking for space
+static void heap_insert(DStar *dstar, long long key, int tile)
+{
+    DStarEntry *heap = dstar->heap;
+    int i = dstar->heapSize++;
+    heap[i] = (DStarEntry){key, tile};
+
+    // sift up
+    while (i > 0 && heap[(i-1)/2].key > heap[i].key) {
+        DStarEntry tmp = heap[i];
+        heap[i] = heap[(i-1)/2];
+        heap[(i-1)/2] = tmp;
+        i = (i-1)/2;
+    }
+}
+
+// this function builds the heap again from every tile that is out of date, dropping the stale entries that filled it
+static void compact_heap(DStar *dstar)
+{
+    dstar->heapSize = 0;
+    for (int tile = 0; tile < dstar->width*dstar->height; tile++) {
+        if (dstar->searchMark[tile] != dstar->searchId || dstar->g[tile] == dstar->rhs[tile]) continue;
+        heap_insert(dstar, key_of(dstar, tile), tile);
+    }
+}
+
+// this function pushes a tile onto the open set with its current key, making room first if stale entries have filled the heap
+static void heap_push(DStar *dstar, int tile)
+{
+    if (dstar->heapSize == dstar->heapCapacity) compact_heap(dstar); // at most one entry per tile is left, so there is always room after
+    heap_insert(dstar, key_of(dstar, tile), tile);
+}
+
+// this function pops the entry with the lowest key from the open set
+static DStarEntry heap_pop(DStar *dstar)
+{
+    DStarEntry *heap = dstar->heap;
+    DStarEntry top = heap[0];
+    heap[0] = heap[--dstar->heapSize];
+
+    // sift down
+    int i = 0;
+    while (1) {
+        int smallest = i;
+        int left = 2*i + 1;
+        int right = 2*i + 2;
+        if (left < dstar->heapSize && heap[left].key < heap[smallest].key) smallest = left;
+        if (right < dstar->heapSize && heap[right].key < heap[smallest].key) smallest = right;
+        if (smallest == i) break;
+        DStarEntry tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+    return top;
+}
+
+// functions for searching:
+
+// this function works out rhs of a tile again from its neighbours and puts it on the open set if that leaves it out of date
+static void update_tile(DStar *dstar, const TileGrid *memory, int tile)
+{
+    touch(dstar, tile);
+    int x = tile % dstar->width;
+    int y = tile / dstar->width;
+    if (x != dstar->goal.x || y != dstar->goal.y) {
+        int best = DSTAR_INFINITY;
+        if (is_open(dstar, memory, x, y)) {
+            for (Direction dir = NORTH; dir <= WEST; dir++) {
+                int nx = x + (dir == EAST) - (dir == WEST);
+                int ny = y + (dir == SOUTH) - (dir == NORTH);
+                if (!is_open(dstar, memory, nx, ny)) continue;
+                best = min(best, g_of(dstar, ny*dstar->width + nx) + 1);
+            }
+        }
+        dstar->rhs[tile] = min(best, DSTAR_INFINITY);
+    }
+    if (dstar->g[tile] != dstar->rhs[tile]) heap_push(dstar, tile);
+}
+
+// this function updates a tile and its in bounds neighbours, whose routes may pass through it
+static void update_around(DStar *dstar, const TileGrid *memory, int tile)
+{
+    int x = tile % dstar->width;
+    int y = tile / dstar->width;
+    update_tile(dstar, memory, tile);
+    if (y > 0) update_tile(dstar, memory, tile - dstar->width);
+    if (x < dstar->width - 1) update_tile(dstar, memory, tile + 1);
+    if (y < dstar->height - 1) update_tile(dstar, memory, tile + dstar->width);
+    if (x > 0) update_tile(dstar, memory, tile - 1);
+}
+
+// this function lowers rhs of each open neighbour of a tile whose g has just fallen, if moving through the tile is now its quickest way to the goal
+static void lower_neighbours(DStar *dstar, const TileGrid *memory, int tile)
+{
+    int x = tile % dstar->width;
+    int y = tile / dstar->width;
+    if (!is_open(dstar, memory, x, y)) return; // only the goal can be blocked and still have a distance
+    int through = dstar->g[tile] + 1;
+    for (Direction dir = NORTH; dir <= WEST; dir++) {
+        int nx = x + (dir == EAST) - (dir == WEST);
+        int ny = y + (dir == SOUTH) - (dir == NORTH);
+        if (!is_open(dstar, memory, nx, ny)) continue;
+        int next = ny*dstar->width + nx;
+        touch(dstar, next);
+        if (dstar->rhs[next] <= through) continue; // includes the goal, whose rhs is 0
+        dstar->rhs[next] = through;
+        if (dstar->g[next] != through) heap_push(dstar, next);
+    }
+}
+
+// this function works out rhs again for the tile and each neighbour whose rhs came through it, after its g has risen from oldG to infinity
+static void raise_neighbours(DStar *dstar, const TileGrid *memory, int tile, int oldG)
+{
+    int x = tile % dstar->width;
+    int y = tile / dstar->width;
+    update_tile(dstar, memory, tile);
+    for (Direction dir = NORTH; dir <= WEST; dir++) {
+        int nx = x + (dir == EAST) - (dir == WEST);
+        int ny = y + (dir == SOUTH) - (dir == NORTH);
+        if (nx < 0 || nx >= dstar->width || ny < 0 || ny >= dstar->height) continue;
+        int next = ny*dstar->width + nx;
+        if (dstar->searchMark[next] == dstar->searchId && dstar->rhs[next] == oldG + 1) update_tile(dstar, memory, next);
+    }
+}
+
+// this function expands tiles off the open set until g of the start is correct, so a shortest route can be followed from it downhill in g
+static void compute_shortest_route(DStar *dstar, const TileGrid *memory, int startTile)
+{
+    dstar->expansions = 0;
+    touch(dstar, startTile);
+    while (dstar->heapSize > 0) {
+        if (dstar->heap[0].key >= key_of(dstar, startTile) && dstar->g[startTile] == dstar->rhs[startTile]) break;
+
+        DStarEntry top = heap_pop(dstar);
+        int tile = top.tile;
+        if (dstar->g[tile] == dstar->rhs[tile]) continue; // a stale entry for a tile that has since been brought up to date
+        long long key = key_of(dstar, tile);
+        if (top.key < key) { // the robot has moved or a distance has grown since it was pushed
+            heap_insert(dstar, key, tile);
+            continue;
+        }
+
+        dstar->expansions++;
+        if (dstar->g[tile] > dstar->rhs[tile]) {
+            dstar->g[tile] = dstar->rhs[tile];
+            lower_neighbours(dstar, memory, tile);
+        }
+        else {
+            int oldG = dstar->g[tile];
+            dstar->g[tile] = DSTAR_INFINITY;
+            raise_neighbours(dstar, memory, tile, oldG);
+        }
+    }
+}
+
+// this function starts a new search towards a goal, forgetting every distance from the last one
+static void start_search(DStar *dstar, Coord start, Coord goal)
+{
+    dstar->searchId++;
+    dstar->heapSize = 0;
+    dstar->numChanged = 0;
+    dstar->overflowed = 0;
+    dstar->active = 1;
+    dstar->goal = goal;
+    dstar->last = start;
+    dstar->km = 0;
+
+    int goalTile = goal.y*dstar->width + goal.x;
+    touch(dstar, goalTile);
+    dstar->rhs[goalTile] = 0;
+    heap_push(dstar, goalTile);
+}
+
+// this function brings a search towards the same goal up to date with where the robot now is and the tiles that have changed since the last route
+static void repair_search(DStar *dstar, const TileGrid *memory, Coord start)
+{
+    dstar->km += abs(start.x - dstar->last.x) + abs(start.y - dstar->last.y);
+    dstar->last = start;
+    for (int i = 0; i < dstar->numChanged; i++) {
+        update_around(dstar, memory, dstar->changed[i]);
+    }
+    dstar->numChanged = 0;
+}
+
+// this function fills route with a shortest route from start to goal by always moving to the neighbour closest to the goal; returns S_ERR_INTERNAL if it does not reach the goal within capacity
+static Status follow_distances(DStar *dstar, const TileGrid *memory, Coord start, Coord *route, size_t capacity, int *length)
+{
+    Coord tile = start;
+    int moves = g_of(dstar, start.y*dstar->width + start.x);
+    *length = 0;
+    while (tile.x != dstar->goal.x || tile.y != dstar->goal.y) {
+        if (*length >= moves || (size_t)*length >= capacity) return S_ERR_INTERNAL;
+
+        Coord best = {-1, -1};
+        int bestDist = DSTAR_INFINITY;
+        for (Direction dir = NORTH; dir <= WEST; dir++) {
+            Coord next = {tile.x + (dir == EAST) - (dir == WEST), tile.y + (dir == SOUTH) - (dir == NORTH)};
+            if (!is_open(dstar, memory, next.x, next.y)) continue;
+            int dist = g_of(dstar, next.y*dstar->width + next.x);
+            if (dist < bestDist) {
+                best = next;
+                bestDist = dist;
+            }
+        }
+        if (best.x == -1) return S_ERR_INTERNAL;
+        route[(*length)++] = best;
+        tile = best;
+    }
+    return S_OK;
+}
+
+// this function finds a shortest route from start to goal over the robot's memory into route, not including the start; a search towards the same goal as the last route is repaired rather than started again; returns S_ERR_UNREACHABLE if there is no route, or S_ERR_INTERNAL if the route does not fit
+Status dstar_route(DStar *dstar, const TileGrid *memory, Coord start, Coord goal, Coord *route, size_t capacity, int *length)
+{
+    *length = 0;
+    int sameGoal = dstar->active && dstar->goal.x == goal.x && dstar->goal.y == goal.y;
+    if (sameGoal && !dstar->overflowed) {
+        repair_search(dstar, memory, start);
+    }
+    else {
+        start_search(dstar, start, goal);
+    }
+
+    int startTile = start.y*dstar->width + start.x;
+    compute_shortest_route(dstar, memory, startTile);
+    if (start.x == goal.x && start.y == goal.y) return S_OK;
+    if (!is_open(dstar, memory, start.x, start.y) || dstar->g[startTile] >= DSTAR_INFINITY) return S_ERR_UNREACHABLE;
+    return follow_distances(dstar, memory, start, route, capacity, length);
+}
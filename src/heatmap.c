@@ -0,0 +1,118 @@
+// This file exports how many times the robot moved onto each tile, as an image or CSV, to find where it wastes movement
+
+#include "../include/arena.h"
+#include "../include/heatmap.h"
+#include "../include/robot.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+// this function returns the most times the robot moved onto any one tile; goes a chunk at a time so chunks never visited in a sparse arena are skipped
+int max_visit_count(Robot *robot)
+{
+    const TileGrid *visits = &robot->visitCounts;
+    int most = 0;
+    for (int y0 = 0; y0 < visits->height; y0 += CHUNK_SIZE) {
+        for (int x0 = 0; x0 < visits->width; x0 += CHUNK_SIZE) {
+            if (is_chunk_empty(visits, x0, y0)) continue;
+            for (int y = y0; y < min(y0 + CHUNK_SIZE, visits->height); y++) {
+                for (int x = x0; x < min(x0 + CHUNK_SIZE, visits->width); x++) {
+                    most = max(most, get_tile(visits, x, y));
+                }
+            }
+        }
+    }
+    return most;
+}
+
+// this function returns how many moves were onto a tile the robot had already moved onto
+int revisit_count(Robot *robot)
+{
+    const TileGrid *visits = &robot->visitCounts;
+    int revisits = 0;
+    for (int y0 = 0; y0 < visits->height; y0 += CHUNK_SIZE) {
+        for (int x0 = 0; x0 < visits->width; x0 += CHUNK_SIZE) {
+            if (is_chunk_empty(visits, x0, y0)) continue;
+            for (int y = y0; y < min(y0 + CHUNK_SIZE, visits->height); y++) {
+                for (int x = x0; x < min(x0 + CHUNK_SIZE, visits->width); x++) {
+                    int count = get_tile(visits, x, y);
+                    if (count > 1) revisits += count - 1;
+                }
+            }
+        }
+    }
+    return revisits;
+}
+
+// this function clamps a colour channel to 0-255
+static unsigned char channel(double value)
+{
+    if (value < 0) return 0;
+    if (value > 255) return 255;
+    return (unsigned char)value;
+}
+
+// this function writes the visit counts as a binary PPM image with each tile a square of pixels: obstacles blue, unvisited tiles dark grey, and visited tiles from red (once) through yellow to white (the most visits); returns S_ERR_IO if the file cannot be written
+Status export_visits_ppm(Robot *robot, Arena *arena, const char *path, int pixelsPerTile)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open %s in export_visits_ppm\n", path);
+        return S_ERR_IO;
+    }
+
+    int width = robot->arenaWidth;
+    int most = max_visit_count(robot);
+    fprintf(file, "P6\n%d %d\n255\n", width * pixelsPerTile, robot->arenaHeight * pixelsPerTile);
+    for (int py = 0; py < robot->arenaHeight * pixelsPerTile; py++) {
+        int y = py / pixelsPerTile;
+        for (int px = 0; px < width * pixelsPerTile; px++) {
+            int x = px / pixelsPerTile;
+            unsigned char rgb[3] = {40, 40, 40};
+            int visits = get_tile(&robot->visitCounts, x, y);
+            if (get_tile(&arena->arenaGrid, x, y) == T_OBSTACLE) {
+                rgb[0] = 30;
+                rgb[1] = 60;
+                rgb[2] = 200;
+            }
+            else if (visits > 0) {
+                double heat = most > 1 ? 3.0 * (visits - 1) / (most - 1) : 0; // 0 to 3, through red, yellow and white
+                rgb[0] = channel(128 + 127*heat);
+                rgb[1] = channel(255*(heat - 1));
+                rgb[2] = channel(255*(heat - 2));
+            }
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Could not write %s in export_visits_ppm\n", path);
+        return S_ERR_IO;
+    }
+    return S_OK;
+}
+
+// this function writes the visit counts as CSV, one row of the arena per line; returns S_ERR_IO if the file cannot be written
+Status export_visits_csv(Robot *robot, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open %s in export_visits_csv\n", path);
+        return S_ERR_IO;
+    }
+
+    for (int y = 0; y < robot->arenaHeight; y++) {
+        for (int x = 0; x < robot->arenaWidth; x++) {
+            fprintf(file, x == 0 ? "%d" : ",%d", get_tile(&robot->visitCounts, x, y));
+        }
+        fputc('\n', file);
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Could not write %s in export_visits_csv\n", path);
+        return S_ERR_IO;
+    }
+    return S_OK;
+}
@@ -0,0 +1,466 @@
+// This file contains a graph of sectors over the robot's memory (HPA*), so long routes are searched between the entrances of sectors rather than over every tile, with a sector only worked out again when an obstacle is found in or next to it
+
+#include "../include/hierarchy.h"
+#include "../include/pool.h"
+#include "../include/robot.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TWO_NODE_ENTRANCE 6 // entrances at least this wide get a node at each end rather than one in the middle
+#define NO_DIST 0xFFFF // in dist, for nodes that cannot reach each other within their sector
+
+// this function returns how many bytes of pool create_hierarchy needs for an arena of the given size
+size_t hierarchy_pool_size(int width, int height)
+{
+    size_t numSectors = (size_t)((width + SECTOR_SIZE - 1) >> SECTOR_SHIFT) * ((height + SECTOR_SIZE - 1) >> SECTOR_SHIFT);
+    size_t numNodes = numSectors * MAX_SECTOR_NODES;
+    return pool_aligned_size(sizeof(Hierarchy))
+        + pool_aligned_size(numNodes * sizeof(Coord))
+        + pool_aligned_size(numNodes * sizeof(unsigned char))
+        + pool_aligned_size(numSectors * sizeof(int))
+        + pool_aligned_size(numNodes * MAX_SECTOR_NODES * sizeof(unsigned short))
+        + pool_aligned_size(numSectors * sizeof(unsigned char))
+        + 4 * pool_aligned_size(numNodes * sizeof(int))
+        + pool_aligned_size((numNodes * MAX_SECTOR_NODES + 1) * sizeof(long long)) // each node is expanded once and pushes at most every node of its sector and its partner
+        + 3 * pool_aligned_size(SECTOR_SIZE * SECTOR_SIZE * sizeof(int))
+        + pool_aligned_size(SECTOR_SIZE * SECTOR_SIZE * sizeof(unsigned char));
+}
+
+// this function creates a hierarchy from the pool for an arena of the given size with every sector out of date, so it is worked out from the robot's memory when first needed; returns NULL if the pool does not have space
+Hierarchy* create_hierarchy(Pool *pool, int width, int height)
+{
+    Hierarchy *hierarchy = pool_alloc(pool, sizeof(Hierarchy));
+    if (hierarchy == NULL) {
+        fprintf(stderr, "Pool has no space in create_hierarchy\n");
+        return NULL;
+    }
+
+    hierarchy->width = width;
+    hierarchy->height = height;
+    hierarchy->sectorsWide = (width + SECTOR_SIZE - 1) >> SECTOR_SHIFT;
+    hierarchy->sectorsHigh = (height + SECTOR_SIZE - 1) >> SECTOR_SHIFT;
+    hierarchy->numSectors = hierarchy->sectorsWide * hierarchy->sectorsHigh;
+    size_t numNodes = (size_t)hierarchy->numSectors * MAX_SECTOR_NODES;
+    hierarchy->nodes = pool_alloc(pool, numNodes * sizeof(Coord));
+    hierarchy->nodeSide = pool_alloc(pool, numNodes * sizeof(unsigned char));
+    hierarchy->numNodes = pool_alloc(pool, hierarchy->numSectors * sizeof(int));
+    hierarchy->dist = pool_alloc(pool, numNodes * MAX_SECTOR_NODES * sizeof(unsigned short));
+    hierarchy->dirty = pool_alloc(pool, hierarchy->numSectors * sizeof(unsigned char));
+    hierarchy->cost = pool_alloc(pool, numNodes * sizeof(int));
+    hierarchy->parent = pool_alloc(pool, numNodes * sizeof(int));
+    hierarchy->searchMark = pool_alloc(pool, numNodes * sizeof(int)); // zeroed, and searchId starts above 0
+    hierarchy->abstractRoute = pool_alloc(pool, numNodes * sizeof(int));
+    hierarchy->heapCapacity = numNodes * MAX_SECTOR_NODES + 1;
+    hierarchy->heap = pool_alloc(pool, hierarchy->heapCapacity * sizeof(long long));
+    hierarchy->localDist = pool_alloc(pool, SECTOR_SIZE * SECTOR_SIZE * sizeof(int));
+    hierarchy->localParent = pool_alloc(pool, SECTOR_SIZE * SECTOR_SIZE * sizeof(int));
+    hierarchy->queue = pool_alloc(pool, SECTOR_SIZE * SECTOR_SIZE * sizeof(int));
+    hierarchy->localOpen = pool_alloc(pool, SECTOR_SIZE * SECTOR_SIZE * sizeof(unsigned char));
+    if (hierarchy->nodes == NULL || hierarchy->nodeSide == NULL || hierarchy->numNodes == NULL || hierarchy->dist == NULL || hierarchy->dirty == NULL
+        || hierarchy->cost == NULL || hierarchy->parent == NULL || hierarchy->searchMark == NULL || hierarchy->abstractRoute == NULL || hierarchy->heap == NULL
+        || hierarchy->localDist == NULL || hierarchy->localParent == NULL || hierarchy->queue == NULL || hierarchy->localOpen == NULL) {
+        fprintf(stderr, "Pool has no space for hierarchy arrays in create_hierarchy\n");
+        return NULL;
+    }
+
+    for (int sector = 0; sector < hierarchy->numSectors; sector++) hierarchy->dirty[sector] = 1;
+    hierarchy->loadedSector = -1;
+    hierarchy->searchId = 0;
+    hierarchy->heapSize = 0;
+    hierarchy->rebuiltSectors = 0;
+    hierarchy->expansions = 0;
+    return hierarchy;
+}
+
+// functions for sectors:
+
+// this function returns the sector a tile is in
+static int sector_of(Hierarchy *hierarchy, Coord tile)
+{
+    return (tile.y >> SECTOR_SHIFT)*hierarchy->sectorsWide + (tile.x >> SECTOR_SHIFT);
+}
+
+// this function sets the first tile of a sector and the tile just past its last, as sectors on the right and bottom may be cut short by the edge of the arena
+static void sector_bounds(Hierarchy *hierarchy, int sector, Coord *first, Coord *end)
+{
+    first->x = (sector % hierarchy->sectorsWide) << SECTOR_SHIFT;
+    first->y = (sector / hierarchy->sectorsWide) << SECTOR_SHIFT;
+    end->x = min(first->x + SECTOR_SIZE, hierarchy->width);
+    end->y = min(first->y + SECTOR_SIZE, hierarchy->height);
+}
+
+// this function returns the tile next to a tile in a direction, which may be out of bounds
+static Coord step_in_direction(Coord tile, Direction direction)
+{
+    if (direction == NORTH) tile.y--;
+    if (direction == EAST) tile.x++;
+    if (direction == SOUTH) tile.y++;
+    if (direction == WEST) tile.x--;
+    return tile;
+}
+
+// this function checks if a tile can be moved onto as far as the robot knows, treating unknown tiles as passable like the planner does
+static int is_passable(const TileGrid *memory, Coord tile)
+{
+    return get_tile(memory, tile.x, tile.y) != R_BLOCKED;
+}
+
+// this function is told each tile the robot finds to be blocked or passable again, marking its sector out of date, and the sector across the border too if the tile is on one, as the entrances between them may have changed
+void hierarchy_tile_changed(Hierarchy *hierarchy, int x, int y)
+{
+    Coord tile = {x, y};
+    hierarchy->dirty[sector_of(hierarchy, tile)] = 1;
+    for (Direction dir = NORTH; dir <= WEST; dir++) {
+        Coord next = step_in_direction(tile, dir);
+        if (!check_coord_in_bounds(next, hierarchy->width, hierarchy->height)) continue;
+        if (sector_of(hierarchy, next) != sector_of(hierarchy, tile)) hierarchy->dirty[sector_of(hierarchy, next)] = 1;
+    }
+}
+
+// this function copies which tiles of a sector are passable out of the robot's memory, so the searches within it do not have to go through get_tile
+static void load_sector(Hierarchy *hierarchy, const TileGrid *memory, int sector)
+{
+    if (hierarchy->loadedSector == sector) return;
+    Coord first, end;
+    sector_bounds(hierarchy, sector, &first, &end);
+    for (int y = first.y; y < end.y; y++) {
+        for (int x = first.x; x < end.x; x++) {
+            hierarchy->localOpen[(y - first.y)*SECTOR_SIZE + (x - first.x)] = is_passable(memory, (Coord){x, y});
+        }
+    }
+    hierarchy->loadedSector = sector;
+}
+
+// this function returns a tile's position within its sector, as localDist and localParent are indexed
+static int local_index(Hierarchy *hierarchy, int sector, Coord tile)
+{
+    Coord first, end;
+    sector_bounds(hierarchy, sector, &first, &end);
+    return (tile.y - first.y)*SECTOR_SIZE + (tile.x - first.x);
+}
+
+// this function runs a breadth first search from a tile without leaving its sector, filling localDist (-1 where it has not reached) and localParent, indexed by the tile's position in the sector; it stops once it has reached every tile in targets (by local index) that it can, so only their distances are then known
+static void search_sector(Hierarchy *hierarchy, const TileGrid *memory, int sector, Coord from, const int *targets, int numTargets)
+{
+    Coord first, end;
+    sector_bounds(hierarchy, sector, &first, &end);
+    load_sector(hierarchy, memory, sector);
+    int sectorWidth = end.x - first.x;
+    int sectorHeight = end.y - first.y;
+    int *localDist = hierarchy->localDist;
+    for (int i = 0; i < SECTOR_SIZE*SECTOR_SIZE; i++) localDist[i] = -1;
+
+    int head = 0;
+    int tail = 0;
+    int fromLocal = (from.y - first.y)*SECTOR_SIZE + (from.x - first.x);
+    localDist[fromLocal] = 0;
+    hierarchy->localParent[fromLocal] = fromLocal;
+    hierarchy->queue[tail++] = fromLocal;
+    unsigned char isTarget[SECTOR_SIZE*SECTOR_SIZE] = {0};
+    int targetsLeft = 0;
+    for (int i = 0; i < numTargets; i++) {
+        if (isTarget[targets[i]] || localDist[targets[i]] != -1) continue; // two sides of a corner can share a tile
+        isTarget[targets[i]] = 1;
+        targetsLeft++;
+    }
+
+    while (head < tail && targetsLeft > 0) {
+        int local = hierarchy->queue[head++];
+        int x = local % SECTOR_SIZE;
+        int y = local / SECTOR_SIZE;
+        int neighbours[4] = {y > 0 ? local - SECTOR_SIZE : -1, x < sectorWidth - 1 ? local + 1 : -1, y < sectorHeight - 1 ? local + SECTOR_SIZE : -1, x > 0 ? local - 1 : -1};
+        for (int i = 0; i < 4; i++) {
+            int next = neighbours[i];
+            if (next == -1 || localDist[next] != -1 || !hierarchy->localOpen[next]) continue;
+            localDist[next] = localDist[local] + 1;
+            hierarchy->localParent[next] = local;
+            hierarchy->queue[tail++] = next;
+            targetsLeft -= isTarget[next];
+        }
+    }
+}
+
+// this function returns the distance found by the last search_sector to a tile of the sector, or NO_DIST if it could not be reached
+static unsigned short local_dist_to(Hierarchy *hierarchy, int sector, Coord tile)
+{
+    int dist = hierarchy->localDist[local_index(hierarchy, sector, tile)];
+    return dist == -1 ? NO_DIST : dist;
+}
+
+// this function returns where the distance from one node of a sector to another is kept
+static unsigned short* sector_dist(Hierarchy *hierarchy, int sector, int from, int to)
+{
+    return &hierarchy->dist[((size_t)sector*MAX_SECTOR_NODES + from)*MAX_SECTOR_NODES + to];
+}
+
+// this function adds a node to a sector on a tile, crossing out of it in a direction
+static void add_node(Hierarchy *hierarchy, int sector, Coord tile, Direction side)
+{
+    int node = sector*MAX_SECTOR_NODES + hierarchy->numNodes[sector]++;
+    hierarchy->nodes[node] = tile;
+    hierarchy->nodeSide[node] = side;
+}
+
+// this function adds nodes for the entrances along one side of a sector: each run of tiles that are passable along with the tile across the border gets a node in its middle, or one at each end if it is wide
+static void add_entrances(Hierarchy *hierarchy, const TileGrid *memory, int sector, Direction side)
+{
+    Coord first, end;
+    sector_bounds(hierarchy, sector, &first, &end);
+    int horizontal = side == NORTH || side == SOUTH;
+    int length = horizontal ? end.x - first.x : end.y - first.y;
+    Coord edge = first; // first tile along the side
+    if (side == EAST) edge.x = end.x - 1;
+    if (side == SOUTH) edge.y = end.y - 1;
+    if (!check_coord_in_bounds(step_in_direction(edge, side), hierarchy->width, hierarchy->height)) return; // the edge of the arena
+
+    // both sectors scan the border in the same order, so they put their nodes on the same runs and each node faces its partner
+    int runStart = -1;
+    for (int i = 0; i <= length; i++) {
+        Coord tile = {edge.x + (horizontal ? i : 0), edge.y + (horizontal ? 0 : i)};
+        int open = i < length && is_passable(memory, tile) && is_passable(memory, step_in_direction(tile, side));
+        if (open && runStart == -1) runStart = i;
+        if (open || runStart == -1) continue;
+
+        int runLength = i - runStart;
+        int ends[2] = {runStart + (runLength - 1)/2, -1};
+        if (runLength >= TWO_NODE_ENTRANCE) {
+            ends[0] = runStart;
+            ends[1] = i - 1;
+        }
+        for (int j = 0; j < 2 && ends[j] != -1; j++) {
+            add_node(hierarchy, sector, (Coord){edge.x + (horizontal ? ends[j] : 0), edge.y + (horizontal ? 0 : ends[j])}, side);
+        }
+        runStart = -1;
+    }
+}
+
+// this function works out a sector's entrance nodes and the distances between them from the robot's memory, if it is out of date
+static void rebuild_sector(Hierarchy *hierarchy, const TileGrid *memory, int sector)
+{
+    if (!hierarchy->dirty[sector]) return;
+    hierarchy->numNodes[sector] = 0;
+    for (Direction side = NORTH; side <= WEST; side++) add_entrances(hierarchy, memory, sector, side);
+
+    // distances are the same both ways, so each search only has to reach the nodes after the one it starts from
+    int numNodes = hierarchy->numNodes[sector];
+    int targets[MAX_ENTRANCE_NODES];
+    for (int node = 0; node < numNodes; node++) targets[node] = local_index(hierarchy, sector, hierarchy->nodes[sector*MAX_SECTOR_NODES + node]);
+    for (int from = 0; from < numNodes; from++) {
+        *sector_dist(hierarchy, sector, from, from) = 0;
+        if (from == numNodes - 1) break;
+        search_sector(hierarchy, memory, sector, hierarchy->nodes[sector*MAX_SECTOR_NODES + from], targets + from + 1, numNodes - from - 1);
+        for (int to = from + 1; to < numNodes; to++) {
+            unsigned short dist = local_dist_to(hierarchy, sector, hierarchy->nodes[sector*MAX_SECTOR_NODES + to]);
+            *sector_dist(hierarchy, sector, from, to) = dist;
+            *sector_dist(hierarchy, sector, to, from) = dist;
+        }
+    }
+    hierarchy->dirty[sector] = 0;
+    hierarchy->rebuiltSectors++;
+}
+
+// this function adds a tile as an extra node of its sector for one route, with its distance to and from every entrance node; returns the node
+static int add_query_node(Hierarchy *hierarchy, const TileGrid *memory, Coord tile)
+{
+    int sector = sector_of(hierarchy, tile);
+    int slot = hierarchy->numNodes[sector];
+    int node = sector*MAX_SECTOR_NODES + slot;
+    hierarchy->nodes[node] = tile;
+    hierarchy->nodeSide[node] = NORTH; // never looked at, as query nodes have no partner
+
+    int targets[MAX_ENTRANCE_NODES];
+    for (int other = 0; other < slot; other++) targets[other] = local_index(hierarchy, sector, hierarchy->nodes[sector*MAX_SECTOR_NODES + other]);
+    search_sector(hierarchy, memory, sector, tile, targets, slot);
+    for (int other = 0; other < slot; other++) {
+        unsigned short dist = local_dist_to(hierarchy, sector, hierarchy->nodes[sector*MAX_SECTOR_NODES + other]);
+        *sector_dist(hierarchy, sector, slot, other) = dist;
+        *sector_dist(hierarchy, sector, other, slot) = dist;
+    }
+    *sector_dist(hierarchy, sector, slot, slot) = 0;
+    return node;
+}
+
+// this function returns the entrance node across the border from an entrance node, or -1 if there is none, first bringing the sector across up to date if the search has not been into it yet
+static int find_partner(Hierarchy *hierarchy, const TileGrid *memory, int node)
+{
+    Direction side = hierarchy->nodeSide[node];
+    Coord across = step_in_direction(hierarchy->nodes[node], side);
+    int sector = sector_of(hierarchy, across);
+    rebuild_sector(hierarchy, memory, sector); // none of its nodes can be in the open set yet, so they are safe to change
+    for (int slot = 0; slot < hierarchy->numNodes[sector]; slot++) {
+        int other = sector*MAX_SECTOR_NODES + slot;
+        Coord tile = hierarchy->nodes[other];
+        if (tile.x == across.x && tile.y == across.y && hierarchy->nodeSide[other] == (side + 2) % 4) return other;
+    }
+    return -1;
+}
+
+// functions for the open set heap:
+
+// this function pushes a node onto the open set with a priority
+static void heap_push(Hierarchy *hierarchy, int priority, int node)
+{
+    long long *heap = hierarchy->heap;
+    int i = hierarchy->heapSize++;
+    heap[i] = ((long long)priority << 32) | (unsigned int)node;
+
+    // sift up
+    while (i > 0 && heap[(i-1)/2] > heap[i]) {
+        long long tmp = heap[i];
+        heap[i] = heap[(i-1)/2];
+        heap[(i-1)/2] = tmp;
+        i = (i-1)/2;
+    }
+}
+
+// this function pops the node with the lowest priority from the open set, setting its priority
+static int heap_pop(Hierarchy *hierarchy, int *priority)
+{
+    long long *heap = hierarchy->heap;
+    long long top = heap[0];
+    heap[0] = heap[--hierarchy->heapSize];
+
+    // sift down
+    int i = 0;
+    while (1) {
+        int smallest = i;
+        int left = 2*i + 1;
+        int right = 2*i + 2;
+        if (left < hierarchy->heapSize && heap[left] < heap[smallest]) smallest = left;
+        if (right < hierarchy->heapSize && heap[right] < heap[smallest]) smallest = right;
+        if (smallest == i) break;
+        long long tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+
+    *priority = (int)(top >> 32);
+    return (int)(top & 0xFFFFFFFF);
+}
+
+// functions for searching:
+
+// this function returns the distance ignoring obstacles between two tiles, which never overestimates the moves needed
+static int manhattan_dist(Coord a, Coord b)
+{
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+// this function reaches a node from another with a cost if that is cheaper than any way found so far, adding it to the open set
+static void relax(Hierarchy *hierarchy, int node, int from, int cost, Coord goal)
+{
+    if (hierarchy->searchMark[node] == hierarchy->searchId && hierarchy->cost[node] <= cost) return;
+    hierarchy->searchMark[node] = hierarchy->searchId;
+    hierarchy->cost[node] = cost;
+    hierarchy->parent[node] = from;
+    heap_push(hierarchy, cost + manhattan_dist(hierarchy->nodes[node], goal), node);
+}
+
+// this function runs A* over the nodes from the start node to the goal node, moving within a sector by the stored distances and between sectors through partner nodes; returns the number of nodes on the route found, or 0 if there is none
+static int search_nodes(Hierarchy *hierarchy, const TileGrid *memory, int startNode, int goalNode)
+{
+    Coord goal = hierarchy->nodes[goalNode];
+    int startSector = startNode / MAX_SECTOR_NODES;
+    int goalSector = goalNode / MAX_SECTOR_NODES;
+
+    hierarchy->searchId++;
+    hierarchy->heapSize = 0;
+    hierarchy->expansions = 0;
+    relax(hierarchy, startNode, startNode, 0, goal);
+
+    while (hierarchy->heapSize > 0) {
+        int priority;
+        int node = heap_pop(hierarchy, &priority);
+        int cost = hierarchy->cost[node];
+
+        // skip stale entries for nodes already reached more cheaply
+        if (priority > cost + manhattan_dist(hierarchy->nodes[node], goal)) continue;
+        hierarchy->expansions++;
+
+        if (node == goalNode) {
+            int length = 0;
+            for (int n = node; n != startNode; n = hierarchy->parent[n]) length++;
+            int i = length + 1;
+            for (int n = node; ; n = hierarchy->parent[n]) {
+                hierarchy->abstractRoute[--i] = n;
+                if (n == startNode) break;
+            }
+            return length + 1;
+        }
+
+        // every other node of the sector it can reach, including the goal if this is the goal's sector
+        int sector = node / MAX_SECTOR_NODES;
+        int slot = node % MAX_SECTOR_NODES;
+        int numSlots = hierarchy->numNodes[sector] + (sector == startSector || sector == goalSector);
+        for (int other = 0; other < numSlots; other++) {
+            unsigned short dist = *sector_dist(hierarchy, sector, slot, other);
+            if (other == slot || dist == NO_DIST) continue;
+            relax(hierarchy, sector*MAX_SECTOR_NODES + other, node, cost + dist, goal);
+        }
+
+        // and across the border, unless it is the start or goal
+        if (slot < hierarchy->numNodes[sector]) {
+            int partner = find_partner(hierarchy, memory, node);
+            if (partner != -1) relax(hierarchy, partner, node, cost + 1, goal);
+        }
+    }
+    return 0;
+}
+
+// this function adds the tiles of the shortest route within a sector from one tile to another onto the end of route, not including the first tile; returns 0 if there is no room
+static int add_sector_route(Hierarchy *hierarchy, const TileGrid *memory, Coord from, Coord to, Coord *route, size_t capacity, int *length)
+{
+    if (from.x == to.x && from.y == to.y) return 1;
+
+    int sector = sector_of(hierarchy, from);
+    Coord first, end;
+    sector_bounds(hierarchy, sector, &first, &end);
+    int fromLocal = (from.y - first.y)*SECTOR_SIZE + (from.x - first.x);
+    int toLocal = (to.y - first.y)*SECTOR_SIZE + (to.x - first.x);
+    search_sector(hierarchy, memory, sector, from, &toLocal, 1);
+    int steps = hierarchy->localDist[toLocal];
+    if (steps < 0 || (size_t)(*length + steps) > capacity) return 0;
+
+    int i = *length + steps;
+    for (int local = toLocal; local != fromLocal; local = hierarchy->localParent[local]) {
+        route[--i] = (Coord){first.x + local % SECTOR_SIZE, first.y + local / SECTOR_SIZE};
+    }
+    *length += steps;
+    return 1;
+}
+
+// this function finds a route from start to goal through the sectors, treating unknown tiles as passable, and fills route with the tiles to move through (not including the start); pre-requisite: start and goal are in different sectors; returns S_ERR_UNREACHABLE if there is none, or S_ERR_INTERNAL if route has no room for it
+Status hierarchical_route(Hierarchy *hierarchy, const TileGrid *memory, Coord start, Coord goal, Coord *route, size_t capacity, int *length)
+{
+    *length = 0;
+    if (sector_of(hierarchy, start) == sector_of(hierarchy, goal)) return S_ERR_INTERNAL;
+    if (!is_passable(memory, goal)) return S_ERR_UNREACHABLE;
+
+    // only the start and goal sectors are brought up to date now, the others where obstacles have been found once the search reaches them
+    hierarchy->loadedSector = -1; // memory may have changed since the last route
+    rebuild_sector(hierarchy, memory, sector_of(hierarchy, start));
+    rebuild_sector(hierarchy, memory, sector_of(hierarchy, goal));
+
+    int startNode = add_query_node(hierarchy, memory, start);
+    int goalNode = add_query_node(hierarchy, memory, goal);
+    int numNodes = search_nodes(hierarchy, memory, startNode, goalNode);
+    if (numNodes == 0) return S_ERR_UNREACHABLE;
+
+    // fill in the tiles: nodes in the same sector are joined by the shortest route within it, and partners are next to each other
+    for (int i = 1; i < numNodes; i++) {
+        Coord from = hierarchy->nodes[hierarchy->abstractRoute[i-1]];
+        Coord to = hierarchy->nodes[hierarchy->abstractRoute[i]];
+        if (sector_of(hierarchy, from) != sector_of(hierarchy, to)) {
+            if ((size_t)*length >= capacity) return S_ERR_INTERNAL;
+            route[(*length)++] = to;
+        }
+        else if (!add_sector_route(hierarchy, memory, from, to, route, capacity, length)) {
+            return S_ERR_INTERNAL;
+        }
+    }
+    return S_OK;
+}
@@ -0,0 +1,118 @@
+// This file keeps the robot's knowledge of blocked tiles as packed rows of bits, so jump point search can find the next tile along a row where it has to stop with a single bit scan rather than a tile at a time
+
+#include "../include/jump_grid.h"
+#include "../include/pool.h"
+#include "../include/robot.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// this function returns how many words each row needs, with at least one bit past the right edge so a scan to the right always stops
+static int words_per_row(int width)
+{
+    return (width >> 6) + 1;
+}
+
+// this function returns how many bytes of pool create_jump_grid needs for an arena of the given size
+size_t jump_grid_pool_size(int width, int height)
+{
+    return pool_aligned_size(sizeof(JumpGrid)) + pool_aligned_size((size_t)(height + 2) * words_per_row(width) * sizeof(uint64_t));
+}
+
+// this function creates a grid from the pool for an arena of the given size with no tiles blocked inside it; returns NULL if the pool does not have space
+JumpGrid* create_jump_grid(Pool *pool, int width, int height)
+{
+    JumpGrid *grid = pool_alloc(pool, sizeof(JumpGrid));
+    if (grid == NULL) {
+        fprintf(stderr, "Pool has no space in create_jump_grid\n");
+        return NULL;
+    }
+    grid->width = width;
+    grid->height = height;
+    grid->wordsPerRow = words_per_row(width);
+    grid->blocked = pool_alloc(pool, (size_t)(height + 2) * grid->wordsPerRow * sizeof(uint64_t));
+    if (grid->blocked == NULL) {
+        fprintf(stderr, "Pool has no space for blocked rows in create_jump_grid\n");
+        return NULL;
+    }
+
+    // the padding rows are blocked all the way along, and every row is blocked past the right edge
+    for (int word = 0; word < grid->wordsPerRow; word++) {
+        grid->blocked[word] = UINT64_MAX;
+        grid->blocked[(size_t)(height + 1)*grid->wordsPerRow + word] = UINT64_MAX;
+    }
+    for (int y = 0; y < height; y++) {
+        uint64_t *row = &grid->blocked[(size_t)(y + 1)*grid->wordsPerRow];
+        row[grid->wordsPerRow - 1] = UINT64_MAX << (width & 63);
+    }
+    return grid;
+}
+
+// this function sets every tile the robot's memory has as blocked, for when the grid is created after the robot has learnt some of the arena
+void load_jump_grid(JumpGrid *grid, const TileGrid *memory)
+{
+    for (int y = 0; y < grid->height; y++) {
+        for (int x = 0; x < grid->width; x++) {
+            if (get_tile(memory, x, y) == R_BLOCKED) jump_grid_set_blocked(grid, x, y, 1);
+        }
+    }
+}
+
+// this function marks a tile inside the arena as blocked (1) or passable (0)
+void jump_grid_set_blocked(JumpGrid *grid, int x, int y, int blocked)
+{
+    uint64_t *word = &grid->blocked[(size_t)(y + 1)*grid->wordsPerRow + (x >> 6)];
+    if (blocked) *word |= (uint64_t)1 << (x & 63);
+    else *word &= ~((uint64_t)1 << (x & 63));
+}
+
+// this function returns word i of a row, or a word blocked all the way along for a word off either end of it
+static uint64_t row_word(const uint64_t *row, int i, int wordsPerRow)
+{
+    if (i < 0 || i >= wordsPerRow) return UINT64_MAX;
+    return row[i];
+}
+
+// this function returns the bits of word i of a row where a robot moving along the row in direction dx (1 or -1) has to stop: the tile is blocked, or the tile above or below it is passable while the one before that is blocked, so the row beside it opens up there
+static uint64_t stop_bits(const JumpGrid *grid, int y, int i, int dx)
+{
+    int words = grid->wordsPerRow;
+    const uint64_t *row = &grid->blocked[(size_t)(y + 1)*words];
+    const uint64_t *above = row - words;
+    const uint64_t *below = row + words;
+
+    uint64_t abovePrev, belowPrev; // each bit is whether the tile before it in direction dx is blocked
+    if (dx == 1) {
+        abovePrev = (above[i] << 1) | (i > 0 ? above[i-1] >> 63 : 0);
+        belowPrev = (below[i] << 1) | (i > 0 ? below[i-1] >> 63 : 0);
+    }
+    else {
+        abovePrev = (above[i] >> 1) | (row_word(above, i + 1, words) << 63);
+        belowPrev = (below[i] >> 1) | (row_word(below, i + 1, words) << 63);
+    }
+    return row[i] | (~above[i] & abovePrev) | (~below[i] & belowPrev);
+}
+
+// this function returns the first tile along row y after x in direction dx (1 or -1) where a robot moving along the row would have to stop, either because it is blocked or because the row above or below opens up; returns -1 if there is none before the left edge, while the padding always stops a scan to the right
+int jump_grid_scan(const JumpGrid *grid, int x, int y, int dx)
+{
+    int from = x + dx;
+    if (from < 0) return -1;
+
+    int i = from >> 6;
+    if (dx == 1) {
+        uint64_t bits = stop_bits(grid, y, i, dx) & (UINT64_MAX << (from & 63));
+        while (bits == 0) bits = stop_bits(grid, y, ++i, dx); // the padding past the right edge is blocked
+        return (i << 6) + __builtin_ctzll(bits);
+    }
+
+    uint64_t bits = stop_bits(grid, y, i, dx) & (UINT64_MAX >> (63 - (from & 63)));
+    while (bits == 0) {
+        if (--i < 0) return -1;
+        bits = stop_bits(grid, y, i, dx);
+    }
+    return (i << 6) + 63 - __builtin_clzll(bits);
+}
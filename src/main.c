@@ -1,50 +1,147 @@
 // This is the main file from which other functions are called
 
 #include "../include/arena.h"
+#include "../include/async_output.h"
 #include "../include/config.h"
 #include "../include/drawing.h"
-#include "../include/spiral.h"
+#include "../include/heatmap.h"
+#include "../include/profile.h"
+#include "../include/robot.h"
+#include "../include/simulation.h"
+#include "../include/snapshot.h"
 #include "../include/utils.h"
 
 #include "../lib/graphics.h"
+#include "../lib/output_sink.h"
 
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
 
+// this function prints the phase timings, registered to run at exit when profiling
+static void print_profile_at_exit(void)
+{
+    print_profile(stderr);
+}
+
+// this function checks if a file can be opened for reading, so a missing snapshot starts a new run rather than failing
+static int file_exists(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return 0;
+    fclose(file);
+    return 1;
+}
+
+// this function creates the simulation saved in a snapshot file, rendering it with the given drawing settings
+static Status resume_from_file(const char *path, const DrawConfig *draw, Simulation **sim)
+{
+    Snapshot snapshot = {NULL, 0, 0};
+    Status status = load_snapshot(path, &snapshot);
+    if (status == S_OK) status = sim_restore(&snapshot, draw, sim);
+    free_snapshot(&snapshot);
+    return status;
+}
+
+// this function runs the simulation until all markers are found, saving a snapshot to SNAPSHOT_FILE every SNAPSHOT_INTERVAL actions and once it stops, if set; returns S_OK if they were all found, otherwise the error that stopped it
+static Status run_with_snapshots(Simulation *sim)
+{
+    if (SNAPSHOT_FILE[0] == '\0' || SNAPSHOT_INTERVAL < 1) return sim_run(sim);
+
+    Snapshot snapshot = {NULL, 0, 0}; // the buffer is reused for every snapshot
+    long long actions = 0;
+    Status status;
+    do {
+        status = sim_step(sim);
+        if (++actions % SNAPSHOT_INTERVAL == 0 || status != S_OK) {
+            if (take_snapshot(sim, &snapshot) == S_OK) save_snapshot(&snapshot, SNAPSHOT_FILE); // a failed save is reported but the run carries on
+        }
+    } while (status == S_OK);
+    free_snapshot(&snapshot);
+
+    return status == S_DONE ? S_OK : status;
+}
+
 int main(int argc, char *argv[])
 {
 // setup
-    // seed random with time
-    unsigned int seed = time(NULL);
-    //fprintf(stderr, "%d\n", seed); // used for testing so a configuration that gives a bug can be replayed
-    srand(seed); // seed random with time otherwise arena is the same every time
+    if (PROFILE_PHASES) {
+        profile_enable(1);
+        atexit(print_profile_at_exit);
+    }
 
-    const int ARENA_WIDTH = determine_arena_width(argc, argv); 
-    const int ARENA_HEIGHT = determine_arena_height(argc, argv);
+    // send drawing to the chosen sink rather than always stdout
+    const char *sinkSpec = getenv("DRAW_OUTPUT") != NULL ? getenv("DRAW_OUTPUT") : OUTPUT_SINK;
+    OutputSink *sink = openOutputSink(sinkSpec);
+    if (sink == NULL) return EXIT_FAILURE;
+    setOutputSink(sink);
 
-    // create arena and robot, malloc failures and error messages dealt with in these functions (program brought to early end)
-    Arena *arena = create_arena(ARENA_WIDTH, ARENA_HEIGHT);
-    Robot *robot = create_robot(arena);
+    // hand drawing over to a writer thread so a slow drawapp does not slow the search; the terminal writes its own frames
+    if (ASYNC_OUTPUT && !TERMINAL_OUTPUT && start_async_output(OUTPUT_BUFFER_SIZE, OUTPUT_POLICY) != S_OK) {
+        fprintf(stderr, "Writing to the drawapp directly instead\n");
+    }
 
-// start
-    check_obstacle_marker_values(arena, obstacleFormation, numObstacles, markerFormation, numMarkers);
-    
-    generate_obstacles(arena, numObstacles, obstacleFormation); // have to generate obstacles first
-    place_robot(argc, argv, robot, arena); // use command line arguments to place robot correctly
-    generate_markers(arena, numMarkers, markerFormation); 
-    
-    // render background
-    draw_background(arena);
-    sleep(500);
+    SimConfig config;
+    default_sim_config(&config);
+
+    // seed random with time otherwise arena is the same every time
+    config.seed = time(NULL);
+    set_draw_config(&config.draw); // the maximum arena size depends on the tile size
+    //fprintf(stderr, "%u\n", config.seed); // used for testing so a configuration that gives a bug can be replayed
+
+    config.arenaWidth = determine_arena_width(argc, argv); 
+    config.arenaHeight = determine_arena_height(argc, argv);
+    determine_robot_start(argc, argv, &config.start, &config.startDirection); // use command line arguments to place robot correctly
+    config.render = 1;
+
+    // obstacles that change during the search, read before the simulation is created so they can be checked against the arena; a snapshot has its own
+    int resuming = RESUME_FILE[0] != '\0' && file_exists(RESUME_FILE);
+    ObstacleEvent *events = NULL;
+    if (OBSTACLE_EVENTS_FILE[0] != '\0' && !resuming) {
+        Status status = load_obstacle_events(OBSTACLE_EVENTS_FILE, &events, &config.numObstacleEvents);
+        if (status != S_OK) {
+            stop_async_output();
+            setOutputSink(NULL);
+            closeOutputSink(sink);
+            return EXIT_FAILURE;
+        }
+        config.obstacleEvents = events;
+    }
+
+    // create arena and robot, generate obstacles and markers (or carry on from a snapshot of them) and draw the background
+    Simulation *sim;
+    Status status = resuming ? resume_from_file(RESUME_FILE, &config.draw, &sim) : sim_create(&config, &sim);
+    if (status != S_OK) {
+        fprintf(stderr, "Could not set up simulation: %s\n", status_string(status));
+        free(events);
+        stop_async_output();
+        setOutputSink(NULL);
+        closeOutputSink(sink);
+        return EXIT_FAILURE;
+    }
 
 // loop
-    foreground();
-    find_markers(robot, arena); // using spiral method
+    status = run_with_snapshots(sim); // using spiral method
+    if (status != S_OK) {
+        fprintf(stderr, "Simulation stopped: %s\n", status_string(status));
+    }
+    if (sim->config.carryCapacity > 0) { // the total distance is what a batching strategy is judged on
+        fprintf(stderr, "Delivered %d markers in %d trips, %d moves in total\n", sim->arena->numDelivered, sim->robot->trips, sim->robot->moveCount);
+    }
+    finish_drawing(sim->robot, sim->arena);
 
 // end
-    free_robot(robot);
-    free_arena(arena);
+    // write out where the robot went, even if it did not find every marker
+    if (VISIT_IMAGE_FILE[0] != '\0') export_visits_ppm(sim->robot, sim->arena, VISIT_IMAGE_FILE, 8);
+    if (VISIT_CSV_FILE[0] != '\0') export_visits_csv(sim->robot, VISIT_CSV_FILE);
+    sim_destroy(sim);
+    free(events);
+    stop_async_output(); // waits for everything drawn to be written
+    if (async_output_dropped_frames() > 0) {
+        fprintf(stderr, "%ld frames were dropped as the drawapp could not keep up\n", async_output_dropped_frames());
+    }
+    setOutputSink(NULL);
+    closeOutputSink(sink);
     
-    return 0;
-}
\ No newline at end of file
+    return status == S_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
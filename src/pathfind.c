@@ -0,0 +1,460 @@
+// This file contains route searches over the robot's memory of the arena, used to move to a specific tile rather than following the spiral
+
+#include "../include/dstar.h"
+#include "../include/hierarchy.h"
+#include "../include/jump_grid.h"
+#include "../include/pathfind.h"
+#include "../include/pool.h"
+#include "../include/robot.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+// this function returns how many bytes of pool create_planner needs for an arena of the given size, with room for a search over every (tile, direction) state
+size_t planner_pool_size(int width, int height)
+{
+    size_t numStates = 4 * (size_t)width * height;
+    return pool_aligned_size(sizeof(Planner))
+        + 3 * pool_aligned_size(numStates * sizeof(int))
+        + pool_aligned_size(3 * numStates * sizeof(long long)) // each state can be pushed once per state leading to it (a move or either turn)
+        + pool_aligned_size(numStates * sizeof(Coord));
+}
+
+// this function creates a planner from the pool for an arena of the given size; returns NULL if the pool does not have space; freed when the pool is reset
+Planner* create_planner(Pool *pool, int width, int height)
+{
+    size_t numStates = 4 * (size_t)width * height;
+    Planner *planner = pool_alloc(pool, sizeof(Planner));
+    if (planner == NULL) {
+        fprintf(stderr, "Pool has no space in create_planner\n");
+        return NULL;
+    }
+
+    planner->width = width;
+    planner->height = height;
+    planner->turnAware = 0;
+    planner->moveCost = 1;
+    planner->turnCost = 1;
+    planner->cost = pool_alloc(pool, numStates * sizeof(int));
+    planner->parent = pool_alloc(pool, numStates * sizeof(int));
+    planner->searchMark = pool_alloc(pool, numStates * sizeof(int)); // zeroed, and searchId starts above 0
+    planner->heapCapacity = 3 * numStates;
+    planner->heap = pool_alloc(pool, planner->heapCapacity * sizeof(long long));
+    planner->route = pool_alloc(pool, numStates * sizeof(Coord)); // a route can cross a tile once per direction
+    if (planner->cost == NULL || planner->parent == NULL || planner->searchMark == NULL || planner->heap == NULL || planner->route == NULL) {
+        fprintf(stderr, "Pool has no space for planner arrays in create_planner\n");
+        return NULL;
+    }
+    planner->searchId = 0;
+    planner->heapSize = 0;
+    planner->routeLength = 0;
+    planner->routeNext = 0;
+    planner->routeGoal = (Coord){-1, -1};
+    planner->expansions = 0;
+    planner->hierarchy = NULL;
+    planner->jumpGrid = NULL;
+    planner->dstar = NULL;
+    return planner;
+}
+
+// functions for the open set heap:
+
+// this function pushes a tile onto the open set with a priority
+static void heap_push(Planner *planner, int priority, int tile)
+{
+    long long *heap = planner->heap;
+    int i = planner->heapSize++;
+    heap[i] = ((long long)priority << 32) | (unsigned int)tile;
+
+    // sift up
+    while (i > 0 && heap[(i-1)/2] > heap[i]) {
+        long long tmp = heap[i];
+        heap[i] = heap[(i-1)/2];
+        heap[(i-1)/2] = tmp;
+        i = (i-1)/2;
+    }
+}
+
+// this function pops the tile with the lowest priority from the open set, setting its priority
+static int heap_pop(Planner *planner, int *priority)
+{
+    long long *heap = planner->heap;
+    long long top = heap[0];
+    heap[0] = heap[--planner->heapSize];
+
+    // sift down
+    int i = 0;
+    while (1) {
+        int smallest = i;
+        int left = 2*i + 1;
+        int right = 2*i + 2;
+        if (left < planner->heapSize && heap[left] < heap[smallest]) smallest = left;
+        if (right < planner->heapSize && heap[right] < heap[smallest]) smallest = right;
+        if (smallest == i) break;
+        long long tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+
+    *priority = (int)(top >> 32);
+    return (int)(top & 0xFFFFFFFF);
+}
+
+// functions for searching:
+
+// this function returns the distance ignoring obstacles between two tiles, which never overestimates the moves needed
+static int manhattan_dist(Coord a, Coord b)
+{
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+// this function copies the route ending at a tile out of the parent links, from the tile after the start to the end tile
+static void build_route(Planner *planner, int startTile, int endTile)
+{
+    int length = 0;
+    for (int tile = endTile; tile != startTile; tile = planner->parent[tile]) length++;
+
+    int i = length;
+    for (int tile = endTile; tile != startTile; tile = planner->parent[tile]) {
+        planner->route[--i] = (Coord){tile % planner->width, tile / planner->width};
+    }
+    planner->routeLength = length;
+    planner->routeNext = 0;
+    planner->routeGoal = (Coord){endTile % planner->width, endTile / planner->width};
+}
+
+// this function runs A* from start to goal, or a breadth first search to the nearest unknown tile if goal is {-1, -1}; with knownOnly set, only tiles the robot has been on (and the goal) are moved through; returns S_ERR_UNREACHABLE if there is no route
+static Status search(Planner *planner, const TileGrid *memory, Coord start, Coord goal, int knownOnly)
+{
+    int width = planner->width;
+    int seekUnknown = goal.x == -1 && goal.y == -1;
+    int startTile = start.y*width + start.x;
+
+    planner->searchId++;
+    planner->heapSize = 0;
+    planner->expansions = 0;
+    planner->routeLength = 0;
+    planner->routeNext = 0;
+
+    planner->searchMark[startTile] = planner->searchId;
+    planner->cost[startTile] = 0;
+    planner->parent[startTile] = startTile;
+    heap_push(planner, seekUnknown ? 0 : manhattan_dist(start, goal), startTile);
+
+    while (planner->heapSize > 0) {
+        int priority;
+        int tile = heap_pop(planner, &priority);
+        Coord coord = {tile % width, tile / width};
+        int cost = planner->cost[tile];
+
+        // skip stale entries for tiles already reached more cheaply
+        if (priority > cost + (seekUnknown ? 0 : manhattan_dist(coord, goal))) continue;
+        planner->expansions++;
+
+        if ((seekUnknown && get_tile(memory, coord.x, coord.y) == R_UNKNOWN) || (!seekUnknown && coord.x == goal.x && coord.y == goal.y)) {
+            build_route(planner, startTile, tile);
+            return S_OK;
+        }
+
+        // an unknown tile is only entered to find out what it is, so the search does not route through it when looking for unknown tiles
+        for (Direction dir = NORTH; dir <= WEST; dir++) {
+            Coord next = coord;
+            if (dir == NORTH) next.y--;
+            if (dir == EAST) next.x++;
+            if (dir == SOUTH) next.y++;
+            if (dir == WEST) next.x--;
+            if (!check_coord_in_bounds(next, width, planner->height)) continue;
+            RobotTile known = get_tile(memory, next.x, next.y);
+            if (known == R_BLOCKED) continue;
+            if (knownOnly && known != R_VISITED && (next.x != goal.x || next.y != goal.y)) continue;
+
+            int nextTile = next.y*width + next.x;
+            if (planner->searchMark[nextTile] == planner->searchId && planner->cost[nextTile] <= cost + 1) continue;
+
+            planner->searchMark[nextTile] = planner->searchId;
+            planner->cost[nextTile] = cost + 1;
+            planner->parent[nextTile] = tile;
+            heap_push(planner, cost + 1 + (seekUnknown ? 0 : manhattan_dist(next, goal)), nextTile);
+        }
+    }
+    return S_ERR_UNREACHABLE;
+}
+
+// functions for jump point search:
+
+// this function returns the tile a horizontal move in direction dx from (x, y) jumps to: the goal, or the first tile where a row beside opens up; returns -1 if the move runs into an obstacle or the edge first
+static int jump_horizontal(const JumpGrid *grid, int x, int y, int dx, Coord goal)
+{
+    int stop = jump_grid_scan(grid, x, y, dx);
+    if (y == goal.y && (goal.x - x)*dx > 0 && (stop == -1 || (stop - goal.x)*dx >= 0)) return goal.x;
+    if (stop == -1 || jump_grid_blocked(grid, stop, y)) return -1;
+    return stop;
+}
+
+// this function returns the tile a vertical move in direction dy from (x, y) jumps to: the goal, or the first tile from which a horizontal move would jump somewhere; returns -1 if the move runs into an obstacle or the edge first
+static int jump_vertical(const JumpGrid *grid, int x, int y, int dy, Coord goal)
+{
+    while (1) {
+        y += dy;
+        if (jump_grid_blocked(grid, x, y)) return -1;
+        if (x == goal.x && y == goal.y) return y;
+        if (jump_horizontal(grid, x, y, 1, goal) != -1 || jump_horizontal(grid, x, y, -1, goal) != -1) return y;
+    }
+}
+
+// this function copies the route through the jump points ending at a tile out of the parent links, filling in the straight line between each pair of jump points
+static void build_jump_route(Planner *planner, int startTile, int endTile)
+{
+    int width = planner->width;
+    int length = 0;
+    for (int tile = endTile; tile != startTile; tile = planner->parent[tile]) length += planner->cost[tile] - planner->cost[planner->parent[tile]];
+
+    int i = length;
+    for (int tile = endTile; tile != startTile; tile = planner->parent[tile]) {
+        int from = planner->parent[tile];
+        int step = tile % width != from % width ? (tile > from ? 1 : -1) : (tile > from ? width : -width);
+        for (int t = tile; t != from; t -= step) planner->route[--i] = (Coord){t % width, t / width};
+    }
+    planner->routeLength = length;
+    planner->routeNext = 0;
+    planner->routeGoal = (Coord){endTile % width, endTile / width};
+}
+
+// this function runs A* from start to goal over jump points rather than every tile: moving vertically the robot may turn at any tile, but moving horizontally it only stops where the row beside it opens up, so straight runs through open space cost one expansion; returns S_ERR_UNREACHABLE if there is no route
+static Status search_jump_points(Planner *planner, Coord start, Coord goal)
+{
+    const JumpGrid *grid = planner->jumpGrid;
+    int width = planner->width;
+    int startTile = start.y*width + start.x;
+
+    planner->searchId++;
+    planner->heapSize = 0;
+    planner->expansions = 0;
+    planner->routeLength = 0;
+    planner->routeNext = 0;
+    if (jump_grid_blocked(grid, goal.x, goal.y)) return S_ERR_UNREACHABLE;
+
+    planner->searchMark[startTile] = planner->searchId;
+    planner->cost[startTile] = 0;
+    planner->parent[startTile] = startTile;
+    heap_push(planner, manhattan_dist(start, goal), startTile);
+
+    while (planner->heapSize > 0) {
+        int priority;
+        int tile = heap_pop(planner, &priority);
+        Coord coord = {tile % width, tile / width};
+        int cost = planner->cost[tile];
+
+        // skip stale entries for tiles already reached more cheaply
+        if (priority > cost + manhattan_dist(coord, goal)) continue;
+        planner->expansions++;
+
+        if (coord.x == goal.x && coord.y == goal.y) {
+            build_jump_route(planner, startTile, tile);
+            return S_OK;
+        }
+
+        // which way it was reached decides which directions are worth carrying on in: all four from the start, straight on and both sides after a vertical move, and straight on plus any side that has opened up after a horizontal move
+        int parent = planner->parent[tile];
+        int dx = tile == parent || parent / width != coord.y ? 0 : (tile > parent ? 1 : -1);
+        int dy = tile == parent || parent / width == coord.y ? 0 : (tile > parent ? 1 : -1);
+        for (Direction dir = NORTH; dir <= WEST; dir++) {
+            int stepX = dir == EAST ? 1 : dir == WEST ? -1 : 0;
+            int stepY = dir == SOUTH ? 1 : dir == NORTH ? -1 : 0;
+            if (stepX == -dx && stepY == -dy && tile != parent) continue; // never straight back
+            if (dx != 0 && stepY != 0 && (jump_grid_blocked(grid, coord.x, coord.y + stepY) || !jump_grid_blocked(grid, coord.x - dx, coord.y + stepY))) continue;
+
+            Coord next = coord;
+            if (stepX != 0) next.x = jump_horizontal(grid, coord.x, coord.y, stepX, goal);
+            else next.y = jump_vertical(grid, coord.x, coord.y, stepY, goal);
+            if (next.x == -1 || next.y == -1) continue;
+
+            int nextTile = next.y*width + next.x;
+            int nextCost = cost + manhattan_dist(coord, next);
+            if (planner->searchMark[nextTile] == planner->searchId && planner->cost[nextTile] <= nextCost) continue;
+
+            planner->searchMark[nextTile] = planner->searchId;
+            planner->cost[nextTile] = nextCost;
+            planner->parent[nextTile] = tile;
+            heap_push(planner, nextCost + manhattan_dist(next, goal), nextTile);
+        }
+    }
+    return S_ERR_UNREACHABLE;
+}
+
+// this function returns a cost that never overestimates a turn aware route between two tiles: the moves, plus a turn if the route has to go both across and up or down
+static int turn_aware_estimate(Planner *planner, Coord a, Coord b)
+{
+    int turns = a.x != b.x && a.y != b.y;
+    return manhattan_dist(a, b)*planner->moveCost + turns*planner->turnCost;
+}
+
+// this function copies the route ending at a state out of the parent links, keeping only the states where the robot moves onto a new tile
+static void build_turn_aware_route(Planner *planner, int startState, int endState)
+{
+    int length = 0;
+    for (int state = endState; state != startState; state = planner->parent[state]) {
+        if (planner->parent[state]/4 != state/4) length++;
+    }
+
+    int i = length;
+    for (int state = endState; state != startState; state = planner->parent[state]) {
+        if (planner->parent[state]/4 == state/4) continue; // a turn on the spot
+        int tile = state/4;
+        planner->route[--i] = (Coord){tile % planner->width, tile / planner->width};
+    }
+    planner->routeLength = length;
+    planner->routeNext = 0;
+    planner->routeGoal = (Coord){(endState/4) % planner->width, (endState/4) / planner->width};
+}
+
+// this function runs A* over (tile, direction) states from start to goal, or Dijkstra to the cheapest unknown tile if goal is {-1, -1}, so turns are costed as well as moves; returns S_ERR_UNREACHABLE if there is no route
+static Status search_with_turns(Planner *planner, const TileGrid *memory, Coord start, Direction startDir, Coord goal)
+{
+    int width = planner->width;
+    int seekUnknown = goal.x == -1 && goal.y == -1;
+    int startState = (start.y*width + start.x)*4 + startDir;
+
+    planner->searchId++;
+    planner->heapSize = 0;
+    planner->expansions = 0;
+    planner->routeLength = 0;
+    planner->routeNext = 0;
+
+    planner->searchMark[startState] = planner->searchId;
+    planner->cost[startState] = 0;
+    planner->parent[startState] = startState;
+    heap_push(planner, seekUnknown ? 0 : turn_aware_estimate(planner, start, goal), startState);
+
+    while (planner->heapSize > 0) {
+        int priority;
+        int state = heap_pop(planner, &priority);
+        int tile = state/4;
+        Direction dir = state%4;
+        Coord coord = {tile % width, tile / width};
+        int cost = planner->cost[state];
+
+        // skip stale entries for states already reached more cheaply
+        if (priority > cost + (seekUnknown ? 0 : turn_aware_estimate(planner, coord, goal))) continue;
+        planner->expansions++;
+
+        if ((seekUnknown && get_tile(memory, coord.x, coord.y) == R_UNKNOWN) || (!seekUnknown && coord.x == goal.x && coord.y == goal.y)) {
+            build_turn_aware_route(planner, startState, state);
+            return S_OK;
+        }
+
+        // the robot can move forward, or turn left or right on the spot
+        for (int action = 0; action < 3; action++) {
+            int nextState;
+            int nextCost;
+            Coord next = coord;
+            if (action == 0) {
+                if (dir == NORTH) next.y--;
+                if (dir == EAST) next.x++;
+                if (dir == SOUTH) next.y++;
+                if (dir == WEST) next.x--;
+                if (!check_coord_in_bounds(next, width, planner->height)) continue;
+                if (get_tile(memory, next.x, next.y) == R_BLOCKED) continue;
+                nextState = (next.y*width + next.x)*4 + dir;
+                nextCost = cost + planner->moveCost;
+            }
+            else {
+                nextState = tile*4 + (action == 1 ? (dir + 3) % 4 : (dir + 1) % 4);
+                nextCost = cost + planner->turnCost;
+            }
+
+            if (planner->searchMark[nextState] == planner->searchId && planner->cost[nextState] <= nextCost) continue;
+
+            planner->searchMark[nextState] = planner->searchId;
+            planner->cost[nextState] = nextCost;
+            planner->parent[nextState] = state;
+            heap_push(planner, nextCost + (seekUnknown ? 0 : turn_aware_estimate(planner, next, goal)), nextState);
+        }
+    }
+    return S_ERR_UNREACHABLE;
+}
+
+// this function finds a route from start to goal through the planner's hierarchy, falling back to searching tile by tile if the route does not fit
+static Status search_hierarchy(Planner *planner, const TileGrid *memory, Coord start, Coord goal)
+{
+    planner->routeNext = 0;
+    Status status = hierarchical_route(planner->hierarchy, memory, start, goal, planner->route, 4 * (size_t)planner->width * planner->height, &planner->routeLength);
+    planner->expansions = planner->hierarchy->expansions;
+    if (status == S_ERR_INTERNAL) return search(planner, memory, start, goal, 0);
+    planner->routeGoal = goal;
+    return status;
+}
+
+// this function finds the shortest route from start to goal with the planner's incremental search, falling back to A* if the route does not fit
+static Status search_incremental(Planner *planner, const TileGrid *memory, Coord start, Coord goal)
+{
+    planner->routeNext = 0;
+    Status status = dstar_route(planner->dstar, memory, start, goal, planner->route, 4 * (size_t)planner->width * planner->height, &planner->routeLength);
+    planner->expansions = planner->dstar->expansions;
+    if (status == S_ERR_INTERNAL) return search(planner, memory, start, goal, 0);
+    planner->routeGoal = goal;
+    return status;
+}
+
+// this function finds the shortest route from start to goal (cheapest in moves and turns if the planner is turn aware), treating unknown tiles as passable; returns S_ERR_UNREACHABLE if there is none
+// with an incremental search, every route that does not need to be turn aware goes through it so it can be repaired when tiles change; otherwise with a hierarchy, long routes that do not need to be turn aware are found through it instead, which is much quicker but may be a few moves longer than the shortest
+Status plan_route_to_tile(Planner *planner, const TileGrid *memory, Coord start, Direction startDir, Coord goal)
+{
+    if (planner->turnAware) return search_with_turns(planner, memory, start, startDir, goal);
+    if (planner->dstar != NULL) return search_incremental(planner, memory, start, goal);
+    if (planner->hierarchy != NULL && manhattan_dist(start, goal) >= HIERARCHY_MIN_DISTANCE) return search_hierarchy(planner, memory, start, goal);
+    if (planner->jumpGrid != NULL) return search_jump_points(planner, start, goal);
+    return search(planner, memory, start, goal, 0);
+}
+
+// this function finds the shortest route from start to the nearest unknown tile (cheapest in moves and turns if the planner is turn aware); returns S_ERR_UNREACHABLE if every reachable tile is known
+Status plan_route_to_unknown(Planner *planner, const TileGrid *memory, Coord start, Direction startDir)
+{
+    if (planner->turnAware) return search_with_turns(planner, memory, start, startDir, (Coord){-1, -1});
+    return search(planner, memory, start, (Coord){-1, -1}, 0);
+}
+
+// this function finds the shortest route from start to goal through tiles the robot has already been on, so it never runs into an obstacle it has not seen (unless obstacles change); returns S_ERR_UNREACHABLE if there is none
+Status plan_route_over_known(Planner *planner, const TileGrid *memory, Coord start, Coord goal)
+{
+    return search(planner, memory, start, goal, 1);
+}
+
+// this function is told each tile the robot finds to be blocked, so the hierarchy, jump grid and incremental search (if the planner has them) stay in step with its memory
+void planner_tile_blocked(Planner *planner, int x, int y)
+{
+    if (planner->hierarchy != NULL) hierarchy_tile_changed(planner->hierarchy, x, y);
+    if (planner->jumpGrid != NULL) jump_grid_set_blocked(planner->jumpGrid, x, y, 1);
+    if (planner->dstar != NULL) dstar_tile_changed(planner->dstar, x, y);
+}
+
+// this function is told each tile the robot remembered as blocked that it finds to be passable again, when obstacles can move
+void planner_tile_opened(Planner *planner, int x, int y)
+{
+    if (planner->hierarchy != NULL) hierarchy_tile_changed(planner->hierarchy, x, y);
+    if (planner->jumpGrid != NULL) jump_grid_set_blocked(planner->jumpGrid, x, y, 0);
+    if (planner->dstar != NULL) dstar_tile_changed(planner->dstar, x, y);
+}
+
+// functions for following a route:
+
+// this function checks if every tile of the route has been moved onto
+int route_finished(Planner *planner)
+{
+    return planner->routeNext >= planner->routeLength;
+}
+
+// this function returns the next tile of the route to move onto; pre-requisite: route_finished() is false
+Coord next_route_tile(Planner *planner)
+{
+    return planner->route[planner->routeNext];
+}
+
+// this function marks the next tile of the route as reached
+void advance_route(Planner *planner)
+{
+    planner->routeNext++;
+}
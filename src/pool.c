@@ -0,0 +1,64 @@
+// This file contains a bump allocator so that all storage for a simulation comes from one block which is reused between runs
+
+#include "../include/pool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define POOL_ALIGNMENT 16
+
+// this function rounds a size up so that the next allocation stays aligned; used to work out how big a pool needs to be
+size_t pool_aligned_size(size_t size)
+{
+    return (size + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1);
+}
+
+// this function creates a pool with a block of the given capacity in bytes; returns NULL if memory could not be allocated; caller has responsibility to free
+Pool* create_pool(size_t capacity)
+{
+    Pool *pool = malloc(sizeof(Pool));
+    if (pool == NULL) {
+        fprintf(stderr, "Malloc returned null for pool in create_pool\n");
+        return NULL;
+    }
+
+    // malloc aligns to at least POOL_ALIGNMENT on the platforms we build for
+    pool->block = malloc(capacity);
+    if (pool->block == NULL) {
+        fprintf(stderr, "Malloc returned null for pool block of %zu bytes in create_pool\n", capacity);
+        free(pool);
+        return NULL;
+    }
+    pool->capacity = capacity;
+    pool->used = 0;
+    return pool;
+}
+
+// this function returns zeroed memory of the given size from the pool, or NULL if the pool does not have enough space left
+void* pool_alloc(Pool *pool, size_t size)
+{
+    size = pool_aligned_size(size);
+    if (size > pool->capacity - pool->used) {
+        fprintf(stderr, "Pool of %zu bytes has no space for %zu more bytes in pool_alloc\n", pool->capacity, size);
+        return NULL;
+    }
+
+    void *memory = pool->block + pool->used;
+    pool->used += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+// this function releases every allocation made from the pool so its block can be reused
+void pool_reset(Pool *pool)
+{
+    pool->used = 0;
+}
+
+// this function frees the pool and its block
+void free_pool(Pool *pool)
+{
+    free(pool->block);
+    free(pool);
+}
@@ -0,0 +1,126 @@
+// This file contains lightweight timers for the phases of a run, and prints a summary of where the time went
+
+#include "../include/profile.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define PROFILE_BUCKETS 40 // histogram bucket i holds times from 2^i to 2^(i+1) nanoseconds
+
+// totals for one phase
+typedef struct {
+    long long count;
+    long long totalNanos;
+    long long minNanos;
+    long long maxNanos;
+    long long buckets[PROFILE_BUCKETS];
+} PhaseTimes;
+
+static int profileEnabled = 0;
+static PhaseTimes phaseTimes[PF_NUM_PHASES];
+
+static const char *phaseNames[PF_NUM_PHASES] = {
+    "generate_obstacles", "generate_markers", "place_robot", "draw_background",
+    "reach_start_step", "spiral_step", "backtrack_step", "move_to_unknown_step", "route_step", "draw_foreground", "sense_markers", "obstacle_events", "deliver"
+};
+
+// this function turns the timers on or off; they are off by default so timing costs nothing but a check
+void profile_enable(int enabled)
+{
+    profileEnabled = enabled;
+}
+
+// this function returns the current time in nanoseconds to pass to profile_stop, or 0 if profiling is off
+long long profile_start(void)
+{
+    if (!profileEnabled) return 0;
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec*1000000000LL + time.tv_nsec;
+}
+
+// this function adds the time since start to a phase
+void profile_stop(ProfilePhase phase, long long start)
+{
+    if (!profileEnabled) return;
+    long long elapsed = profile_start() - start;
+
+    PhaseTimes *times = &phaseTimes[phase];
+    if (times->count == 0 || elapsed < times->minNanos) times->minNanos = elapsed;
+    if (elapsed > times->maxNanos) times->maxNanos = elapsed;
+    times->count++;
+    times->totalNanos += elapsed;
+
+    int bucket = 0;
+    while (bucket < PROFILE_BUCKETS - 1 && (elapsed >> (bucket + 1)) > 0) bucket++;
+    times->buckets[bucket]++;
+}
+
+// this function clears every phase's times
+void reset_profile(void)
+{
+    for (int phase = 0; phase < PF_NUM_PHASES; phase++) {
+        phaseTimes[phase] = (PhaseTimes){0};
+    }
+}
+
+// this function writes a duration in nanoseconds with a readable unit
+static void print_duration(FILE *out, double nanos)
+{
+    if (nanos < 1e3) fprintf(out, "%7.0fns", nanos);
+    else if (nanos < 1e6) fprintf(out, "%7.1fus", nanos / 1e3);
+    else fprintf(out, "%7.1fms", nanos / 1e6);
+}
+
+// this function prints a table of each phase's times and a histogram of how long each call of it took
+void print_profile(FILE *out)
+{
+    // draw_foreground is called within the steps, so it is left out of the total the shares are of
+    long long totalNanos = 0;
+    for (int phase = 0; phase < PF_NUM_PHASES; phase++) {
+        if (phase != PF_DRAW_FOREGROUND) totalNanos += phaseTimes[phase].totalNanos;
+    }
+    if (totalNanos == 0) totalNanos = 1;
+
+    fprintf(out, "phase                     calls      total       mean        min        max  share\n");
+    for (int phase = 0; phase < PF_NUM_PHASES; phase++) {
+        PhaseTimes *times = &phaseTimes[phase];
+        if (times->count == 0) continue;
+        fprintf(out, "%-20s %10lld ", phaseNames[phase], times->count);
+        print_duration(out, times->totalNanos);
+        fprintf(out, "  ");
+        print_duration(out, (double)times->totalNanos / times->count);
+        fprintf(out, "  ");
+        print_duration(out, times->minNanos);
+        fprintf(out, "  ");
+        print_duration(out, times->maxNanos);
+        fprintf(out, "  %4.1f%%\n", 100.0 * times->totalNanos / totalNanos);
+    }
+    fprintf(out, "(step phases include the draw_foreground calls made within them, so its share is of the same total)\n");
+
+    for (int phase = 0; phase < PF_NUM_PHASES; phase++) {
+        PhaseTimes *times = &phaseTimes[phase];
+        if (times->count == 0) continue;
+
+        long long most = 0;
+        int first = PROFILE_BUCKETS;
+        int last = 0;
+        for (int i = 0; i < PROFILE_BUCKETS; i++) {
+            if (times->buckets[i] == 0) continue;
+            if (times->buckets[i] > most) most = times->buckets[i];
+            if (i < first) first = i;
+            last = i;
+        }
+
+        fprintf(out, "\n%s\n", phaseNames[phase]);
+        for (int i = first; i <= last; i++) {
+            fprintf(out, "  >=");
+            print_duration(out, (double)(1LL << i));
+            fprintf(out, " |");
+            int barLength = (int)(40 * times->buckets[i] / most);
+            if (barLength == 0 && times->buckets[i] > 0) barLength = 1;
+            for (int j = 0; j < barLength; j++) fputc('#', out);
+            fprintf(out, " %lld\n", times->buckets[i]);
+        }
+    }
+}
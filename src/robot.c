@@ -2,6 +2,8 @@
 
 #include "../include/arena.h"
 #include "../include/drawing.h"
+#include "../include/pathfind.h"
+#include "../include/pool.h"
 #include "../include/robot.h"
 #include "../include/utils.h"
 
@@ -40,24 +42,30 @@ void forward(Robot *robot)
     Coord coord = get_coord_in_direction(robot, robot->direction);
     robot->x = coord.x;
     robot->y = coord.y;
+    robot->moveCount++;
+
+    unsigned int visits = get_tile(&robot->visitCounts, robot->x, robot->y);
+    if (visits < UINT16_MAX) set_tile(&robot->visitCounts, robot->x, robot->y, visits + 1);
 }
 
 // this function rotates the robot 90 degrees anticlockwise (left 90 degree turn)
 void turn_left(Robot *robot) 
 {
     robot->direction = (robot->direction + 3) % 4;
+    robot->turnCount++;
 }
 
 // this function rotates the robot 90 degrees clockwise (right 90 degree turn)
 void turn_right(Robot *robot) 
 {
     robot->direction = (robot->direction + 1) % 4;
+    robot->turnCount++;
 }
 
 // this function checks if the robot is at the marker
 int is_at_marker(Robot *robot, Arena *arena) 
 {
-    return arena->arenaGrid[robot->y][robot->x] == T_MARKER;
+    return get_tile(&arena->arenaGrid, robot->x, robot->y) == T_MARKER;
 }
 
 // this function checks if the robot can move forward
@@ -69,7 +77,7 @@ int can_move_forward(Robot *robot, Arena *arena)
     if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) return 0;
 
     // check if it hits an obstacle
-    int obstacle_ahead = arena->arenaGrid[coord.y][coord.x] == T_OBSTACLE;
+    int obstacle_ahead = get_tile(&arena->arenaGrid, coord.x, coord.y) == T_OBSTACLE;
 
     return !obstacle_ahead; // negate as function returns true if in bounds and not obstacle
 }
@@ -77,17 +85,22 @@ int can_move_forward(Robot *robot, Arena *arena)
 // this function removes a marker from the arena and adds it to the robot's collection; pre-requisite: is_at_marker() is true
 void pickup_marker(Robot *robot, Arena *arena) 
 {
-    arena->arenaGrid[robot->y][robot->x] = T_EMPTY;
-    arena->numMarker--;
+    remove_marker(arena, robot->x, robot->y);
     robot->markerCount++;
 }
 
-// this function drops a marker onto the grid; pre-requesite: is_at_marker() is false
-void drop_marker(Robot *robot, Arena *arena) 
+// this function drops a marker the robot is carrying, delivering it if the robot is on the depot and otherwise putting it back onto the grid; pre-requesite: the robot is carrying a marker and, away from the depot, is_at_marker() is false
+Status drop_marker(Robot *robot, Arena *arena) 
 {
+    if (robot->x == arena->depot.x && robot->y == arena->depot.y) {
+        arena->numDelivered++;
+    }
+    else {
+        Status status = add_marker(arena, robot->x, robot->y);
+        if (status != S_OK) return status;
+    }
     robot->markerCount--;
-    arena->numMarker++;
-    arena->arenaGrid[robot->y][robot->x] = T_MARKER;
+    return S_OK;
 }
 
 // this function returns the number of markers the robot is carrying
@@ -96,6 +109,12 @@ int get_marker_carry_count(Robot *robot)
     return robot->markerCount;
 }
 
+// this function checks if the robot has room to pick up another marker
+int can_carry_marker(Robot *robot)
+{
+    return robot->carryCapacity == 0 || robot->markerCount < robot->carryCapacity;
+}
+
 // this function returns the number of markers left on the grid
 int get_marker_arena_count(Arena *arena) 
 {
@@ -110,7 +129,7 @@ int check_forward_tile_unknown(Robot *robot)
     // check for out of bounds
     if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) return 0;
 
-    return robot->memory[coord.y][coord.x] == R_UNKNOWN; // other options are visited and blocked, neither of which we want
+    return get_tile(&robot->memory, coord.x, coord.y) == R_UNKNOWN; // other options are visited and blocked, neither of which we want
 }
 
 // this function checks the robot's memory to see if the tile to its left is unknown (and reachable)
@@ -121,13 +140,14 @@ int check_left_tile_unknown(Robot *robot)
     // check for out of bounds
     if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) return 0;
 
-    return robot->memory[coord.y][coord.x] == R_UNKNOWN; // other options are visited and blocked, neither of which we want
+    return get_tile(&robot->memory, coord.x, coord.y) == R_UNKNOWN; // other options are visited and blocked, neither of which we want
 }
 
 // this function sets the current tile to visited in robot's memory
 void mark_current_tile_visited(Robot *robot)
 {
-    robot->memory[robot->y][robot->x] = R_VISITED;
+    if (get_tile(&robot->memory, robot->x, robot->y) == R_UNKNOWN) robot->knownTiles++;
+    set_tile(&robot->memory, robot->x, robot->y, R_VISITED);
 }
 
 // this function marks the tile in front as obstacle if not out of bounds
@@ -138,13 +158,15 @@ void mark_ahead_tile_obstacle(Robot *robot)
     // check out of bounds
     if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) return;
 
-    robot->memory[coord.y][coord.x] = R_BLOCKED;
+    if (get_tile(&robot->memory, coord.x, coord.y) == R_UNKNOWN) robot->knownTiles++;
+    set_tile(&robot->memory, coord.x, coord.y, R_BLOCKED);
+    if (robot->planner != NULL) planner_tile_blocked(robot->planner, coord.x, coord.y);
 }
 
 // this function returns true if the given coord is a known tile (visited or a known obstacle)
 int is_tile_known(Robot *robot, Coord tile) 
 {
-    return robot->memory[tile.y][tile.x] == R_VISITED || robot->memory[tile.y][tile.x] == R_BLOCKED;
+    return get_tile(&robot->memory, tile.x, tile.y) == R_VISITED || get_tile(&robot->memory, tile.x, tile.y) == R_BLOCKED;
 }
 
 // this function checks if the robot is surrounded by visited tiles and is trapped in the spiral algorithm
@@ -171,7 +193,7 @@ int is_surrounded_by_known(Robot *robot)
 
 }
 
-// this function gets an adjacent tile that is unvisited; pre-requisite: there is an adjacent unvisited tile
+// this function gets an adjacent tile that is unvisited, returning {-1, -1} if there is none
 Coord adjacent_unvisited_tile(Robot *robot)
 {
     Coord n = get_coord_in_direction(robot, NORTH);
@@ -186,160 +208,242 @@ Coord adjacent_unvisited_tile(Robot *robot)
     if (check_coord_in_bounds(w, robot->arenaWidth, robot->arenaHeight) && !is_tile_known(robot, w)) return w;
 
     fprintf(stderr, "Reached end of adjacent_unvisited_tile without finding an unvisited adjacent tile\n");
-    exit(EXIT_FAILURE);
+    return (Coord){-1, -1};
 }
 
 // this function counts the number of unknown tiles in the arena
-int num_unknown_tiles(Robot *robot)
+long long num_unknown_tiles(Robot *robot)
+{
+    return (long long)robot->arenaWidth*robot->arenaHeight - robot->knownTiles; // kept up to date as tiles are marked, rather than scanning memory
+}
+
+// this function returns the marker within the robot's sensing radius (straight line distance) that is the fewest moves away ignoring obstacles, or {-1, -1} if there is none
+Coord sense_marker(Robot *robot, Arena *arena)
+{
+    return nearest_marker(arena, (Coord){robot->x, robot->y}, robot->senseRadius);
+}
+
+// this function marks every obstacle in the arena as blocked in the robot's memory, for when it is given the arena up front
+void learn_arena_obstacles(Robot *robot, Arena *arena)
 {
-    int count = 0;
     for (int y = 0; y < robot->arenaHeight; y++) {
         for (int x = 0; x < robot->arenaWidth; x++) {
-            if (robot->memory[y][x] == R_UNKNOWN) count++;
+            if (get_tile(&arena->arenaGrid, x, y) != T_OBSTACLE) continue;
+            if (get_tile(&robot->memory, x, y) == R_UNKNOWN) robot->knownTiles++;
+            set_tile(&robot->memory, x, y, R_BLOCKED);
+            if (robot->planner != NULL) planner_tile_blocked(robot->planner, x, y);
         }
     }
-    return count;
 }
 
-// functions to deal with robot struct:
-
-// this function allocates memory for robot's memory
-static void allocate_robots_memory(Robot *robot)
+// this function updates the robot's memory of the four tiles next to it from the arena, for when obstacles can appear and disappear: a tile it remembered as blocked that is now clear becomes unknown again so it will be explored
+void sense_adjacent_tiles(Robot *robot, Arena *arena)
 {
-    // get width and height for ease
-    int width = robot->arenaWidth;
-    int height = robot->arenaHeight;
-
-    // allocate memory for row pointers
-    robot->memory = calloc(height, sizeof(RobotTile *));
-    if (robot->memory == NULL) {
-        fprintf(stderr, "Calloc returned null for row pointers in allocate_robots_memory\n");
-        exit(EXIT_FAILURE);
+    for (Direction dir = NORTH; dir <= WEST; dir++) {
+        Coord coord = get_coord_in_direction(robot, dir);
+        if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) continue;
+
+        int obstacle = get_tile(&arena->arenaGrid, coord.x, coord.y) == T_OBSTACLE;
+        RobotTile remembered = get_tile(&robot->memory, coord.x, coord.y);
+        if (obstacle && remembered != R_BLOCKED) {
+            if (remembered == R_UNKNOWN) robot->knownTiles++;
+            set_tile(&robot->memory, coord.x, coord.y, R_BLOCKED);
+            if (robot->planner != NULL) planner_tile_blocked(robot->planner, coord.x, coord.y);
+        }
+        else if (!obstacle && remembered == R_BLOCKED) {
+            robot->knownTiles--;
+            set_tile(&robot->memory, coord.x, coord.y, R_UNKNOWN);
+            if (robot->planner != NULL) planner_tile_opened(robot->planner, coord.x, coord.y);
+        }
     }
+}
 
-    // allocate each row
-    for (int i = 0; i < height; i++) {
-        robot->memory[i] = calloc(width, sizeof(RobotTile));
-        if (robot->memory[i] == NULL) {
-            fprintf(stderr, "Calloc returned null for a row of robots memory in allocate_robots_memory\n");
-            // free already allocated memory
-            for (int j = 0; j < i; j++) {
-                free(robot->memory[j]);
-            }
-            free(robot->memory);
-            exit(EXIT_FAILURE);
+// this function makes every tile the robot remembers as blocked unknown again, for when it cannot reach anything unknown but obstacles have changed somewhere it cannot see
+void forget_blocked_tiles(Robot *robot)
+{
+    for (int y = 0; y < robot->arenaHeight; y++) {
+        for (int x = 0; x < robot->arenaWidth; x++) {
+            if (get_tile(&robot->memory, x, y) != R_BLOCKED) continue;
+            robot->knownTiles--;
+            set_tile(&robot->memory, x, y, R_UNKNOWN);
+            if (robot->planner != NULL) planner_tile_opened(robot->planner, x, y);
         }
     }
 }
 
-// this function creates a robot struct; pre-requisite: arena dimensions already set; caller has responsibility to free
-Robot* create_robot(Arena *arena)
+// this function forgets that the robot has been on its current tile, so the search comes back to it later
+void forget_current_tile(Robot *robot)
+{
+    if (get_tile(&robot->memory, robot->x, robot->y) == R_UNKNOWN) return;
+    robot->knownTiles--;
+    set_tile(&robot->memory, robot->x, robot->y, R_UNKNOWN);
+}
+
+// functions to deal with robot struct:
+
+// this function sets up the robot's memory and visit counts in the same layout as the arena's grid, returning S_ERR_ALLOC on failure
+static Status allocate_robots_memory(Pool *pool, Robot *robot, GridLayout layout)
+{
+    // every tile starts as R_UNKNOWN with no visits
+    if (create_tile_grid(&robot->memory, pool, robot->arenaWidth, robot->arenaHeight, 1, layout) != S_OK) return S_ERR_ALLOC;
+    if (create_tile_grid(&robot->visitCounts, pool, robot->arenaWidth, robot->arenaHeight, sizeof(uint16_t), layout) != S_OK) return S_ERR_ALLOC;
+    return S_OK;
+}
+
+// this function returns the capacity of the robot's path stack: every tile can be pushed when first visited, plus the run to the spiral start (not marked visited) and one tile at the end of each route
+static unsigned int path_capacity(int width, int height)
+{
+    return 2*width*height + width + height + 8;
+}
+
+// this function returns how many bytes of pool create_robot needs for an arena of the given size and grid layout; a sparse robot's path stack grows outside the pool instead
+size_t robot_pool_size(int width, int height, GridLayout layout)
+{
+    return pool_aligned_size(sizeof(Robot))
+        + tile_grid_pool_size(width, height, 1, layout)
+        + tile_grid_pool_size(width, height, sizeof(uint16_t), layout)
+        + (layout == G_SPARSE ? stack_pool_size(0) : stack_pool_size(path_capacity(width, height)));
+}
+
+// this function creates a robot struct and its path stack from the pool, storing its memory in the same layout as the arena's grid; pre-requisite: arena dimensions already set; returns NULL if the pool does not have space; freed when the pool is reset, after release_robot for a sparse arena
+Robot* create_robot(Pool *pool, Arena *arena)
 {
     // allocate memory
-    Robot* robot = malloc(sizeof(Robot));
+    Robot* robot = pool_alloc(pool, sizeof(Robot));
     if (robot == NULL) {
-        fprintf(stderr, "Malloc returned null in create_robot\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Pool has no space in create_robot\n");
+        return NULL;
     }
 
     robot->x = 0; // will be changed
     robot->y = 0; // will be changed
     robot->direction = NORTH; // will be changed
     robot->markerCount = 0;
+    robot->knownTiles = 0;
     robot->arenaWidth = arena->arenaWidth;
     robot->arenaHeight = arena->arenaHeight;
-    allocate_robots_memory(robot);
+    robot->spiralState = SP_REACH_START;
+    robot->spiralTarget = (Coord){-1, -1};
+    robot->planner = NULL;
+    robot->routeKind = RT_MARKER;
+    robot->tour = NULL;
+    robot->senseRadius = 0;
+    robot->changesSeen = 0;
+    robot->unreachableMarker = (Coord){-1, -1};
+    robot->unreachableChanges = 0;
+    robot->carryCapacity = 0;
+    robot->trips = 0;
+    robot->resumeState = SP_REACH_START;
+    robot->moveCount = 0;
+    robot->turnCount = 0;
+    robot->render = 1;
+    robot->path = NULL;
+    if (allocate_robots_memory(pool, robot, arena->arenaGrid.layout) != S_OK) {
+        return NULL;
+    }
+    // filled when the search starts; only the tiles actually visited are pushed, so a sparse arena does not set aside room for every tile
+    if (arena->arenaGrid.layout == G_SPARSE) robot->path = create_growing_stack(pool, CHUNK_SIZE*CHUNK_SIZE);
+    else robot->path = create_stack(pool, path_capacity(robot->arenaWidth, robot->arenaHeight));
+    if (robot->path == NULL) {
+        return NULL;
+    }
 
     return robot;
 }
 
-// this function frees robot memory's memory
-static void free_robots_memory(Robot *robot)
+// this function frees anything the robot allocated outside the pool (sparse memory chunks and a growing path stack); must be called before the pool is reset
+void release_robot(Robot *robot)
 {
-    for (int i = 0; i < robot->arenaHeight; i++) {
-        free(robot->memory[i]);
-    }
-    free(robot->memory);
-}
-
-// this function frees overall robot struct memory
-void free_robot(Robot *robot)
-{
-    free_robots_memory(robot);
-    free(robot);
+    release_tile_grid(&robot->memory);
+    release_tile_grid(&robot->visitCounts);
+    release_stack(robot->path);
 }
 
 // functions to deal with the path using stack implementation from utils.h
 
-// this function creates the stack and pushes the current position (start to it)
-void setup_path_stack(Robot *robot)
+// this function empties the path stack and pushes the current position (start to it)
+Status setup_path_stack(Robot *robot)
 {
-    robot->path = create_stack(robot->arenaWidth*robot->arenaHeight+8); // capacity assumes travelling over each tile
-    push(robot->path, (Coord){robot->x, robot->y});
+    clear_stack(robot->path);
+    return push(robot->path, (Coord){robot->x, robot->y});
 }
 
 // this function pushes the current robot position to the stack
-void push_pos_to_path(Robot *robot)
+Status push_pos_to_path(Robot *robot)
 {
-    push(robot->path, (Coord){robot->x, robot->y});
+    return push(robot->path, (Coord){robot->x, robot->y});
 }
 
-// this function returns the Coord at the top of the stack
+// this function returns the Coord at the top of the stack, or {-1, -1} if the robot has backtracked to the start and could not find an unknown tile
 Coord backtrack_path_tile(Robot *robot)
 {
     pop(robot->path);
-    Coord result = peek(robot->path);
-    if (result.x == -1 && result.y == -1) { // backtracked to the start and could not find tile
-        fprintf(stderr, "One or more markers are unreachable. Program will stop.\n");
-        exit(EXIT_FAILURE);
-    }
-    return result;
+    if (stack_size(robot->path) == 0) return (Coord){-1, -1}; // an expected end to the search, so not worth peek's warning
+    return peek(robot->path);
 }
 
 // functions for placing the robot at the start of the program
 
-// this function randomly assigns the robot to a position in the arena
-static void place_robot_random(Robot *robot, Arena *arena)
+// this function finds the first empty tile away from the edge, returning 0 if there is none
+static int find_empty_inner_tile(Arena *arena, int *x, int *y)
 {
-    // generate x and y until empty tile    
+    for (*y = 1; *y < arena->arenaHeight-1; (*y)++) {
+        for (*x = 1; *x < arena->arenaWidth-1; (*x)++) {
+            if (get_tile(&arena->arenaGrid, *x, *y) == T_EMPTY) return 1;
+        }
+    }
+    return 0;
+}
+
+// this function randomly assigns the robot to a position in the arena, returning S_ERR_CONFIG if every tile away from the edge is taken
+static Status place_robot_random(Robot *robot, Arena *arena)
+{
+    // generate x and y until empty tile, giving up on guessing after a while in case obstacles have filled the arena away from the edge
     int x, y;
+    int attempts = 0;
     do {
         // add 1 and -2 is used to not place robot at edge
-        x = 1 + random_coord(robot->arenaWidth-2);
-        y = 1 + random_coord(robot->arenaHeight-2);
-    } while (arena->arenaGrid[y][x] != T_EMPTY);
+        x = 1 + random_coord(&arena->rng, robot->arenaWidth-2);
+        y = 1 + random_coord(&arena->rng, robot->arenaHeight-2);
+        attempts++;
+    } while (get_tile(&arena->arenaGrid, x, y) != T_EMPTY && attempts < 1000);
+    if (get_tile(&arena->arenaGrid, x, y) != T_EMPTY && !find_empty_inner_tile(arena, &x, &y)) {
+        fprintf(stderr, "No empty tile away from the edge to place the robot on\n");
+        return S_ERR_CONFIG;
+    }
 
     // assign this as robot start on arena 
-    arena->arenaGrid[y][x] = T_R_START;
+    set_tile(&arena->arenaGrid, x, y, T_R_START);
+    arena->emptyTiles--;
     
     // assign values to robot
     robot->x = x;
     robot->y = y;
-    robot->direction = random_direction();
-
-    setup_path_stack(robot);
+    robot->direction = random_direction(&arena->rng);
+    return S_OK;
 }
 
 // this function places the robot with a specific 
-static void place_robot_specific(Robot *robot, Arena *arena, Coord coord, Direction direction)
+static Status place_robot_specific(Robot *robot, Arena *arena, Coord coord, Direction direction)
 {
     // if the entered position is taken, place the robot randomly
-    if (arena->arenaGrid[coord.y][coord.x] != T_EMPTY) {
-        place_robot_random(robot, arena);
-        return;
+    if (get_tile(&arena->arenaGrid, coord.x, coord.y) != T_EMPTY) {
+        return place_robot_random(robot, arena);
     }
 
     // assign x, y as start on arena
-    arena->arenaGrid[coord.y][coord.x] = T_R_START;
+    set_tile(&arena->arenaGrid, coord.x, coord.y, T_R_START);
+    arena->emptyTiles--;
 
     // assign values to robot
     robot->x = coord.x;
     robot->y = coord.y;
     robot->direction = direction;
+    return S_OK;
 }
 
-// this function parses an entered direction
-static Direction parse_direction(const char *input) {
+// this function parses an entered direction, returning -1 if it is not valid
+Direction parse_direction(const char *input) {
     // make a lowercase copy for case-insensitive comparison
     char dir[16];
     int i;
@@ -356,34 +460,42 @@ static Direction parse_direction(const char *input) {
     return -1;
 }
 
-// this function deals with command line inputs and either places robot in given position or randomly places it
-void place_robot(int argc, char *argv[], Robot *robot, Arena *arena)
+// this function reads a start position and direction from the command line, leaving {-1, -1} and -1 if they were not given
+void determine_robot_start(int argc, char *argv[], Coord *start, Direction *direction)
 {
-    // specific position
-    if (argc == 6) {
-        Coord coord;
-        coord.x = atoi(argv[3]);
-        coord.y = atoi(argv[4]);
-        Direction direction = parse_direction(argv[5]); // returns -1 if invalid input, dealt with below
-
-        // check out of bounds - if so, give random position and direction
-        if (!check_coord_in_bounds(coord, robot->arenaWidth, robot->arenaHeight)) {
-            fprintf(stderr, "Error: x and y must be between 0 and %d / %d. Random position and direction generated.\n", robot->arenaWidth - 1, robot->arenaHeight - 1);
-            place_robot_random(robot, arena);
-            return;
-        }
+    start->x = -1;
+    start->y = -1;
+    *direction = -1;
 
-        // check invalid direction - if so, give random direction, but we know x, y is in range
-        if (direction == -1) {
+    if (argc == 6) {
+        start->x = atoi(argv[3]);
+        start->y = atoi(argv[4]);
+        *direction = parse_direction(argv[5]);
+        if (*direction == -1) { // position is kept but direction is randomised in place_robot
             fprintf(stderr, "Error: direction must be north, east, south, west. Random direction generated.\n");
-            place_robot_specific(robot, arena, coord, random_direction());
-            return;
         }
+    }
+}
+
+// this function either places robot in given position or randomly places it; pass start {-1, -1} for a random position and direction -1 for a random direction
+Status place_robot(Robot *robot, Arena *arena, Coord start, Direction direction)
+{
+    // no position given
+    if (start.x == -1 && start.y == -1) {
+        return place_robot_random(robot, arena);
+    }
+
+    // check out of bounds - if so, give random position and direction
+    if (!check_coord_in_bounds(start, robot->arenaWidth, robot->arenaHeight)) {
+        fprintf(stderr, "Error: x and y must be between 0 and %d / %d. Random position and direction generated.\n", robot->arenaWidth - 1, robot->arenaHeight - 1);
+        return place_robot_random(robot, arena);
+    }
 
-        // valid x, y, direction
-        place_robot_specific(robot, arena, coord, direction);
-        return;
+    // check invalid direction - if so, give random direction, but we know x, y is in range
+    if (direction < NORTH || direction > WEST) {
+        direction = random_direction(&arena->rng);
     }
 
-    place_robot_random(robot, arena);
+    // valid x, y, direction
+    return place_robot_specific(robot, arena, start, direction);
 }
\ No newline at end of file
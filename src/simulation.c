@@ -0,0 +1,337 @@
+// This file wraps the arena, robot and spiral algorithm into a simulation that can be created, stepped and freed without exiting the program
+
+#include "../include/arena.h"
+#include "../include/config.h"
+#include "../include/drawing.h"
+#include "../include/dstar.h"
+#include "../include/hierarchy.h"
+#include "../include/jump_grid.h"
+#include "../include/pathfind.h"
+#include "../include/pool.h"
+#include "../include/profile.h"
+#include "../include/robot.h"
+#include "../include/simulation.h"
+#include "../include/snapshot.h"
+#include "../include/spiral.h"
+#include "../include/tour.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+// this function fills a config with the default values from config.c, a random start and a fixed seed
+void default_sim_config(SimConfig *config)
+{
+    config->arenaWidth = DEFAULT_ARENA_WIDTH;
+    config->arenaHeight = DEFAULT_ARENA_HEIGHT;
+    config->obstacleFormation = obstacleFormation;
+    config->numObstacles = numObstacles;
+    config->markerFormation = markerFormation;
+    config->numMarkers = numMarkers;
+    config->seed = 1;
+    config->start = (Coord){-1, -1};
+    config->startDirection = -1;
+    config->senseRadius = senseRadius;
+    config->knownArena = knownArena;
+    config->carryCapacity = carryCapacity;
+    config->depot = deliveryDepot;
+    config->hierarchicalRoutes = hierarchicalRoutes;
+    config->jumpPointRoutes = jumpPointRoutes;
+    config->incrementalRoutes = incrementalRoutes;
+    config->obstacleEvents = NULL;
+    config->numObstacleEvents = 0;
+    config->gridLayout = gridLayout;
+    config->turnAwareRoutes = turnAwareRoutes;
+    config->routeMoveCost = routeMoveCost;
+    config->routeTurnCost = routeTurnCost;
+    config->render = 0;
+    default_draw_config(&config->draw);
+}
+
+// this function checks the obstacle events in the config against the arena and gives them to it
+static Status attach_obstacle_events(Simulation *sim)
+{
+    SimConfig *config = &sim->config;
+    Status status = check_obstacle_events(sim->arena, config->obstacleEvents, config->numObstacleEvents);
+    if (status != S_OK) return status;
+    sim->arena->events = config->obstacleEvents;
+    sim->arena->numEvents = config->numObstacleEvents;
+    return S_OK;
+}
+
+// this function generates the arena and places the robot; pre-requisite: arena and robot created
+static Status setup_simulation(Simulation *sim)
+{
+    SimConfig *config = &sim->config;
+
+    Status status = check_obstacle_marker_values(sim->arena, config->obstacleFormation, config->numObstacles, config->markerFormation, config->numMarkers);
+    if (status != S_OK) return status;
+    status = attach_obstacle_events(sim);
+    if (status != S_OK) return status;
+
+    long long start = profile_start();
+    status = generate_obstacles(sim->arena, config->numObstacles, config->obstacleFormation); // have to generate obstacles first
+    profile_stop(PF_GENERATE_OBSTACLES, start);
+    if (status != S_OK) return status;
+
+    start = profile_start();
+    status = place_robot(sim->robot, sim->arena, config->start, config->startDirection);
+    profile_stop(PF_PLACE_ROBOT, start);
+    if (status != S_OK) return status;
+    if (config->carryCapacity > 0) place_depot(sim->arena, config->depot, (Coord){sim->robot->x, sim->robot->y}); // before the markers so none is put on it
+
+    start = profile_start();
+    status = generate_markers(sim->arena, config->numMarkers, config->markerFormation);
+    profile_stop(PF_GENERATE_MARKERS, start);
+    if (status != S_OK) return status;
+
+    if (config->knownArena) {
+        learn_arena_obstacles(sim->robot, sim->arena);
+        status = plan_marker_tour(sim->robot->tour, sim->arena, (Coord){sim->robot->x, sim->robot->y});
+        if (status != S_OK) return status;
+    }
+    return S_OK;
+}
+
+// this function checks that the arena in a config is large enough and the route costs and drawing settings make sense
+static Status check_sim_config(const SimConfig *config)
+{
+    if (config->arenaWidth < MIN_ARENA_WIDTH || config->arenaHeight < MIN_ARENA_HEIGHT) {
+        fprintf(stderr, "Arena must be at least %d x %d, given %d x %d\n", MIN_ARENA_WIDTH, MIN_ARENA_HEIGHT, config->arenaWidth, config->arenaHeight);
+        return S_ERR_CONFIG;
+    }
+    if (config->turnAwareRoutes && (config->routeMoveCost < 1 || config->routeTurnCost < 0)) {
+        fprintf(stderr, "Route move cost must be at least 1 and turn cost at least 0, given %d and %d\n", config->routeMoveCost, config->routeTurnCost);
+        return S_ERR_CONFIG;
+    }
+    if (config->carryCapacity < 0 || (config->carryCapacity > 0 && (config->depot.x != -1 || config->depot.y != -1) && !check_coord_in_bounds(config->depot, config->arenaWidth, config->arenaHeight))) {
+        fprintf(stderr, "Carry capacity must be at least 0 and the depot in the arena, given %d and (%d, %d)\n", config->carryCapacity, config->depot.x, config->depot.y);
+        return S_ERR_CONFIG;
+    }
+    if (config->render && (config->draw.tileSize <= 2*OBJECT_PADDING || config->draw.frameSkip < 1)) {
+        fprintf(stderr, "Tile size must be more than %d and frame skip at least 1, given %d and %d\n", 2*OBJECT_PADDING, config->draw.tileSize, config->draw.frameSkip);
+        return S_ERR_CONFIG;
+    }
+    return S_OK;
+}
+
+// this function checks if the robot needs a planner for routes rather than only following the spiral
+static int needs_planner(const SimConfig *config)
+{
+    return config->senseRadius > 0 || config->knownArena || config->turnAwareRoutes || config->numObstacleEvents > 0 || config->carryCapacity > 0; // with changing obstacles the robot has to route around them, and with a carrying capacity back to the depot
+}
+
+// this function returns how many bytes of pool a simulation with the given config needs
+static size_t sim_pool_size(const SimConfig *config)
+{
+    size_t size = arena_pool_size(config->arenaWidth, config->arenaHeight, config->numMarkers, config->gridLayout) + robot_pool_size(config->arenaWidth, config->arenaHeight, config->gridLayout);
+    if (needs_planner(config)) size += planner_pool_size(config->arenaWidth, config->arenaHeight);
+    if (needs_planner(config) && config->hierarchicalRoutes) size += hierarchy_pool_size(config->arenaWidth, config->arenaHeight);
+    if (needs_planner(config) && config->jumpPointRoutes) size += jump_grid_pool_size(config->arenaWidth, config->arenaHeight);
+    if (needs_planner(config) && config->incrementalRoutes) size += dstar_pool_size(config->arenaWidth, config->arenaHeight);
+    if (config->knownArena) size += tour_pool_size(config->arenaWidth, config->arenaHeight, config->numMarkers);
+    return size;
+}
+
+// this function frees what the arena and robot allocated outside the pool, before the pool is reset or freed
+static void release_simulation(Simulation *sim)
+{
+    if (sim->robot != NULL) release_robot(sim->robot);
+    if (sim->arena != NULL) release_arena(sim->arena);
+    sim->robot = NULL;
+    sim->arena = NULL;
+}
+
+// this function carves the arena and robot, with the planner and tour they need, out of the (reset) pool, leaving the arena empty and the robot unplaced
+static Status allocate_simulation(Simulation *sim)
+{
+    SimConfig *config = &sim->config;
+    sim->status = S_OK;
+
+    // create arena and robot
+    release_simulation(sim);
+    pool_reset(sim->pool);
+    sim->arena = create_arena(sim->pool, config->arenaWidth, config->arenaHeight, config->numMarkers, config->seed, config->gridLayout);
+    if (sim->arena != NULL) sim->robot = create_robot(sim->pool, sim->arena);
+    if (sim->robot == NULL) return S_ERR_ALLOC;
+    sim->robot->render = config->render;
+    sim->robot->senseRadius = config->senseRadius;
+    sim->robot->carryCapacity = config->carryCapacity;
+    if (needs_planner(config)) {
+        sim->robot->planner = create_planner(sim->pool, config->arenaWidth, config->arenaHeight);
+        if (sim->robot->planner == NULL) return S_ERR_ALLOC;
+        sim->robot->planner->turnAware = config->turnAwareRoutes;
+        sim->robot->planner->moveCost = config->routeMoveCost;
+        sim->robot->planner->turnCost = config->routeTurnCost;
+        if (config->hierarchicalRoutes) {
+            sim->robot->planner->hierarchy = create_hierarchy(sim->pool, config->arenaWidth, config->arenaHeight);
+            if (sim->robot->planner->hierarchy == NULL) return S_ERR_ALLOC;
+        }
+        if (config->jumpPointRoutes) {
+            sim->robot->planner->jumpGrid = create_jump_grid(sim->pool, config->arenaWidth, config->arenaHeight);
+            if (sim->robot->planner->jumpGrid == NULL) return S_ERR_ALLOC;
+        }
+        if (config->incrementalRoutes) {
+            sim->robot->planner->dstar = create_dstar(sim->pool, config->arenaWidth, config->arenaHeight);
+            if (sim->robot->planner->dstar == NULL) return S_ERR_ALLOC;
+        }
+    }
+    if (config->knownArena) {
+        sim->robot->tour = create_tour(sim->pool, config->arenaWidth, config->arenaHeight, config->numMarkers);
+        if (sim->robot->tour == NULL) return S_ERR_ALLOC;
+    }
+    return S_OK;
+}
+
+// this function draws the background if rendering, so the robot's actions can be drawn over it
+static void start_rendering(Simulation *sim)
+{
+    SimConfig *config = &sim->config;
+    if (!config->render) return;
+
+    // render background
+    set_draw_config(&config->draw);
+    long long start = profile_start();
+    draw_background(sim->arena);
+    profile_stop(PF_DRAW_BACKGROUND, start);
+    begin_foreground();
+}
+
+// this function carves the arena and robot out of the (reset) pool, generates the arena and places the robot, then draws the background if rendering
+static Status build_simulation(Simulation *sim)
+{
+    Status status = allocate_simulation(sim);
+    if (status != S_OK) return status;
+    status = setup_simulation(sim);
+    if (status != S_OK) return status;
+    if (sim->robot->memory.failed || sim->robot->visitCounts.failed || sim->arena->arenaGrid.failed) return S_ERR_ALLOC;
+
+    start_rendering(sim);
+    return S_OK;
+}
+
+// this function checks a config and allocates a simulation with a pool big enough for it, but nothing in the pool yet; caller has responsibility to free with sim_destroy
+static Status new_simulation(const SimConfig *config, Simulation **out)
+{
+    *out = NULL;
+    Status status = check_sim_config(config);
+    if (status != S_OK) return status;
+
+    Simulation *sim = malloc(sizeof(Simulation));
+    if (sim == NULL) {
+        fprintf(stderr, "Malloc returned null in new_simulation\n");
+        return S_ERR_ALLOC;
+    }
+    sim->config = *config;
+    sim->arena = NULL;
+    sim->robot = NULL;
+    sim->ownedEvents = NULL;
+    sim->pool = create_pool(sim_pool_size(config));
+    if (sim->pool == NULL) {
+        free(sim);
+        return S_ERR_ALLOC;
+    }
+    *out = sim;
+    return S_OK;
+}
+
+// this function creates a simulation from a config, generating its arena and placing its robot; on failure nothing is left allocated; caller has responsibility to free with sim_destroy
+Status sim_create(const SimConfig *config, Simulation **out)
+{
+    Simulation *sim;
+    Status status = new_simulation(config, &sim);
+    if (status != S_OK) return status;
+
+    status = build_simulation(sim);
+    if (status != S_OK) {
+        sim_destroy(sim);
+        return status;
+    }
+
+    *out = sim;
+    return S_OK;
+}
+
+// this function creates a simulation from a snapshot (see snapshot.c), which carries on exactly as the simulation the snapshot was taken of would have; draw is how to render it, or NULL to run headless; the same snapshot can be restored any number of times to fork runs from it; caller has responsibility to free with sim_destroy
+Status sim_restore(const struct Snapshot *snapshot, const DrawConfig *draw, Simulation **out)
+{
+    *out = NULL;
+    SimConfig config;
+    ObstacleEvent *events;
+    Status status = read_snapshot_config(snapshot, &config, &events);
+    if (status != S_OK) return status;
+    config.render = draw != NULL;
+    if (draw != NULL) config.draw = *draw;
+
+    Simulation *sim;
+    status = new_simulation(&config, &sim);
+    if (status != S_OK) {
+        free(events);
+        return status;
+    }
+    sim->ownedEvents = events;
+
+    status = allocate_simulation(sim);
+    if (status == S_OK) status = attach_obstacle_events(sim);
+    if (status == S_OK) status = restore_snapshot_state(sim, snapshot);
+    if (status != S_OK) {
+        sim_destroy(sim);
+        return status;
+    }
+
+    start_rendering(sim);
+    *out = sim;
+    return S_OK;
+}
+
+// this function starts a simulation again with a new config, reusing its pool so no memory is allocated unless the new arena is bigger than any before it; on failure the simulation must still be freed with sim_destroy
+Status sim_reset(Simulation *sim, const SimConfig *config)
+{
+    Status status = check_sim_config(config);
+    if (status != S_OK) return status;
+
+    size_t needed = sim_pool_size(config);
+    if (needed > sim->pool->capacity) { // grow, keeping the larger pool for later runs
+        Pool *pool = create_pool(needed);
+        if (pool == NULL) return S_ERR_ALLOC;
+        release_simulation(sim);
+        free_pool(sim->pool);
+        sim->pool = pool;
+    }
+
+    sim->config = *config;
+    status = build_simulation(sim);
+    if (status != S_OK) sim->status = status;
+    return status;
+}
+
+// this function advances the simulation by one robot action (a move or a turn); returns S_OK while markers remain, S_DONE once all are found (and delivered, with a carrying capacity), or an error
+Status sim_step(Simulation *sim)
+{
+    if (sim->status != S_OK) return sim->status; // already finished or failed
+
+    sim->status = spiral_step_once(sim->robot, sim->arena);
+    if (sim->robot->memory.failed || sim->robot->visitCounts.failed || sim->arena->arenaGrid.failed) sim->status = S_ERR_ALLOC; // a sparse chunk could not be allocated
+    return sim->status;
+}
+
+// this function runs the simulation until all markers are found; returns S_OK if they were all found, otherwise the error that stopped it
+Status sim_run(Simulation *sim)
+{
+    Status status;
+    do {
+        status = sim_step(sim);
+    } while (status == S_OK);
+
+    return status == S_DONE ? S_OK : status;
+}
+
+// this function frees a simulation along with the pool holding its arena and robot; accepts NULL
+void sim_destroy(Simulation *sim)
+{
+    if (sim == NULL) return;
+    release_simulation(sim);
+    free_pool(sim->pool);
+    free(sim->ownedEvents);
+    free(sim);
+}
@@ -0,0 +1,779 @@
+// This file packs the whole state of a simulation (its config and obstacle events, the arena and its random generator, the robot with its memory, visit counts and path, and the planner's current route and incremental search) into a compact binary snapshot, and restores one into a simulation created empty from the same config, so a run can be paused, resumed or forked part way through and carries on exactly as it would have
+
+#include "../include/arena.h"
+#include "../include/dstar.h"
+#include "../include/jump_grid.h"
+#include "../include/pathfind.h"
+#include "../include/robot.h"
+#include "../include/simulation.h"
+#include "../include/snapshot.h"
+#include "../include/tile_grid.h"
+#include "../include/tour.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// every integer is stored as a varint (7 bits a byte, lowest first), with signed ones zigzag encoded first so small negative numbers stay short, so the format is the same on any machine
+static const unsigned char SNAPSHOT_MAGIC[4] = {'S', 'P', 'S', 'N'};
+#define CHECKSUM_SIZE 8 // bytes of the checksum at the end of a snapshot
+
+// a snapshot being written, which stops writing once its buffer cannot grow
+typedef struct {
+    Snapshot *out;
+    int failed;
+} SnapshotWriter;
+
+// a snapshot being read, which reads zeros once it runs off the end or finds a value out of range
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    int failed;
+} SnapshotReader;
+
+// functions for writing:
+
+// this function adds a byte to the snapshot, doubling its buffer when full
+static void put_byte(SnapshotWriter *writer, unsigned char byte)
+{
+    Snapshot *snapshot = writer->out;
+    if (writer->failed) return;
+    if (snapshot->size == snapshot->capacity) {
+        size_t capacity = snapshot->capacity == 0 ? 4096 : 2*snapshot->capacity;
+        unsigned char *grown = realloc(snapshot->data, capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "Realloc returned null in put_byte\n");
+            writer->failed = 1;
+            return;
+        }
+        snapshot->data = grown;
+        snapshot->capacity = capacity;
+    }
+    snapshot->data[snapshot->size++] = byte;
+}
+
+// this function adds an unsigned integer as a varint
+static void put_unsigned(SnapshotWriter *writer, unsigned long long value)
+{
+    while (value >= 0x80) {
+        put_byte(writer, (value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    put_byte(writer, value);
+}
+
+// this function adds a signed integer as a zigzag varint
+static void put_signed(SnapshotWriter *writer, long long value)
+{
+    put_unsigned(writer, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+// this function adds a coordinate
+static void put_coord(SnapshotWriter *writer, Coord coord)
+{
+    put_signed(writer, coord.x);
+    put_signed(writer, coord.y);
+}
+
+// this function checks if every tile of the 64 by 64 chunk starting at (left, top) is 0, without scanning a sparse chunk that was never allocated
+static int chunk_is_zero(const TileGrid *grid, int left, int top)
+{
+    if (is_chunk_empty(grid, left, top)) return 1;
+    int right = min(left + CHUNK_SIZE, grid->width);
+    int bottom = min(top + CHUNK_SIZE, grid->height);
+    for (int y = top; y < bottom; y++) {
+        for (int x = left; x < right; x++) {
+            if (get_tile(grid, x, y) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+// this function adds a grid chunk by chunk, each as a 0 if all its tiles are 0 and otherwise a 1 followed by its tiles packed four to a byte, with 3 standing for 3 or more, and then the amount over 3 of each of those tiles in order
+static void put_grid(SnapshotWriter *writer, const TileGrid *grid)
+{
+    for (int top = 0; top < grid->height; top += CHUNK_SIZE) {
+        for (int left = 0; left < grid->width; left += CHUNK_SIZE) {
+            if (chunk_is_zero(grid, left, top)) {
+                put_byte(writer, 0);
+                continue;
+            }
+            put_byte(writer, 1);
+
+            int right = min(left + CHUNK_SIZE, grid->width);
+            int bottom = min(top + CHUNK_SIZE, grid->height);
+            unsigned int packed = 0;
+            int numPacked = 0;
+            for (int y = top; y < bottom; y++) {
+                for (int x = left; x < right; x++) {
+                    packed |= min(get_tile(grid, x, y), 3) << (2*numPacked);
+                    if (++numPacked == 4) {
+                        put_byte(writer, packed);
+                        packed = 0;
+                        numPacked = 0;
+                    }
+                }
+            }
+            if (numPacked > 0) put_byte(writer, packed);
+
+            for (int y = top; y < bottom; y++) {
+                for (int x = left; x < right; x++) {
+                    unsigned int value = get_tile(grid, x, y);
+                    if (value >= 3) put_unsigned(writer, value - 3);
+                }
+            }
+        }
+    }
+}
+
+// this function adds the robot's path; each tile is next to the one before it apart from where a route was followed, so it is written as the direction of each step packed four to a byte, then the number of tiles that are not next to the one before them and the index (as the gap since the last) and position of each
+static void put_path(SnapshotWriter *writer, const Stack *path)
+{
+    int size = path->top + 1;
+    put_signed(writer, size);
+    unsigned int packed = 0;
+    int numPacked = 0;
+    int numJumps = 0;
+    for (int i = 0; i < size; i++) {
+        Coord tile = path->array[i];
+        Direction dir = NORTH; // anything for a jump, which is written afterwards
+        if (i > 0) {
+            Coord previous = path->array[i - 1];
+            int dx = tile.x - previous.x;
+            int dy = tile.y - previous.y;
+            if (abs(dx) + abs(dy) != 1) numJumps++;
+            else dir = dy == -1 ? NORTH : dx == 1 ? EAST : dy == 1 ? SOUTH : WEST;
+        }
+        else {
+            numJumps++;
+        }
+        packed |= dir << (2*numPacked);
+        if (++numPacked == 4) {
+            put_byte(writer, packed);
+            packed = 0;
+            numPacked = 0;
+        }
+    }
+    if (numPacked > 0) put_byte(writer, packed);
+
+    put_signed(writer, numJumps);
+    int lastJump = -1;
+    for (int i = 0; i < size; i++) {
+        Coord tile = path->array[i];
+        if (i > 0 && abs(tile.x - path->array[i - 1].x) + abs(tile.y - path->array[i - 1].y) == 1) continue;
+        put_signed(writer, i - lastJump - 1);
+        put_coord(writer, tile);
+        lastJump = i;
+    }
+}
+
+// functions for reading:
+
+// this function reads an unsigned varint, or 0 if the snapshot ends first
+static unsigned long long get_unsigned(SnapshotReader *reader)
+{
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->pos >= reader->size) break;
+        unsigned char byte = reader->data[reader->pos++];
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->failed = 1;
+    return 0;
+}
+
+// this function reads a zigzag varint
+static long long get_signed(SnapshotReader *reader)
+{
+    unsigned long long value = get_unsigned(reader);
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+// this function reads an integer that must be between low and high inclusive, or low if it is not
+static int get_int(SnapshotReader *reader, int low, int high)
+{
+    long long value = get_signed(reader);
+    if (value < low || value > high) {
+        reader->failed = 1;
+        return low;
+    }
+    return (int)value;
+}
+
+// this function reads a coordinate that must be inside a width by height arena, or also {-1, -1} if none is allowed
+static Coord get_coord(SnapshotReader *reader, int width, int height, int none)
+{
+    Coord coord;
+    coord.x = get_int(reader, -1, width - 1);
+    coord.y = get_int(reader, -1, height - 1);
+    if (none && coord.x == -1 && coord.y == -1) return coord;
+    if (coord.x < 0 || coord.y < 0) {
+        reader->failed = 1;
+        return (Coord){0, 0};
+    }
+    return coord;
+}
+
+// this function returns a 2 bit value from bytes packed four to a byte starting at data
+static unsigned int packed_value(const unsigned char *data, int i)
+{
+    return (data[i >> 2] >> (2*(i & 3))) & 3;
+}
+
+// this function reads a grid written by put_grid into one that is all 0
+static void get_grid(SnapshotReader *reader, TileGrid *grid)
+{
+    for (int top = 0; top < grid->height && !reader->failed; top += CHUNK_SIZE) {
+        for (int left = 0; left < grid->width && !reader->failed; left += CHUNK_SIZE) {
+            unsigned long long present = get_unsigned(reader);
+            if (present == 0) continue;
+            if (present != 1) {
+                reader->failed = 1;
+                return;
+            }
+
+            // the packed tiles come first and the amounts over 3 after them
+            int right = min(left + CHUNK_SIZE, grid->width);
+            int bottom = min(top + CHUNK_SIZE, grid->height);
+            int chunkWidth = right - left;
+            size_t packedBytes = ((size_t)chunkWidth * (bottom - top) + 3) / 4;
+            if (packedBytes > reader->size - reader->pos) {
+                reader->failed = 1;
+                return;
+            }
+            const unsigned char *packed = reader->data + reader->pos;
+            reader->pos += packedBytes;
+            for (int y = top; y < bottom; y++) {
+                for (int x = left; x < right; x++) {
+                    unsigned int value = packed_value(packed, (y - top)*chunkWidth + (x - left));
+                    if (value == 3) {
+                        unsigned long long over = get_unsigned(reader);
+                        if (over > UINT16_MAX - 3) reader->failed = 1;
+                        if (reader->failed) return;
+                        value += over;
+                    }
+                    if (value != 0) set_tile(grid, x, y, value);
+                }
+            }
+        }
+    }
+}
+
+// this function reads a path written by put_path onto an empty stack
+static Status get_path(SnapshotReader *reader, Stack *path, int width, int height)
+{
+    int size = get_int(reader, 0, INT32_MAX);
+    size_t packedBytes = ((size_t)size + 3) / 4;
+    if (reader->failed || packedBytes > reader->size - reader->pos) {
+        reader->failed = 1;
+        return S_OK;
+    }
+    const unsigned char *packed = reader->data + reader->pos;
+    reader->pos += packedBytes;
+
+    int numJumps = get_int(reader, 0, size);
+    int nextJump = -1;
+    int jumpsRead = 0;
+    Coord tile = {0, 0};
+    for (int i = 0; i < size && !reader->failed; i++) {
+        if (i > nextJump && jumpsRead < numJumps) { // the index of the next jump is read once the one before has been passed
+            nextJump = i + get_int(reader, 0, size - i - 1);
+            jumpsRead++;
+        }
+        if (i == nextJump) {
+            tile = get_coord(reader, width, height, 0);
+        }
+        else {
+            Direction dir = packed_value(packed, i);
+            tile.x += (dir == EAST) - (dir == WEST);
+            tile.y += (dir == SOUTH) - (dir == NORTH);
+        }
+        if (i == 0 && nextJump != 0) reader->failed = 1; // the first tile is always written out in full
+        if (!check_coord_in_bounds(tile, width, height)) reader->failed = 1;
+        if (reader->failed) break;
+        Status status = push(path, tile);
+        if (status != S_OK) return status;
+    }
+    if (jumpsRead != numJumps) reader->failed = 1;
+    return S_OK;
+}
+
+// functions for each part of the simulation:
+
+// this function writes the settings a simulation was created with, apart from drawing, which is chosen again when restoring
+static void put_config(SnapshotWriter *writer, const SimConfig *config)
+{
+    put_signed(writer, config->arenaWidth);
+    put_signed(writer, config->arenaHeight);
+    put_signed(writer, config->obstacleFormation);
+    put_signed(writer, config->numObstacles);
+    put_signed(writer, config->markerFormation);
+    put_signed(writer, config->numMarkers);
+    put_unsigned(writer, config->seed);
+    put_coord(writer, config->start);
+    put_signed(writer, (int)config->startDirection); // -1 for a random direction, but the enum may be unsigned
+    put_signed(writer, config->senseRadius);
+    put_signed(writer, config->turnAwareRoutes);
+    put_signed(writer, config->routeMoveCost);
+    put_signed(writer, config->routeTurnCost);
+    put_signed(writer, config->hierarchicalRoutes);
+    put_signed(writer, config->jumpPointRoutes);
+    put_signed(writer, config->incrementalRoutes);
+    put_signed(writer, config->knownArena);
+    put_signed(writer, config->carryCapacity);
+    put_coord(writer, config->depot);
+    put_signed(writer, config->gridLayout);
+
+    // the events are copied in so a snapshot does not depend on the file they came from
+    put_signed(writer, config->numObstacleEvents);
+    for (int i = 0; i < config->numObstacleEvents; i++) {
+        const ObstacleEvent *event = &config->obstacleEvents[i];
+        put_signed(writer, event->step);
+        put_signed(writer, event->x);
+        put_signed(writer, event->y);
+        put_signed(writer, event->blocked);
+    }
+}
+
+// this function writes the arena's tiles, markers left and delivered, random generator and how far through its events it is
+static void put_arena(SnapshotWriter *writer, const Arena *arena)
+{
+    put_unsigned(writer, arena->rng.state);
+    put_signed(writer, arena->nextEvent);
+    put_signed(writer, arena->step);
+    put_signed(writer, arena->changes);
+    put_coord(writer, arena->depot);
+    put_signed(writer, arena->numDelivered);
+    put_grid(writer, &arena->arenaGrid);
+
+    // in index order, as the order decides which marker is picked when two are equally near
+    put_signed(writer, arena->numMarker);
+    for (int i = 0; i < arena->numMarker; i++) {
+        put_coord(writer, arena->markers.positions[i]);
+    }
+}
+
+// this function writes where the robot is, what it remembers, its path and what it is part way through doing
+static void put_robot(SnapshotWriter *writer, const Robot *robot)
+{
+    put_signed(writer, robot->x);
+    put_signed(writer, robot->y);
+    put_signed(writer, robot->direction);
+    put_signed(writer, robot->markerCount);
+    put_signed(writer, robot->knownTiles);
+    put_signed(writer, robot->spiralState);
+    put_coord(writer, robot->spiralTarget);
+    put_signed(writer, robot->routeKind);
+    put_signed(writer, robot->changesSeen);
+    put_coord(writer, robot->unreachableMarker);
+    put_signed(writer, robot->unreachableChanges);
+    put_signed(writer, robot->trips);
+    put_signed(writer, robot->resumeState);
+    put_signed(writer, robot->moveCount);
+    put_signed(writer, robot->turnCount);
+    put_grid(writer, &robot->memory);
+    put_grid(writer, &robot->visitCounts);
+    put_path(writer, robot->path);
+}
+
+// this function writes the route being followed and the incremental search kept for the next one; the hierarchy and jump grid are worked out again from the robot's memory instead
+static void put_planner(SnapshotWriter *writer, const Planner *planner)
+{
+    put_signed(writer, planner->routeLength);
+    put_signed(writer, planner->routeNext);
+    put_coord(writer, planner->routeGoal);
+    for (int i = 0; i < planner->routeLength; i++) {
+        put_coord(writer, planner->route[i]);
+    }
+
+    const DStar *dstar = planner->dstar;
+    if (dstar == NULL) return;
+    put_signed(writer, dstar->active);
+    if (!dstar->active) return;
+    put_coord(writer, dstar->goal);
+    put_coord(writer, dstar->last);
+    put_signed(writer, dstar->km);
+    put_signed(writer, dstar->overflowed);
+    put_signed(writer, dstar->numChanged);
+    for (int i = 0; i < dstar->numChanged; i++) {
+        put_signed(writer, dstar->changed[i]);
+    }
+
+    // the open set in heap order, so entries with equal keys come off it in the same order
+    put_signed(writer, dstar->heapSize);
+    for (int i = 0; i < dstar->heapSize; i++) {
+        put_signed(writer, dstar->heap[i].key);
+        put_signed(writer, dstar->heap[i].tile);
+    }
+
+    // only the tiles the current search has touched, each as the gap since the last one followed by g and rhs (0 for infinite)
+    int numTiles = dstar->width * dstar->height;
+    int numTouched = 0;
+    for (int tile = 0; tile < numTiles; tile++) {
+        if (dstar->searchMark[tile] == dstar->searchId) numTouched++;
+    }
+    put_signed(writer, numTouched);
+    int previous = -1;
+    for (int tile = 0; tile < numTiles; tile++) {
+        if (dstar->searchMark[tile] != dstar->searchId) continue;
+        put_unsigned(writer, tile - previous - 1);
+        put_unsigned(writer, dstar->g[tile] >= DSTAR_INFINITY ? 0 : dstar->g[tile] + 1);
+        put_unsigned(writer, dstar->rhs[tile] >= DSTAR_INFINITY ? 0 : dstar->rhs[tile] + 1);
+        previous = tile;
+    }
+}
+
+// this function writes the planned order of the markers and how far through it the robot is
+static void put_tour(SnapshotWriter *writer, const Tour *tour)
+{
+    put_signed(writer, tour->numMarkers);
+    put_signed(writer, tour->next);
+    put_signed(writer, tour->length);
+    for (int i = 0; i <= tour->numMarkers; i++) {
+        put_coord(writer, tour->stops[i]);
+        put_signed(writer, tour->order[i]);
+    }
+}
+
+// this function reads the config written by put_config, with drawing left at its defaults; the events are copied into a new array (NULL if there are none) if events is not NULL, and only skipped past if it is; returns S_ERR_ALLOC if the copy cannot be made
+static Status get_config(SnapshotReader *reader, SimConfig *config, ObstacleEvent **events)
+{
+    default_sim_config(config);
+    config->arenaWidth = get_int(reader, 0, INT32_MAX);
+    config->arenaHeight = get_int(reader, 0, INT32_MAX);
+    config->obstacleFormation = get_int(reader, O_NONE, O_CAVERN_RANDOM);
+    config->numObstacles = get_int(reader, 0, INT32_MAX);
+    config->markerFormation = get_int(reader, M_EDGE, M_RANDOM);
+    config->numMarkers = get_int(reader, 0, INT32_MAX); // the pool is sized by it before the arena can check it
+    config->seed = get_unsigned(reader);
+    config->start = get_coord(reader, config->arenaWidth, config->arenaHeight, 1);
+    config->startDirection = get_int(reader, -1, WEST);
+    config->senseRadius = get_int(reader, INT32_MIN, INT32_MAX);
+    config->turnAwareRoutes = get_int(reader, 0, 1);
+    config->routeMoveCost = get_int(reader, INT32_MIN, INT32_MAX);
+    config->routeTurnCost = get_int(reader, INT32_MIN, INT32_MAX);
+    config->hierarchicalRoutes = get_int(reader, 0, 1);
+    config->jumpPointRoutes = get_int(reader, 0, 1);
+    config->incrementalRoutes = get_int(reader, 0, 1);
+    config->knownArena = get_int(reader, 0, 1);
+    config->carryCapacity = get_int(reader, 0, INT32_MAX);
+    config->depot = get_coord(reader, config->arenaWidth, config->arenaHeight, 1);
+    config->gridLayout = get_int(reader, G_DENSE, G_MORTON);
+
+    int numEvents = get_int(reader, 0, INT32_MAX);
+    if ((size_t)numEvents > reader->size) reader->failed = 1; // each event takes at least four bytes, so a count this big is corrupt
+    if (reader->failed) numEvents = 0;
+    ObstacleEvent *copy = NULL;
+    if (events != NULL && numEvents > 0) {
+        copy = malloc(numEvents * sizeof(ObstacleEvent));
+        if (copy == NULL) {
+            fprintf(stderr, "Malloc returned null in get_config\n");
+            return S_ERR_ALLOC;
+        }
+    }
+    for (int i = 0; i < numEvents; i++) {
+        ObstacleEvent event;
+        event.step = get_signed(reader);
+        event.x = get_int(reader, INT32_MIN, INT32_MAX);
+        event.y = get_int(reader, INT32_MIN, INT32_MAX);
+        event.blocked = get_int(reader, 0, 1);
+        if (copy != NULL) copy[i] = event;
+    }
+    config->obstacleEvents = copy;
+    config->numObstacleEvents = numEvents;
+    if (events != NULL) *events = copy;
+    return S_OK;
+}
+
+// this function reads the arena written by put_arena into an empty one
+static Status get_arena(SnapshotReader *reader, Arena *arena)
+{
+    arena->rng.state = get_unsigned(reader);
+    arena->nextEvent = get_int(reader, 0, arena->numEvents);
+    arena->step = get_signed(reader);
+    arena->changes = get_int(reader, 0, INT32_MAX);
+    arena->depot = get_coord(reader, arena->arenaWidth, arena->arenaHeight, 1);
+    arena->numDelivered = get_int(reader, 0, INT32_MAX);
+    get_grid(reader, &arena->arenaGrid);
+
+    int numMarker = get_int(reader, 0, arena->markers.capacity);
+    for (int i = 0; i < numMarker && !reader->failed; i++) {
+        Coord marker = get_coord(reader, arena->arenaWidth, arena->arenaHeight, 0);
+        if (reader->failed) break;
+        Status status = add_marker(arena, marker.x, marker.y);
+        if (status != S_OK) return status;
+    }
+    return S_OK;
+}
+
+// this function reads the robot written by put_robot into one that has not been placed
+static Status get_robot(SnapshotReader *reader, Robot *robot)
+{
+    int width = robot->arenaWidth;
+    int height = robot->arenaHeight;
+    robot->x = get_int(reader, 0, width - 1);
+    robot->y = get_int(reader, 0, height - 1);
+    robot->direction = get_int(reader, NORTH, WEST);
+    robot->markerCount = get_int(reader, 0, INT32_MAX);
+    robot->knownTiles = get_int(reader, 0, INT32_MAX);
+    robot->spiralState = get_int(reader, SP_REACH_START, SP_TOUR);
+    robot->spiralTarget = get_coord(reader, width, height, 1);
+    robot->routeKind = get_int(reader, RT_MARKER, RT_DEPOT);
+    robot->changesSeen = get_int(reader, 0, INT32_MAX);
+    robot->unreachableMarker = get_coord(reader, width, height, 1);
+    robot->unreachableChanges = get_int(reader, 0, INT32_MAX);
+    robot->trips = get_int(reader, 0, INT32_MAX);
+    robot->resumeState = get_int(reader, SP_REACH_START, SP_TOUR);
+    robot->moveCount = get_int(reader, 0, INT32_MAX);
+    robot->turnCount = get_int(reader, 0, INT32_MAX);
+    get_grid(reader, &robot->memory);
+    get_grid(reader, &robot->visitCounts);
+
+    // a route needs a planner, and a tour needs the tour it was planned in
+    if ((robot->spiralState == SP_FOLLOW_ROUTE && robot->planner == NULL) || (robot->spiralState == SP_TOUR && robot->tour == NULL)) reader->failed = 1;
+
+    return get_path(reader, robot->path, width, height);
+}
+
+// this function reads the planner written by put_planner into a new one, and brings the jump grid up to date with the robot's memory; the new hierarchy has every sector out of date already
+static void get_planner(SnapshotReader *reader, Planner *planner, const TileGrid *memory)
+{
+    int width = planner->width;
+    int height = planner->height;
+    int routeCapacity = 4 * width * height;
+    planner->routeLength = get_int(reader, 0, routeCapacity);
+    planner->routeNext = get_int(reader, 0, planner->routeLength);
+    planner->routeGoal = get_coord(reader, width, height, 1);
+    for (int i = 0; i < planner->routeLength && !reader->failed; i++) {
+        planner->route[i] = get_coord(reader, width, height, 0);
+    }
+    if (planner->jumpGrid != NULL) load_jump_grid(planner->jumpGrid, memory);
+
+    DStar *dstar = planner->dstar;
+    if (dstar == NULL) return;
+    dstar->active = get_int(reader, 0, 1);
+    if (!dstar->active) return;
+    dstar->goal = get_coord(reader, width, height, 0);
+    dstar->last = get_coord(reader, width, height, 0);
+    dstar->km = get_int(reader, 0, INT32_MAX);
+    dstar->overflowed = get_int(reader, 0, 1);
+    int numTiles = width * height;
+    dstar->numChanged = get_int(reader, 0, DSTAR_MAX_CHANGES);
+    for (int i = 0; i < dstar->numChanged; i++) {
+        dstar->changed[i] = get_int(reader, 0, numTiles - 1);
+    }
+
+    dstar->heapSize = get_int(reader, 0, dstar->heapCapacity);
+    for (int i = 0; i < dstar->heapSize && !reader->failed; i++) {
+        dstar->heap[i].key = get_signed(reader);
+        dstar->heap[i].tile = get_int(reader, 0, numTiles - 1);
+    }
+
+    // tiles the search has not touched read as infinite, as the search id is new to this planner
+    dstar->searchId = 1;
+    int numTouched = get_int(reader, 0, numTiles);
+    int tile = -1;
+    for (int i = 0; i < numTouched && !reader->failed; i++) {
+        unsigned long long gap = get_unsigned(reader);
+        if (gap >= (unsigned long long)(numTiles - tile - 1)) {
+            reader->failed = 1;
+            break;
+        }
+        tile += gap + 1;
+        unsigned long long g = get_unsigned(reader);
+        unsigned long long rhs = get_unsigned(reader);
+        dstar->searchMark[tile] = dstar->searchId;
+        dstar->g[tile] = g == 0 || g > DSTAR_INFINITY ? DSTAR_INFINITY : (int)g - 1;
+        dstar->rhs[tile] = rhs == 0 || rhs > DSTAR_INFINITY ? DSTAR_INFINITY : (int)rhs - 1;
+    }
+}
+
+// this function reads the tour written by put_tour into one that has not been planned
+static void get_tour(SnapshotReader *reader, Tour *tour, int width, int height)
+{
+    tour->numMarkers = get_int(reader, 0, tour->maxMarkers);
+    tour->next = get_int(reader, 0, tour->numMarkers + 1);
+    tour->length = get_int(reader, 0, INT32_MAX);
+    for (int i = 0; i <= tour->numMarkers && !reader->failed; i++) {
+        tour->stops[i] = get_coord(reader, width, height, 0);
+        tour->order[i] = get_int(reader, 0, tour->numMarkers);
+    }
+}
+
+// functions called by the simulation:
+
+// this function returns a 64 bit FNV-1a hash of some bytes, stored at the end of a snapshot so a damaged one is refused rather than restored into a simulation that makes no sense
+static unsigned long long checksum(const unsigned char *data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// this function checks the magic bytes, checksum and version of a snapshot and returns a reader positioned after the version that stops before the checksum, or one that has failed
+static SnapshotReader start_reading(const Snapshot *snapshot)
+{
+    SnapshotReader reader = {snapshot->data, 0, 0, 0};
+    if (snapshot->size < sizeof(SNAPSHOT_MAGIC) + CHECKSUM_SIZE || memcmp(snapshot->data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        reader.failed = 1;
+        return reader;
+    }
+    reader.size = snapshot->size - CHECKSUM_SIZE;
+    unsigned long long stored = 0;
+    for (int i = 0; i < CHECKSUM_SIZE; i++) {
+        stored |= (unsigned long long)snapshot->data[reader.size + i] << (8*i);
+    }
+    if (stored != checksum(snapshot->data, reader.size)) {
+        reader.failed = 1;
+        return reader;
+    }
+    reader.pos = sizeof(SNAPSHOT_MAGIC);
+    if (get_unsigned(&reader) != SNAPSHOT_VERSION) reader.failed = 1;
+    return reader;
+}
+
+// this function packs the whole state of a simulation into a snapshot, replacing what it held but reusing its buffer; returns S_ERR_ALLOC if the buffer cannot grow
+Status take_snapshot(const Simulation *sim, Snapshot *snapshot)
+{
+    SnapshotWriter writer = {snapshot, 0};
+    snapshot->size = 0;
+    for (size_t i = 0; i < sizeof(SNAPSHOT_MAGIC); i++) {
+        put_byte(&writer, SNAPSHOT_MAGIC[i]);
+    }
+    put_unsigned(&writer, SNAPSHOT_VERSION);
+
+    put_config(&writer, &sim->config);
+    put_signed(&writer, sim->status);
+    put_arena(&writer, sim->arena);
+    put_robot(&writer, sim->robot);
+    if (sim->robot->planner != NULL) put_planner(&writer, sim->robot->planner);
+    if (sim->robot->tour != NULL) put_tour(&writer, sim->robot->tour);
+    if (writer.failed) return S_ERR_ALLOC;
+
+    unsigned long long sum = checksum(snapshot->data, snapshot->size);
+    for (int i = 0; i < CHECKSUM_SIZE; i++) {
+        put_byte(&writer, (sum >> (8*i)) & 0xff);
+    }
+    return writer.failed ? S_ERR_ALLOC : S_OK;
+}
+
+// this function reads the config a snapshot was taken with, along with a copy of its obstacle events (NULL if there are none) which the caller has responsibility to free, and with drawing left at its defaults; returns S_ERR_IO if it is not a snapshot of this version
+Status read_snapshot_config(const Snapshot *snapshot, SimConfig *config, ObstacleEvent **events)
+{
+    SnapshotReader reader = start_reading(snapshot);
+    Status status = get_config(&reader, config, events);
+    if (status != S_OK) return status;
+    if (reader.failed) {
+        fprintf(stderr, "Snapshot is damaged or not a version %d snapshot\n", SNAPSHOT_VERSION);
+        free(*events);
+        *events = NULL;
+        return S_ERR_IO;
+    }
+    return S_OK;
+}
+
+// this function fills a simulation created empty (by sim_create_blank) from the config of a snapshot with the state the snapshot holds; returns S_ERR_IO if the snapshot is corrupt
+Status restore_snapshot_state(Simulation *sim, const Snapshot *snapshot)
+{
+    SnapshotReader reader = start_reading(snapshot);
+    SimConfig config;
+    Status status = get_config(&reader, &config, NULL); // the simulation was created from it already
+    if (status != S_OK) return status;
+
+    sim->status = get_int(&reader, S_ERR_IO, S_DONE);
+    status = get_arena(&reader, sim->arena);
+    if (status == S_OK) status = get_robot(&reader, sim->robot);
+    if (status != S_OK) return status;
+    if (sim->robot->planner != NULL) get_planner(&reader, sim->robot->planner, &sim->robot->memory);
+    if (sim->robot->tour != NULL) get_tour(&reader, sim->robot->tour, sim->config.arenaWidth, sim->config.arenaHeight);
+
+    if (reader.failed || reader.pos != reader.size) {
+        fprintf(stderr, "Snapshot is corrupt\n");
+        return S_ERR_IO;
+    }
+    if (sim->robot->memory.failed || sim->robot->visitCounts.failed || sim->arena->arenaGrid.failed) return S_ERR_ALLOC;
+    return S_OK;
+}
+
+// this function frees a snapshot's buffer, leaving it empty so it can be used again
+void free_snapshot(Snapshot *snapshot)
+{
+    free(snapshot->data);
+    snapshot->data = NULL;
+    snapshot->size = 0;
+    snapshot->capacity = 0;
+}
+
+// functions for files:
+
+// this function writes a snapshot to a file, going through a temporary file next to it that is renamed over it at the end so an interrupted write never leaves half a snapshot behind
+Status save_snapshot(const Snapshot *snapshot, const char *path)
+{
+    size_t length = strlen(path);
+    char *tempPath = malloc(length + 5);
+    if (tempPath == NULL) {
+        fprintf(stderr, "Malloc returned null in save_snapshot\n");
+        return S_ERR_ALLOC;
+    }
+    memcpy(tempPath, path, length);
+    memcpy(tempPath + length, ".tmp", 5);
+
+    FILE *file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open %s for writing\n", tempPath);
+        free(tempPath);
+        return S_ERR_IO;
+    }
+    int written = fwrite(snapshot->data, 1, snapshot->size, file) == snapshot->size;
+    if (fclose(file) != 0) written = 0;
+    if (!written || rename(tempPath, path) != 0) {
+        fprintf(stderr, "Could not write snapshot to %s\n", path);
+        remove(tempPath);
+        free(tempPath);
+        return S_ERR_IO;
+    }
+    free(tempPath);
+    return S_OK;
+}
+
+// this function reads a whole snapshot file into a snapshot, replacing what it held; returns S_ERR_IO if the file cannot be read
+Status load_snapshot(const char *path, Snapshot *snapshot)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open snapshot file %s\n", path);
+        return S_ERR_IO;
+    }
+
+    // read in blocks, doubling the buffer whenever it is full
+    snapshot->size = 0;
+    Status status = S_OK;
+    while (status == S_OK) {
+        if (snapshot->size == snapshot->capacity) {
+            size_t capacity = snapshot->capacity == 0 ? 1 << 16 : 2*snapshot->capacity;
+            unsigned char *grown = realloc(snapshot->data, capacity);
+            if (grown == NULL) {
+                fprintf(stderr, "Realloc returned null in load_snapshot\n");
+                status = S_ERR_ALLOC;
+                break;
+            }
+            snapshot->data = grown;
+            snapshot->capacity = capacity;
+        }
+        size_t read = fread(snapshot->data + snapshot->size, 1, snapshot->capacity - snapshot->size, file);
+        snapshot->size += read;
+        if (read == 0) break;
+    }
+    if (status == S_OK && ferror(file)) {
+        fprintf(stderr, "Could not read snapshot file %s\n", path);
+        status = S_ERR_IO;
+    }
+    fclose(file);
+    return status;
+}
@@ -1,8 +1,13 @@
 // This program contains the spiral algorithm the robot uses to visit all available tiles
 
+#include "../include/arena.h"
 #include "../include/drawing.h"
+#include "../include/dstar.h"
+#include "../include/pathfind.h"
+#include "../include/profile.h"
 #include "../include/robot.h"
 #include "../include/spiral.h"
+#include "../include/tour.h"
 #include "../include/utils.h"
 
 #include "../lib/graphics.h"
@@ -11,7 +16,7 @@
 #include <stdio.h>
 #include <math.h>
 
-// this function gets the cardinal direction of an adjacent Coord tile; pre-requisite: tile is adjacent to robot
+// this function gets the cardinal direction of an adjacent Coord tile, returning -1 if the tile is not adjacent to robot
 static Direction direction_of_adj_tile(Robot *robot, Coord tile)
 {
     int dx = tile.x - robot->x;
@@ -30,81 +35,230 @@ static Direction direction_of_adj_tile(Robot *robot, Coord tile)
     }
     else {
         fprintf(stderr, "Tile cannot have been adjacent to robots position in direction_of_adj_tile\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 }
 
-// this function checks if the current tile is a marker and if so picks it up
+// this function draws the current frame if the robot is being rendered
+static void draw_frame(Robot *robot, Arena *arena)
+{
+    if (robot->render) draw_foreground(robot, arena);
+}
+
+// this function checks if the current tile is a marker and if so picks it up; if the robot cannot carry any more, the tile is forgotten instead so the search comes back for the marker
 static void check_for_and_pickup_marker(Robot *robot, Arena *arena)
 {
-    if (is_at_marker(robot, arena)) {
-        pickup_marker(robot, arena);
-        draw_foreground(robot, arena);
+    if (!is_at_marker(robot, arena)) return;
+    if (!can_carry_marker(robot)) {
+        forget_current_tile(robot);
+        return;
     }
+    pickup_marker(robot, arena);
+    draw_frame(robot, arena);
 }
-
-// this function rotates the robot until its direction matches a specified direction
-static void rotate_to_direction(Robot *robot, Arena *arena, Direction direction)
+// this function makes a single turn towards a direction; pre-requisite: robot is not already facing direction
+static void turn_towards_direction(Robot *robot, Arena *arena, Direction direction)
 {
     int offset = (4 + direction - robot->direction) % 4; // 4 + needed to ensure % works as MOD not remainder
-    switch (offset) {
-        case (0):
-            // already in correct direction
-            break;
-        case(1):
-            turn_right(robot);
-            draw_foreground(robot, arena);
-            break;
-        case(2):
-            // turn 180 degrees
-            turn_right(robot);
-            draw_foreground(robot, arena);
-            turn_right(robot);
-            draw_foreground(robot, arena);
-            break;
-        case(3):
-            turn_left(robot);
-            draw_foreground(robot, arena);
-            break;
-        default:
-            fprintf(stderr, "offset is not 0 to 3 in rotate_to_direction\n");
-            exit(EXIT_FAILURE);
-            break;
-    }
-}
-
-// this function moves the robot to its starting position to facilitate spiral algorithm
-static void reach_spiral_start(Robot *robot, Arena *arena)
+    if (offset == 3) {
+        turn_left(robot);
+    }
+    else { // 1 or 2, where a 180 degree turn is made of two right turns
+        turn_right(robot);
+    }
+    draw_frame(robot, arena);
+}
+
+// this function checks if a tile is next to the robot (not diagonally)
+static int is_adjacent_tile(Robot *robot, Coord tile)
 {
+    return abs(tile.x - robot->x) + abs(tile.y - robot->y) == 1;
+}
+
+// this function plans a route of the given kind with the robot's planner and switches to following it; returns S_ERR_UNREACHABLE if there is no route
+static Status start_route(Robot *robot, RouteKind kind, Coord goal)
+{
+    Coord pos = {robot->x, robot->y};
+    Status status;
+    if (kind == RT_UNKNOWN) {
+        status = plan_route_to_unknown(robot->planner, &robot->memory, pos, robot->direction);
+    }
+    else if (kind == RT_DEPOT) {
+        status = plan_route_over_known(robot->planner, &robot->memory, pos, goal);
+        if (status == S_ERR_UNREACHABLE) status = plan_route_to_tile(robot->planner, &robot->memory, pos, robot->direction, goal); // cut off from the depot by tiles it has not been on, e.g. a depot it has never reached
+    }
+    else {
+        status = plan_route_to_tile(robot->planner, &robot->memory, pos, robot->direction, goal);
+    }
+    if (status != S_OK) return status;
+
+    robot->routeKind = kind;
+    robot->spiralState = SP_FOLLOW_ROUTE;
+    return S_OK;
+}
+
+// this function drops off every marker the robot is carrying at the depot, counting the trip; pre-requisite: the robot is on the depot
+static Status unload_at_depot(Robot *robot, Arena *arena)
+{
+    while (get_marker_carry_count(robot) > 0) {
+        Status status = drop_marker(robot, arena);
+        if (status != S_OK) return status;
+    }
+    robot->trips++;
+    draw_frame(robot, arena);
+    return S_OK;
+}
+
+// this function drops off the markers once the robot has reached the depot and goes back to what it broke off from (or stops the search with S_ERR_UNREACHABLE if it headed there because it could not reach anything else): the tour, heading for a wall if it had not reached one yet, or otherwise routing back to the tile it left off at and backtracking from there, as the spiral cannot start again in the middle of unknown tiles
+static Status resume_after_delivery(Robot *robot, Arena *arena)
+{
+    Status status = unload_at_depot(robot, arena);
+    if (status != S_OK) return status;
+    if (robot->resumeState == SP_DONE) {
+        robot->spiralState = SP_BACKTRACK;
+        robot->spiralTarget = (Coord){-1, -1};
+        return S_ERR_UNREACHABLE;
+    }
+    if (robot->tour != NULL) {
+        robot->spiralState = SP_TOUR;
+        return S_OK;
+    }
+    if (robot->resumeState == SP_REACH_START) {
+        robot->spiralState = SP_REACH_START;
+        return S_OK;
+    }
+
+    robot->spiralState = SP_BACKTRACK;
+    robot->spiralTarget = (Coord){-1, -1};
+    if (stack_size(robot->path) == 0) return S_OK;
+    Coord leftOff = peek(robot->path);
+    if (leftOff.x == robot->x && leftOff.y == robot->y) return S_OK; // left off at the depot, e.g. to route to a marker
+    status = start_route(robot, RT_PATH_TILE, leftOff);
+    if (status == S_ERR_UNREACHABLE && arena->numEvents > 0) return S_OK; // cut off by an obstacle that has moved, so backtrack from here instead
+    return status;
+}
+
+// this function goes back to the spiral, backtracking or the tour once the robot has reached the end of its route
+static Status follow_route_end(Robot *robot, Arena *arena)
+{
+    if (robot->routeKind == RT_DEPOT && robot->x == arena->depot.x && robot->y == arena->depot.y) return resume_after_delivery(robot, arena);
+    if (robot->routeKind == RT_TOUR_STOP) {
+        robot->spiralState = SP_TOUR;
+        return S_OK;
+    }
+    if (robot->routeKind == RT_PATH_TILE) { // reached the tile at the top of the path stack
+        robot->spiralState = SP_BACKTRACK;
+        return S_OK;
+    }
+
+    // continue the path from here so backtracking can get back to this tile
+    Status status = push_pos_to_path(robot);
+    if (status != S_OK) return status;
+    robot->spiralState = SP_SPIRAL;
+    return S_OK;
+}
+
+// this function plans the robot's route again from where it is, after a tile on it has turned out to be blocked; when obstacles can change, a tile on the path or a marker that can no longer be reached is given up on for now rather than stopping the search
+static Status replan_route(Robot *robot, Arena *arena)
+{
+    Status status = start_route(robot, robot->routeKind, robot->planner->routeGoal);
+    if (status != S_ERR_UNREACHABLE || arena->numEvents == 0) return status;
+
+    if (robot->routeKind == RT_PATH_TILE) { // carry on backtracking from the tile before it
+        robot->spiralState = SP_BACKTRACK;
+        robot->spiralTarget = (Coord){-1, -1};
+        return S_OK;
+    }
+    if (robot->routeKind == RT_MARKER) { // back to the spiral as if the route had ended here
+        robot->unreachableMarker = robot->planner->routeGoal;
+        robot->unreachableChanges = arena->changes;
+        return follow_route_end(robot, arena);
+    }
+    return status;
+}
+
+// this function moves the robot one action along its route, replanning if an unknown tile on it turns out to be an obstacle, and goes back to the spiral or backtracking at the end of it
+static Status follow_route_step(Robot *robot, Arena *arena)
+{
+    Planner *planner = robot->planner;
+
+    // with an incremental search, tiles that changed since the route was planned are repaired into it before moving on
+    if (planner->dstar != NULL && robot->routeKind != RT_UNKNOWN && robot->routeKind != RT_DEPOT && dstar_has_changes(planner->dstar)) {
+        Status status = replan_route(robot, arena);
+        if (status != S_OK || robot->spiralState != SP_FOLLOW_ROUTE) return status;
+        if (route_finished(planner)) return follow_route_end(robot, arena);
+    }
+
+    Coord next = next_route_tile(planner);
+    if (!is_adjacent_tile(robot, next)) return S_ERR_INTERNAL;
+
+    Direction dir = direction_of_adj_tile(robot, next);
+    if (dir != robot->direction) {
+        turn_towards_direction(robot, arena, dir);
+        return S_OK;
+    }
+
+    if (!can_move_forward(robot, arena)) {
+        mark_ahead_tile_obstacle(robot);
+        return replan_route(robot, arena); // counts as the action of finding the obstacle
+    }
+
+    forward(robot);
+    mark_current_tile_visited(robot);
+    advance_route(planner);
+    draw_frame(robot, arena);
+    check_for_and_pickup_marker(robot, arena);
+
+    if (route_finished(planner)) return follow_route_end(robot, arena);
+    return S_OK;
+}
+
+// this function sets up the path stack and draws the robot at its starting position before its first action
+static Status setup_spiral(Robot *robot, Arena *arena)
+{
+    Status status = setup_path_stack(robot);
+    if (status != S_OK) return status;
+    if (robot->tour != NULL) robot->spiralState = SP_TOUR; // markers are known so there is nothing to spiral for
+
     // draw starting position
-    draw_foreground(robot, arena);
-    sleep(500);
+    if (robot->render) {
+        draw_foreground(robot, arena);
+        sleep(500);
+    }
+    return S_OK;
+}
 
-    // move forward until an obstacle or arena wall is faced
-    while (can_move_forward(robot, arena) && get_marker_arena_count(arena) > 0) 
-    {
+// this function moves the robot towards its starting position to facilitate spiral algorithm, one tile at a time until an obstacle or arena wall is faced
+static Status reach_start_step(Robot *robot, Arena *arena)
+{
+    if (can_move_forward(robot, arena)) {
         forward(robot);
-        push_pos_to_path(robot);
-        draw_foreground(robot, arena);
-        
+        Status status = push_pos_to_path(robot);
+        if (status != S_OK) return status;
+        draw_frame(robot, arena);
+
         check_for_and_pickup_marker(robot, arena);
+        return S_OK;
     }
 
     mark_ahead_tile_obstacle(robot); // so if the tile is ostacle, it doesnt keep trying to get onto it
     turn_right(robot);
-    draw_foreground(robot, arena);
+    draw_frame(robot, arena);
     mark_current_tile_visited(robot);
+    robot->spiralState = SP_SPIRAL;
+    return S_OK;
 }
 
 // this function spirals round, using a left hand to wall technique, moving in a section as needed
-static void spiral_step(Robot *robot, Arena *arena)
+static Status spiral_step(Robot *robot, Arena *arena)
 {
     if (check_left_tile_unknown(robot)) {
         turn_left(robot);
     }
     else if (can_move_forward(robot, arena) && check_forward_tile_unknown(robot)) { // ahead in bounds and tile is unknown
         forward(robot);
-        push_pos_to_path(robot);
+        Status status = push_pos_to_path(robot);
+        if (status != S_OK) return status;
         mark_current_tile_visited(robot);
     }
     else if (can_move_forward(robot, arena) && !check_forward_tile_unknown(robot)) { // ahead in bounds but already visited
@@ -115,73 +269,288 @@ static void spiral_step(Robot *robot, Arena *arena)
         turn_right(robot);
     }
 
-    draw_foreground(robot, arena);
+    draw_frame(robot, arena);
     check_for_and_pickup_marker(robot, arena);
+    return S_OK;
 }
 
-// this function backtracks, popping nodes from its route as long as it is called
-static void backtrack_step(Robot *robot, Arena *arena)
+// this function backtracks one action towards the previous tile on its route, popping it from the path when a new target is needed; returns S_ERR_UNREACHABLE once it has backtracked to the start
+static Status backtrack_step(Robot *robot, Arena *arena)
 {
-    Coord prevTile = backtrack_path_tile(robot);
-    Direction dirOfPrevTile = direction_of_adj_tile(robot, prevTile);
+    if (robot->spiralTarget.x == -1 && robot->spiralTarget.y == -1) {
+        if (stack_size(robot->path) > 0) { // empty when backtracking again after waiting for an obstacle to change
+            robot->spiralTarget = backtrack_path_tile(robot);
+            while (robot->spiralTarget.x == robot->x && robot->spiralTarget.y == robot->y) { // already there, after passing by a tile an obstacle moved onto
+                robot->spiralTarget = backtrack_path_tile(robot);
+            }
+        }
+        if (robot->spiralTarget.x == -1 && robot->spiralTarget.y == -1) { // backtracked to the start and could not find tile
+            if (robot->planner == NULL) return S_ERR_UNREACHABLE;
+
+            // tiles moved through on routes are not on the path, so there may still be an unknown tile to route to
+            Status status = start_route(robot, RT_UNKNOWN, robot->spiralTarget);
+            if (status != S_OK) return status;
+            return follow_route_step(robot, arena);
+        }
+
+        // the path jumps where the robot followed a route, so route back to the previous tile
+        if (!is_adjacent_tile(robot, robot->spiralTarget) && robot->planner != NULL) {
+            Coord target = robot->spiralTarget;
+            robot->spiralTarget = (Coord){-1, -1};
+            Status status = start_route(robot, RT_PATH_TILE, target);
+            if (status == S_ERR_UNREACHABLE && arena->numEvents > 0) return S_OK; // cut off by an obstacle that has moved, so pass it by
+            if (status != S_OK) return status;
+            return follow_route_step(robot, arena);
+        }
+    }
+
+    Direction dirOfPrevTile = direction_of_adj_tile(robot, robot->spiralTarget);
+    if (dirOfPrevTile == -1) return S_ERR_INTERNAL;
     if (dirOfPrevTile != robot->direction) { 
-        rotate_to_direction(robot, arena, dirOfPrevTile);
-        draw_foreground(robot, arena); // no need to redraw foreground if same direction as this slows drawapp
+        turn_towards_direction(robot, arena, dirOfPrevTile);
+        if (robot->direction == dirOfPrevTile) draw_frame(robot, arena); // extra frame once the rotation is complete
+        return S_OK;
+    }
+    robot->spiralTarget = (Coord){-1, -1};
+    if (!can_move_forward(robot, arena)) { // an obstacle has moved onto the path, so pass the tile by and route to the one before it
+        mark_ahead_tile_obstacle(robot);
+        return S_OK;
     }
     forward(robot); // should not push position to path as currently at that position
-    draw_foreground(robot, arena);
+    draw_frame(robot, arena);
+    return S_OK;
 }
 
-// this function attempts to move back onto an unknown tile
-static int move_onto_unknown_tile(Robot *robot, Arena *arena)
+// this function makes one action towards moving back onto an adjacent unknown tile, returning to the spiral once it is on it
+static Status move_to_unknown_step(Robot *robot, Arena *arena)
 {
-    Coord unvisitedTile = adjacent_unvisited_tile(robot);
-    Direction dir = direction_of_adj_tile(robot, unvisitedTile); // finds the tile to try to move onto
+    if (robot->spiralTarget.x == -1 && robot->spiralTarget.y == -1) {
+        robot->spiralTarget = adjacent_unvisited_tile(robot); // finds the tile to try to move onto
+    }
+
+    Direction dir = direction_of_adj_tile(robot, robot->spiralTarget);
+    if (dir == -1) return S_ERR_INTERNAL;
     if (dir != robot->direction) {
-        rotate_to_direction(robot, arena, dir);
-        draw_foreground(robot, arena);
+        turn_towards_direction(robot, arena, dir);
+        if (robot->direction == dir) draw_frame(robot, arena); // extra frame once the rotation is complete
+        return S_OK;
     }
+
+    robot->spiralTarget = (Coord){-1, -1};
     if (can_move_forward(robot, arena)) {
         forward(robot);
         mark_current_tile_visited(robot);
-        push_pos_to_path(robot);
-        draw_foreground(robot, arena);
+        Status status = push_pos_to_path(robot);
+        if (status != S_OK) return status;
+        draw_frame(robot, arena);
 
         check_for_and_pickup_marker(robot, arena); // make sure not to forget to pick it up
-        return 1;
+        robot->spiralState = SP_SPIRAL;
+        return S_OK;
     }
     mark_ahead_tile_obstacle(robot); // if cannot move onto it, must be an obstacle
-    return 0;
+    return S_OK;
 }
 
-// this function moves forward until it reaches the edge of the arena or an obstacle and spirals inwards to find all markers
-void find_markers(Robot *robot, Arena *arena)
+// this function heads for the next marker of the planned tour, picking up a marker the robot starts on
+static Status tour_step(Robot *robot, Arena *arena)
+{
+    if (is_at_marker(robot, arena)) {
+        check_for_and_pickup_marker(robot, arena);
+        return S_OK;
+    }
+
+    Coord stop = next_tour_stop(robot->tour, arena);
+    if (stop.x == -1) return S_ERR_INTERNAL; // markers remain that were not on the tour
+
+    Status status = start_route(robot, RT_TOUR_STOP, stop);
+    if (status != S_OK) return status;
+    return follow_route_step(robot, arena);
+}
+
+// this function routes to the unknown tile that is quickest to reach and makes the first action of the route, used by a turn aware planner instead of retracing the path
+static Status route_to_unknown_step(Robot *robot, Arena *arena)
+{
+    Status status = start_route(robot, RT_UNKNOWN, (Coord){-1, -1});
+    if (status != S_OK) return status;
+    return follow_route_step(robot, arena);
+}
+
+// this function makes one action of a state's step function, timing it as a phase
+static Status timed_step(ProfilePhase phase, Status (*step)(Robot*, Arena*), Robot *robot, Arena *arena)
+{
+    long long start = profile_start();
+    Status status = step(robot, arena);
+    profile_stop(phase, start);
+    return status;
+}
+
+// this function is called when the robot cannot reach anything it needs while obstacles can still change: if any tile has changed since it last did so, it forgets the obstacles it remembers so it will look again, otherwise it waits until the next scripted event; either counts as its action
+static Status wait_for_changes(Robot *robot, Arena *arena)
+{
+    if (robot->spiralState == SP_FOLLOW_ROUTE) { // the route could not be replanned, so give it up as if it had ended here
+        Status status = follow_route_end(robot, arena);
+        if (status != S_OK) return status;
+    }
+    if (arena->changes != robot->changesSeen) {
+        robot->changesSeen = arena->changes;
+        forget_blocked_tiles(robot);
+        sense_adjacent_tiles(robot, arena);
+        return S_OK;
+    }
+    if (!obstacle_events_pending(arena)) return S_ERR_UNREACHABLE;
+    arena->step = arena->events[arena->nextEvent].step;
+    return S_OK;
+}
+
+// this function checks if the robot should take the markers it is carrying back to the depot: once it cannot carry any more, or once it has picked up the last one, unless it is already on its way
+static int needs_to_deliver(Robot *robot, Arena *arena)
+{
+    if (robot->carryCapacity == 0 || get_marker_carry_count(robot) == 0 || robot->spiralState == SP_DONE) return 0;
+    if (robot->spiralState == SP_FOLLOW_ROUTE && robot->routeKind == RT_DEPOT) return 0;
+    return !can_carry_marker(robot) || get_marker_arena_count(arena) == 0;
+}
+
+// this function breaks off whatever the robot is doing to head for the depot, or drops off the markers straight away if it is already there
+static Status head_for_depot(Robot *robot, Arena *arena)
 {
-    setup_path_stack(robot);
+    if (robot->x == arena->depot.x && robot->y == arena->depot.y) return unload_at_depot(robot, arena);
 
-    reach_spiral_start(robot, arena);
+    robot->spiralTarget = (Coord){-1, -1};
+    robot->resumeState = robot->spiralState;
+    return start_route(robot, RT_DEPOT, arena->depot);
+}
+
+// this function takes the markers the robot is still carrying back to the depot once it cannot reach anything else, so they are counted as delivered, making the first action of the route; returns S_ERR_UNREACHABLE if it is not carrying any or cannot reach the depot either
+static Status deliver_before_stopping(Robot *robot, Arena *arena)
+{
+    if (robot->carryCapacity == 0 || get_marker_carry_count(robot) == 0) return S_ERR_UNREACHABLE;
+    if (robot->x == arena->depot.x && robot->y == arena->depot.y) {
+        Status status = unload_at_depot(robot, arena);
+        return status == S_OK ? S_ERR_UNREACHABLE : status;
+    }
 
-    // then spiral clockwise (by keeping already visited tiles or unvisitable tiles to the left)
-    while (get_marker_arena_count(arena) > 0) // !! change this to count num unvisited tiles
-    { 
-        while (!is_surrounded_by_known(robot) && get_marker_arena_count(arena) > 0)
-        {
-            spiral_step(robot, arena);
+    long long start = profile_start();
+    Status status = start_route(robot, RT_DEPOT, arena->depot);
+    profile_stop(PF_DELIVER, start);
+    if (status != S_OK) return status;
+    robot->spiralTarget = (Coord){-1, -1};
+    robot->resumeState = SP_DONE; // nothing to go back to
+    return timed_step(PF_ROUTE_STEP, follow_route_step, robot, arena);
+}
+
+// this function makes the action for the robot's current state, changing state as needed
+static Status state_step(Robot *robot, Arena *arena)
+{
+    if (robot->spiralState == SP_REACH_START && stack_size(robot->path) == 0) { // first action, the start has not been pushed yet
+        Status status = setup_spiral(robot, arena);
+        if (status != S_OK) return status;
+    }
+
+    // loop only to change state, each state returns once it has made an action
+    while (1) {
+        if (needs_to_deliver(robot, arena)) {
+            long long start = profile_start();
+            Status status = head_for_depot(robot, arena);
+            profile_stop(PF_DELIVER, start);
+            if (status != S_OK) return status;
+        }
+        if (robot->spiralState != SP_DONE && get_marker_arena_count(arena) == 0 && (robot->carryCapacity == 0 || get_marker_carry_count(robot) == 0)) {
+            robot->spiralState = SP_DONE;
         }
 
-        int on_unknown_tile = 0; // keep track of if getting onto the unknown tile was succesful
-        while (!on_unknown_tile && get_marker_arena_count(arena) > 0)
-        {
-            while (is_surrounded_by_known(robot) && get_marker_arena_count(arena) > 0)
-            {
-                backtrack_step(robot, arena);
+        // between actions of the spiral, head straight for any marker within sensing range
+        int betweenActions = robot->spiralState == SP_SPIRAL || ((robot->spiralState == SP_BACKTRACK || robot->spiralState == SP_MOVE_TO_UNKNOWN) && robot->spiralTarget.x == -1);
+        if (robot->senseRadius > 0 && robot->planner != NULL && betweenActions) {
+            long long start = profile_start();
+            Coord marker = sense_marker(robot, arena);
+            Status status = S_OK;
+            int givenUp = marker.x == robot->unreachableMarker.x && marker.y == robot->unreachableMarker.y && arena->changes == robot->unreachableChanges;
+            if (marker.x != -1 && !givenUp) status = start_route(robot, RT_MARKER, marker);
+            if (status == S_ERR_UNREACHABLE && arena->numEvents > 0) { // cut off for now, so carry on exploring until an obstacle moves
+                robot->unreachableMarker = marker;
+                robot->unreachableChanges = arena->changes;
+                status = S_OK;
             }
+            profile_stop(PF_SENSE_MARKERS, start);
+            if (status != S_OK) return status; // with unknown tiles treated as passable, no route means the marker cannot be reached
+        }
+
+        switch (robot->spiralState) {
+            case SP_REACH_START:
+                return timed_step(PF_REACH_START_STEP, reach_start_step, robot, arena);
 
-            on_unknown_tile = move_onto_unknown_tile(robot, arena);
+            case SP_SPIRAL:
+                // spiral clockwise (by keeping already visited tiles or unvisitable tiles to the left) until trapped
+                if (is_surrounded_by_known(robot)) {
+                    robot->spiralState = SP_BACKTRACK;
+                    break;
+                }
+                return timed_step(PF_SPIRAL_STEP, spiral_step, robot, arena);
+
+            case SP_BACKTRACK:
+                // a turn aware planner goes straight to the unknown tile that is quickest to reach rather than retracing the path
+                if (robot->planner != NULL && robot->planner->turnAware && robot->spiralTarget.x == -1) {
+                    return timed_step(PF_ROUTE_STEP, route_to_unknown_step, robot, arena);
+                }
+
+                // finish moving onto the popped tile before checking for unknown neighbours
+                if (robot->spiralTarget.x == -1 && !is_surrounded_by_known(robot)) {
+                    robot->spiralState = SP_MOVE_TO_UNKNOWN;
+                    break;
+                }
+                return timed_step(PF_BACKTRACK_STEP, backtrack_step, robot, arena);
+
+            case SP_MOVE_TO_UNKNOWN:
+                if (robot->spiralTarget.x == -1 && is_surrounded_by_known(robot)) { // the unknown tile was an obstacle
+                    robot->spiralState = SP_BACKTRACK;
+                    break;
+                }
+                return timed_step(PF_MOVE_TO_UNKNOWN_STEP, move_to_unknown_step, robot, arena);
+
+            case SP_FOLLOW_ROUTE:
+                return timed_step(PF_ROUTE_STEP, follow_route_step, robot, arena);
+
+            case SP_TOUR:
+                return timed_step(PF_ROUTE_STEP, tour_step, robot, arena);
+
+            case SP_DONE:
+                return S_DONE;
+
+            default:
+                fprintf(stderr, "Unknown spiral state %d in spiral_step_once\n", robot->spiralState);
+                return S_ERR_INTERNAL;
         }
     }
 }
 
-/*
-current plan: just store where has been and backtrack until reaching a position where the robot is not surrounded
-*/
+// this function advances the spiral algorithm by exactly one action (a move, a turn or a failed attempt to move), changing state as needed, with any scripted obstacle changes due applied first; returns S_OK while markers remain, S_DONE once all are found, or an error
+Status spiral_step_once(Robot *robot, Arena *arena)
+{
+    if (arena->numEvents == 0) {
+        Status status = state_step(robot, arena);
+        if (status == S_ERR_UNREACHABLE) return deliver_before_stopping(robot, arena);
+        return status;
+    }
+
+    long long start = profile_start();
+    if (apply_obstacle_events(arena, (Coord){robot->x, robot->y}) > 0 && robot->render) redraw_obstacles(arena);
+    sense_adjacent_tiles(robot, arena);
+    profile_stop(PF_OBSTACLE_EVENTS, start);
+
+    Status status = state_step(robot, arena);
+    if (status == S_ERR_UNREACHABLE) status = wait_for_changes(robot, arena);
+    if (status == S_ERR_UNREACHABLE) return deliver_before_stopping(robot, arena);
+    return status;
+}
+
+// this function moves forward until it reaches the edge of the arena or an obstacle and spirals inwards to find all markers
+Status find_markers(Robot *robot, Arena *arena)
+{
+    Status status;
+    do {
+        status = spiral_step_once(robot, arena);
+    } while (status == S_OK);
+
+    return status == S_DONE ? S_OK : status;
+}
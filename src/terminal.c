@@ -0,0 +1,225 @@
+// This file draws the simulation in a terminal with ANSI escape codes, for looking at runs where there is no display; each tile is two characters wide and the view scrolls to follow the robot when the arena is bigger than the terminal
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/arena.h"
+#include "../include/robot.h"
+#include "../include/terminal.h"
+#include "../include/utils.h"
+
+#include "../lib/graphics.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+#define DEFAULT_TERMINAL_COLUMNS 80
+#define DEFAULT_TERMINAL_ROWS 24
+#define TERMINAL_MAX_VIEW 256 // most tiles shown across or down, however big the terminal
+
+// what a cell shows, which decides its colours
+typedef enum {
+    CS_EMPTY,
+    CS_OBSTACLE,
+    CS_MARKER,
+    CS_ROBOT,
+    CS_NUM_STYLES
+} CellStyle;
+
+static const char *const styleCodes[CS_NUM_STYLES] = {
+    "\x1b[0;30;47m", // empty: white
+    "\x1b[0;37;40m", // obstacle: black
+    "\x1b[0;90;47m", // marker: gray on white
+    "\x1b[1;34;47m" // robot: blue on white
+};
+
+// one tile on screen, drawn as two characters
+typedef struct {
+    char glyph[2];
+    unsigned char style;
+} Cell;
+
+// the terminal as last drawn, so each frame only rewrites the tiles that changed
+static struct {
+    int viewWidth; // tiles shown across
+    int viewHeight;
+    int viewX; // arena position of the top left tile shown
+    int viewY;
+    Cell shadow[TERMINAL_MAX_VIEW*TERMINAL_MAX_VIEW];
+    char *frame; // escape codes for the frame being built, written all at once
+    size_t frameLength;
+    size_t frameCapacity;
+    char status[128]; // line under the arena as last drawn
+} screen;
+
+// functions for building a frame:
+
+// this function adds text to the frame being built; text is dropped if it cannot grow
+static void append(const char *text, size_t length)
+{
+    if (screen.frameLength + length > screen.frameCapacity) {
+        size_t capacity = screen.frameCapacity > 0 ? screen.frameCapacity : 4096;
+        while (capacity < screen.frameLength + length) capacity *= 2;
+        char *frame = realloc(screen.frame, capacity);
+        if (frame == NULL) {
+            fprintf(stderr, "Realloc returned null in append\n");
+            return;
+        }
+        screen.frame = frame;
+        screen.frameCapacity = capacity;
+    }
+    memcpy(screen.frame + screen.frameLength, text, length);
+    screen.frameLength += length;
+}
+
+// this function adds a string to the frame being built
+static void append_string(const char *text)
+{
+    append(text, strlen(text));
+}
+
+// this function adds an escape code moving the cursor to a terminal row and column, both from 1
+static void append_move(int row, int column)
+{
+    char code[32];
+    int length = snprintf(code, sizeof(code), "\x1b[%d;%dH", row, column);
+    append(code, length);
+}
+
+// this function writes the frame built so far to the output and starts a new one
+static void send_frame()
+{
+    if (screen.frameLength == 0) return;
+    writeOutput(screen.frame, screen.frameLength);
+    flushOutput();
+    screen.frameLength = 0;
+}
+
+// functions for working out what is shown:
+
+// this function finds how many tiles fit in the terminal, using its size if it is one and COLUMNS and LINES otherwise
+static void find_view_size(Arena *arena)
+{
+    int columns = DEFAULT_TERMINAL_COLUMNS;
+    int rows = DEFAULT_TERMINAL_ROWS;
+    struct winsize size;
+    if (ioctl(fileno(stdout), TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0) {
+        columns = size.ws_col;
+        rows = size.ws_row;
+    }
+    else {
+        if (getenv("COLUMNS") != NULL && atoi(getenv("COLUMNS")) > 0) columns = atoi(getenv("COLUMNS"));
+        if (getenv("LINES") != NULL && atoi(getenv("LINES")) > 0) rows = atoi(getenv("LINES"));
+    }
+
+    // each tile is two characters wide, and the bottom row is kept for the status line
+    screen.viewWidth = min(min(columns/2, arena->arenaWidth), TERMINAL_MAX_VIEW);
+    screen.viewHeight = min(min(rows - 1, arena->arenaHeight), TERMINAL_MAX_VIEW);
+    if (screen.viewWidth < 1) screen.viewWidth = 1;
+    if (screen.viewHeight < 1) screen.viewHeight = 1;
+}
+
+// this function returns the new start of the view along one axis so the robot stays a quarter of the view away from its edges where the arena allows
+static int follow(int view, int viewSize, int arenaSize, int robotPos)
+{
+    int margin = viewSize/4;
+    if (robotPos < view + margin) view = robotPos - margin;
+    if (robotPos >= view + viewSize - margin) view = robotPos - viewSize + margin + 1;
+    if (view > arenaSize - viewSize) view = arenaSize - viewSize;
+    if (view < 0) view = 0;
+    return view;
+}
+
+// this function returns what the tile at arena position (x, y) should show
+static Cell tile_cell(Robot *robot, Arena *arena, int x, int y)
+{
+    if (robot != NULL && robot->x == x && robot->y == y) {
+        static const char *const arrows[4] = {"/\\", "=>", "\\/", "<="}; // NORTH, EAST, SOUTH, WEST
+        return (Cell){{arrows[robot->direction][0], arrows[robot->direction][1]}, CS_ROBOT};
+    }
+    if (get_tile(&arena->arenaGrid, x, y) == T_OBSTACLE) return (Cell){{' ', ' '}, CS_OBSTACLE};
+    if (robot != NULL && is_marker_at(arena, x, y)) return (Cell){{'(', ')'}, CS_MARKER};
+    return (Cell){{' ', ' '}, CS_EMPTY};
+}
+
+// this function adds whatever differs from the shadow buffer to the frame, moving the cursor and changing colour only when needed
+static void draw_changed_cells(Robot *robot, Arena *arena)
+{
+    int cursorRow = -1;
+    int cursorColumn = -1;
+    int style = -1;
+    for (int row = 0; row < screen.viewHeight; row++) {
+        for (int column = 0; column < screen.viewWidth; column++) {
+            Cell cell = tile_cell(robot, arena, screen.viewX + column, screen.viewY + row);
+            Cell *shown = &screen.shadow[row*TERMINAL_MAX_VIEW + column];
+            if (memcmp(&cell, shown, sizeof(Cell)) == 0) continue;
+            *shown = cell;
+
+            if (cursorRow != row || cursorColumn != column) append_move(row + 1, 2*column + 1);
+            if (style != cell.style) append_string(styleCodes[cell.style]);
+            append(cell.glyph, 2);
+            cursorRow = row;
+            cursorColumn = column + 1;
+            style = cell.style;
+        }
+    }
+}
+
+// this function rewrites the status line if it has changed
+static void draw_status(Robot *robot, Arena *arena)
+{
+    char status[sizeof(screen.status)];
+    snprintf(status, sizeof(status), "markers %d/%d  robot (%d, %d)  view (%d, %d) of %dx%d", robot->markerCount + arena->numDelivered, robot->markerCount + arena->numDelivered + arena->numMarker, robot->x, robot->y, screen.viewX, screen.viewY, arena->arenaWidth, arena->arenaHeight);
+    if (strcmp(status, screen.status) == 0) return;
+    strcpy(screen.status, status);
+
+    append_move(screen.viewHeight + 1, 1);
+    append_string("\x1b[0m\x1b[2K");
+    append_string(status);
+}
+
+// functions called from drawing.c:
+
+// this function clears the terminal and draws the arena without the markers or robot - called once at start
+void terminal_draw_background(Arena *arena)
+{
+    find_view_size(arena);
+    screen.viewX = 0;
+    screen.viewY = 0;
+    screen.status[0] = '\0';
+
+    append_string("\x1b[?25l\x1b[0m\x1b[2J"); // hide the cursor and clear the screen
+    for (int i = 0; i < TERMINAL_MAX_VIEW*TERMINAL_MAX_VIEW; i++) screen.shadow[i] = (Cell){{0, 0}, CS_NUM_STYLES}; // matches no real cell, so everything is drawn
+    draw_changed_cells(NULL, arena);
+    send_frame();
+}
+
+// this function moves the view to follow the robot and redraws the tiles that have changed - called once per drawn frame
+void terminal_draw_foreground(Robot *robot, Arena *arena)
+{
+    screen.viewX = follow(screen.viewX, screen.viewWidth, arena->arenaWidth, robot->x);
+    screen.viewY = follow(screen.viewY, screen.viewHeight, arena->arenaHeight, robot->y);
+    draw_changed_cells(robot, arena);
+    draw_status(robot, arena);
+    send_frame();
+}
+
+// this function waits for a number of miliseconds, as nothing reads the sleeps the drawapp is sent
+void terminal_sleep(int time)
+{
+    struct timespec wait = {time / 1000, (long)(time % 1000) * 1000000};
+    nanosleep(&wait, NULL);
+}
+
+// this function leaves the cursor under the status line and shows it again, so the shell prompt is not drawn over the arena
+void terminal_finish(void)
+{
+    append_move(screen.viewHeight + 2, 1);
+    append_string("\x1b[0m\x1b[?25h");
+    send_frame();
+    free(screen.frame);
+    screen.frame = NULL;
+    screen.frameCapacity = 0;
+}
@@ -0,0 +1,153 @@
+// This file stores grids of tiles either densely or as chunks allocated on first write, so a huge arena only uses memory for the parts that have something in them
+
+#include "../include/pool.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// this function returns how many chunks are needed to cover length tiles
+static int chunks_across(int length)
+{
+    return (length + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+}
+
+// this function returns log2 of the block width for a layout that stores its tiles in blocks, or 0 for one that does not
+static int block_shift(GridLayout layout)
+{
+    switch (layout) {
+        case G_TILED: return TILED_BLOCK_SHIFT;
+        case G_MORTON: return MORTON_BLOCK_SHIFT;
+        default: return 0;
+    }
+}
+
+// this function returns how many bytes the cells of a grid holding every tile take up, counting the padding out to whole blocks
+static size_t cells_size(int width, int height, int cellSize, GridLayout layout)
+{
+    int shift = block_shift(layout);
+    if (shift == 0) return (size_t)width * height * cellSize;
+    size_t blocksWide = ((size_t)width + (1 << shift) - 1) >> shift;
+    size_t blocksHigh = ((size_t)height + (1 << shift) - 1) >> shift;
+    return (blocksWide * blocksHigh << (2*shift)) * cellSize;
+}
+
+// this function returns how many bytes of pool create_tile_grid needs; a sparse grid only takes its chunk directory from the pool
+size_t tile_grid_pool_size(int width, int height, int cellSize, GridLayout layout)
+{
+    if (layout == G_SPARSE) return pool_aligned_size((size_t)chunks_across(width) * chunks_across(height) * sizeof(unsigned char *));
+    if (block_shift(layout) != 0) return pool_aligned_size(cells_size(width, height, cellSize, layout) + CACHE_LINE_SIZE); // room to start the blocks on a cache line
+    return pool_aligned_size(cells_size(width, height, cellSize, layout));
+}
+
+// this function sets up a grid with every tile 0, taking its cells (dense) or chunk directory (sparse) from the pool; returns S_ERR_ALLOC if the pool does not have space
+Status create_tile_grid(TileGrid *grid, Pool *pool, int width, int height, int cellSize, GridLayout layout)
+{
+    grid->width = width;
+    grid->height = height;
+    grid->cellSize = cellSize;
+    grid->layout = layout;
+    grid->cells = NULL;
+    grid->chunks = NULL;
+    grid->chunksWide = chunks_across(width);
+    grid->chunksHigh = chunks_across(height);
+    grid->blockShift = block_shift(layout);
+    grid->blocksWide = grid->blockShift == 0 ? 0 : (width + (1 << grid->blockShift) - 1) >> grid->blockShift;
+    grid->numChunks = 0;
+    grid->failed = 0;
+
+    // pool memory is zeroed, so every tile starts at 0 and every chunk pointer starts as NULL
+    if (layout == G_SPARSE) {
+        grid->chunks = pool_alloc(pool, (size_t)grid->chunksWide * grid->chunksHigh * sizeof(unsigned char *));
+    }
+    else if (grid->blockShift != 0) {
+        // a block only shares cache lines with its neighbours if the first one starts on a line
+        unsigned char *cells = pool_alloc(pool, cells_size(width, height, cellSize, layout) + CACHE_LINE_SIZE);
+        if (cells != NULL) grid->cells = cells + (CACHE_LINE_SIZE - (uintptr_t)cells % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+    }
+    else {
+        grid->cells = pool_alloc(pool, cells_size(width, height, cellSize, layout));
+    }
+    if (grid->cells == NULL && grid->chunks == NULL) {
+        fprintf(stderr, "Pool has no space for a %d x %d tile grid in create_tile_grid\n", width, height);
+        return S_ERR_ALLOC;
+    }
+    return S_OK;
+}
+
+// this function frees the chunks of a sparse grid, leaving every tile 0; the cells or directory go when the pool is reset
+void release_tile_grid(TileGrid *grid)
+{
+    if (grid->layout != G_SPARSE || grid->chunks == NULL) return;
+    size_t numSlots = (size_t)grid->chunksWide * grid->chunksHigh;
+    for (size_t i = 0; i < numSlots && grid->numChunks > 0; i++) {
+        if (grid->chunks[i] == NULL) continue;
+        free(grid->chunks[i]);
+        grid->chunks[i] = NULL;
+        grid->numChunks--;
+    }
+}
+
+// this function returns how many bytes the grid's tiles take up, counting only the chunks allocated for a sparse grid
+size_t tile_grid_bytes(const TileGrid *grid)
+{
+    if (grid->layout == G_SPARSE) {
+        return (size_t)grid->chunksWide * grid->chunksHigh * sizeof(unsigned char *) + grid->numChunks * CHUNK_SIZE * CHUNK_SIZE * grid->cellSize;
+    }
+    return cells_size(grid->width, grid->height, grid->cellSize, grid->layout);
+}
+
+// this function sets a tile of a sparse grid, allocating its chunk if it has none yet; setting 0 never allocates, as a missing chunk already reads as 0
+void set_sparse_tile(TileGrid *grid, int x, int y, unsigned int value)
+{
+    unsigned char **chunk = &grid->chunks[(y >> CHUNK_SHIFT)*grid->chunksWide + (x >> CHUNK_SHIFT)];
+    if (*chunk == NULL) {
+        if (value == 0) return;
+        *chunk = calloc(CHUNK_SIZE * CHUNK_SIZE, grid->cellSize);
+        if (*chunk == NULL) {
+            if (!grid->failed) fprintf(stderr, "Calloc returned null in set_sparse_tile\n");
+            grid->failed = 1;
+            return;
+        }
+        grid->numChunks++;
+    }
+
+    size_t i = (y & (CHUNK_SIZE - 1))*CHUNK_SIZE + (x & (CHUNK_SIZE - 1));
+    TRACE_TILE(*chunk + i*grid->cellSize);
+    if (grid->cellSize == 1) (*chunk)[i] = value;
+    else ((uint16_t *)*chunk)[i] = value;
+}
+
+// this function checks if the chunk holding tile (x, y) is known to be all 0 because a sparse grid has not allocated it, so loops over the grid can skip it; always 0 for a dense grid
+int is_chunk_empty(const TileGrid *grid, int x, int y)
+{
+    if (grid->layout != G_SPARSE) return 0;
+    return grid->chunks[(y >> CHUNK_SHIFT)*grid->chunksWide + (x >> CHUNK_SHIFT)] == NULL;
+}
+
+// this function returns the name of a layout, as used by parse_grid_layout
+const char* grid_layout_name(GridLayout layout)
+{
+    switch (layout) {
+        case G_DENSE: return "dense";
+        case G_SPARSE: return "sparse";
+        case G_TILED: return "tiled";
+        case G_MORTON: return "morton";
+        default: return "unknown";
+    }
+}
+
+// this function reads a layout from its name (dense, sparse, tiled or morton); returns 0 if the name is not one of them
+int parse_grid_layout(const char *name, GridLayout *layout)
+{
+    for (GridLayout candidate = G_DENSE; candidate <= G_MORTON; candidate++) {
+        if (strcmp(name, grid_layout_name(candidate)) == 0) {
+            *layout = candidate;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+// This file plans the order to visit every marker in when the robot is given the obstacles and markers up front, giving a lower bound to measure the spiral against
+
+#include "../include/arena.h"
+#include "../include/pool.h"
+#include "../include/tour.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+
+#define TOUR_EXACT_LIMIT 12 // above this many markers the order is found with nearest neighbour and 2-opt rather than exactly
+
+// this function returns how many of the markers the exact order is worked out for, which decides the size of its tables
+static int exact_markers(int maxMarkers)
+{
+    return maxMarkers < TOUR_EXACT_LIMIT ? maxMarkers : TOUR_EXACT_LIMIT;
+}
+
+// this function returns how many bytes of pool create_tour needs for an arena of the given size and number of markers
+size_t tour_pool_size(int width, int height, int maxMarkers)
+{
+    size_t numTiles = (size_t)width * height;
+    size_t numStops = maxMarkers + 1;
+    size_t exactStates = ((size_t)1 << exact_markers(maxMarkers)) * exact_markers(maxMarkers);
+    return pool_aligned_size(sizeof(Tour))
+        + pool_aligned_size(numStops * sizeof(Coord))
+        + pool_aligned_size(numStops * sizeof(int))
+        + pool_aligned_size(numStops * numStops * sizeof(int))
+        + 3 * pool_aligned_size(numTiles * sizeof(int))
+        + pool_aligned_size(exactStates * sizeof(int))
+        + pool_aligned_size(exactStates * sizeof(unsigned char));
+}
+
+// this function creates a tour from the pool for an arena of the given size and number of markers; returns NULL if the pool does not have space; freed when the pool is reset
+Tour* create_tour(Pool *pool, int width, int height, int maxMarkers)
+{
+    size_t numTiles = (size_t)width * height;
+    size_t numStops = maxMarkers + 1;
+    size_t exactStates = ((size_t)1 << exact_markers(maxMarkers)) * exact_markers(maxMarkers);
+    Tour *tour = pool_alloc(pool, sizeof(Tour));
+    if (tour == NULL) {
+        fprintf(stderr, "Pool has no space in create_tour\n");
+        return NULL;
+    }
+
+    tour->width = width;
+    tour->height = height;
+    tour->maxMarkers = maxMarkers;
+    tour->stops = pool_alloc(pool, numStops * sizeof(Coord));
+    tour->order = pool_alloc(pool, numStops * sizeof(int));
+    tour->dist = pool_alloc(pool, numStops * numStops * sizeof(int));
+    tour->stopAt = pool_alloc(pool, numTiles * sizeof(int));
+    tour->bfsDist = pool_alloc(pool, numTiles * sizeof(int));
+    tour->queue = pool_alloc(pool, numTiles * sizeof(int));
+    tour->heldKarp = pool_alloc(pool, exactStates * sizeof(int));
+    tour->heldKarpParent = pool_alloc(pool, exactStates * sizeof(unsigned char));
+    if (tour->stops == NULL || tour->order == NULL || tour->dist == NULL || tour->stopAt == NULL || tour->bfsDist == NULL || tour->queue == NULL || tour->heldKarp == NULL || tour->heldKarpParent == NULL) {
+        fprintf(stderr, "Pool has no space for tour arrays in create_tour\n");
+        return NULL;
+    }
+    tour->numMarkers = 0;
+    tour->next = 0;
+    tour->length = 0;
+    return tour;
+}
+
+// this function returns the moves between two stops
+static int stop_dist(Tour *tour, int from, int to)
+{
+    return tour->dist[from*(tour->numMarkers + 1) + to];
+}
+
+// functions for finding the distances between stops:
+
+// this function runs a breadth first search over the arena from one stop, filling in its row of the distance matrix (-1 where a stop cannot be reached); stops once every stop tile has been reached
+static void distances_from_stop(Tour *tour, Arena *arena, int source, int numStopTiles)
+{
+    int width = tour->width;
+    int numTiles = width * tour->height;
+    int numStops = tour->numMarkers + 1;
+    for (int i = 0; i < numTiles; i++) tour->bfsDist[i] = -1;
+
+    int startTile = tour->stops[source].y*width + tour->stops[source].x;
+    int head = 0;
+    int tail = 0;
+    int stopTilesFound = 0;
+    tour->queue[tail++] = startTile;
+    tour->bfsDist[startTile] = 0;
+
+    while (head < tail && stopTilesFound < numStopTiles) {
+        int tile = tour->queue[head++];
+        if (tour->stopAt[tile] != -1) stopTilesFound++;
+
+        for (Direction dir = NORTH; dir <= WEST; dir++) {
+            Coord next = {tile % width, tile / width};
+            if (dir == NORTH) next.y--;
+            if (dir == EAST) next.x++;
+            if (dir == SOUTH) next.y++;
+            if (dir == WEST) next.x--;
+            if (!check_coord_in_bounds(next, width, tour->height)) continue;
+            if (get_tile(&arena->arenaGrid, next.x, next.y) == T_OBSTACLE) continue;
+
+            int nextTile = next.y*width + next.x;
+            if (tour->bfsDist[nextTile] != -1) continue;
+            tour->bfsDist[nextTile] = tour->bfsDist[tile] + 1;
+            tour->queue[tail++] = nextTile;
+        }
+    }
+
+    for (int i = 0; i < numStops; i++) {
+        tour->dist[source*numStops + i] = tour->bfsDist[tour->stops[i].y*width + tour->stops[i].x];
+    }
+}
+
+// functions for finding the visiting order:
+
+// this function finds the shortest order exactly with the Held-Karp dynamic program; pre-requisite: numMarkers is between 1 and TOUR_EXACT_LIMIT
+static void exact_order(Tour *tour)
+{
+    int n = tour->numMarkers;
+    int full = (1 << n) - 1;
+    int *cost = tour->heldKarp;
+    unsigned char *parent = tour->heldKarpParent;
+
+    // cost[set*n + last] is the fewest moves from the start visiting every marker in set and ending on last
+    for (int set = 1; set <= full; set++) {
+        for (int last = 0; last < n; last++) {
+            int state = set*n + last;
+            cost[state] = INT_MAX;
+            if (!(set & (1 << last))) continue;
+
+            int prevSet = set & ~(1 << last);
+            if (prevSet == 0) {
+                cost[state] = stop_dist(tour, 0, last + 1);
+                parent[state] = last;
+                continue;
+            }
+            for (int prev = 0; prev < n; prev++) {
+                if (!(prevSet & (1 << prev)) || cost[prevSet*n + prev] == INT_MAX) continue;
+                int through = cost[prevSet*n + prev] + stop_dist(tour, prev + 1, last + 1);
+                if (through < cost[state]) {
+                    cost[state] = through;
+                    parent[state] = prev;
+                }
+            }
+        }
+    }
+
+    int last = 0;
+    for (int i = 1; i < n; i++) {
+        if (cost[full*n + i] < cost[full*n + last]) last = i;
+    }
+
+    // walk back through the parents to fill in the order from the end
+    int set = full;
+    tour->order[0] = 0;
+    for (int i = n; i >= 1; i--) {
+        tour->order[i] = last + 1;
+        int prev = parent[set*n + last];
+        set &= ~(1 << last);
+        last = prev;
+    }
+}
+
+// this function builds an order by always heading for the closest marker not yet visited
+static void nearest_neighbour_order(Tour *tour)
+{
+    int n = tour->numMarkers;
+    for (int i = 0; i <= n; i++) tour->order[i] = i;
+
+    for (int i = 1; i <= n; i++) {
+        int best = i;
+        for (int j = i + 1; j <= n; j++) {
+            if (stop_dist(tour, tour->order[i-1], tour->order[j]) < stop_dist(tour, tour->order[i-1], tour->order[best])) best = j;
+        }
+        int tmp = tour->order[i];
+        tour->order[i] = tour->order[best];
+        tour->order[best] = tmp;
+    }
+}
+
+// this function improves an order by reversing any section that makes it shorter until none do; the start stays first and the tour does not return to it
+static void two_opt_order(Tour *tour)
+{
+    int n = tour->numMarkers;
+    int *order = tour->order;
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        for (int i = 1; i < n; i++) {
+            for (int j = i + 1; j <= n; j++) {
+                // reversing order[i..j] swaps the edges (i-1, i) and (j, j+1) for (i-1, j) and (i, j+1)
+                int before = stop_dist(tour, order[i-1], order[i]);
+                int after = stop_dist(tour, order[i-1], order[j]);
+                if (j < n) {
+                    before += stop_dist(tour, order[j], order[j+1]);
+                    after += stop_dist(tour, order[i], order[j+1]);
+                }
+                if (after >= before) continue;
+
+                for (int a = i, b = j; a < b; a++, b--) {
+                    int tmp = order[a];
+                    order[a] = order[b];
+                    order[b] = tmp;
+                }
+                improved = 1;
+            }
+        }
+    }
+}
+
+// this function plans the order to visit every marker in from the start using the arena's obstacles and markers; returns S_ERR_UNREACHABLE if any marker cannot be reached
+Status plan_marker_tour(Tour *tour, Arena *arena, Coord start)
+{
+    int numTiles = tour->width * tour->height;
+    if (arena->numMarker > tour->maxMarkers) {
+        fprintf(stderr, "Tour was created for %d markers but arena has %d in plan_marker_tour\n", tour->maxMarkers, arena->numMarker);
+        return S_ERR_INTERNAL;
+    }
+
+    // stop 0 is the start, then the markers in index order
+    tour->numMarkers = arena->numMarker;
+    tour->stops[0] = start;
+    for (int i = 0; i < arena->numMarker; i++) tour->stops[i+1] = arena->markers.positions[i];
+    // a marker can share the start's tile, so count the tiles with stops on rather than the stops
+    int numStopTiles = 0;
+    for (int i = 0; i < numTiles; i++) tour->stopAt[i] = -1;
+    for (int i = tour->numMarkers; i >= 0; i--) {
+        int tile = tour->stops[i].y*tour->width + tour->stops[i].x;
+        if (tour->stopAt[tile] == -1) numStopTiles++;
+        tour->stopAt[tile] = i;
+    }
+
+    for (int source = 0; source <= tour->numMarkers; source++) {
+        distances_from_stop(tour, arena, source, numStopTiles);
+    }
+    for (int i = 1; i <= tour->numMarkers; i++) {
+        if (stop_dist(tour, 0, i) == -1) return S_ERR_UNREACHABLE; // every other distance is then finite as moves are reversible
+    }
+
+    if (tour->numMarkers == 0) {
+        tour->order[0] = 0;
+    }
+    else if (tour->numMarkers <= TOUR_EXACT_LIMIT) {
+        exact_order(tour);
+    }
+    else {
+        nearest_neighbour_order(tour);
+        two_opt_order(tour);
+    }
+
+    tour->length = 0;
+    for (int i = 1; i <= tour->numMarkers; i++) tour->length += stop_dist(tour, tour->order[i-1], tour->order[i]);
+    tour->next = 1;
+    return S_OK;
+}
+
+// this function returns the next marker of the tour that has not already been picked up on the way to an earlier one, or {-1, -1} at the end of the tour; a stop is only passed once its marker is picked up, so a route to it that is broken off (e.g. to deliver markers) is planned again
+Coord next_tour_stop(Tour *tour, Arena *arena)
+{
+    while (tour->next <= tour->numMarkers) {
+        Coord stop = tour->stops[tour->order[tour->next]];
+        if (is_marker_at(arena, stop.x, stop.y)) return stop;
+        tour->next++;
+    }
+    return (Coord){-1, -1};
+}
@@ -1,21 +1,56 @@
 // This function contains utility functions used by numerous programs
+#include "../include/pool.h"
 #include "../include/utils.h"
 #include "../include/robot.h"
 
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#include <limits.h>
+
+// this function returns a short description of a status code for error messages
+const char* status_string(Status status)
+{
+    switch (status) {
+        case S_OK: return "ok";
+        case S_DONE: return "all markers found";
+        case S_ERR_ALLOC: return "memory allocation failed";
+        case S_ERR_CONFIG: return "invalid configuration";
+        case S_ERR_UNREACHABLE: return "one or more markers are unreachable";
+        case S_ERR_STACK: return "path stack overflow";
+        case S_ERR_INTERNAL: return "internal error";
+        case S_ERR_IO: return "could not write file";
+    }
+    return "unknown status";
+}
+
+// this function seeds a random number generator; a seed of 0 is remapped as xorshift cannot leave the zero state
+void seed_rng(Rng *rng, unsigned int seed)
+{
+    rng->state = seed ? seed : 0x9E3779B9u;
+}
+
+// this function advances the generator (32 bit xorshift) and returns the next random number
+unsigned int next_random(Rng *rng)
+{
+    unsigned int x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
 
 //  this function generates a random Direction out of NORTH, SOUTH, EAST, WEST
-Direction random_direction()
+Direction random_direction(Rng *rng)
 {
-    return (Direction)(rand() % 4);
+    return (Direction)(next_random(rng) % 4);
 }
 
 // this function generates a random coordinate from 0 to width_height - 1 which can be used to represent either the width or height of the grid
-int random_coord(int width_height)
+int random_coord(Rng *rng, int width_height)
 {
-    return rand() % width_height;
+    return next_random(rng) % width_height;
 }
 
 // this function finds the min of two integers
@@ -50,25 +85,76 @@ double calc_squared_dist_coords(double x1, double y1, double x2, double y2)
 
 // functions for stack (used in spiral.c)
 
-// function to create a stack of given capacity
-Stack* create_stack(unsigned int capacity) 
+// this function returns how many bytes of pool create_stack needs for the given capacity
+size_t stack_pool_size(unsigned int capacity)
 {
-    Stack *stack = malloc(sizeof(Stack));
+    return pool_aligned_size(sizeof(Stack)) + pool_aligned_size(capacity * sizeof(Coord));
+}
+
+// function to create a stack of given capacity from the pool; returns NULL if the pool does not have space; freed when the pool is reset
+Stack* create_stack(Pool *pool, unsigned int capacity) 
+{
+    Stack *stack = pool_alloc(pool, sizeof(Stack));
     if (stack == NULL) {
-        fprintf(stderr, "Malloc returned null for stack in create_stack\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Pool has no space for stack in create_stack\n");
+        return NULL;
     }
 
     stack->capacity = capacity;
     stack->top = -1;
-    stack->array = malloc(capacity * sizeof(Coord));
+    stack->growable = 0;
+    stack->array = pool_alloc(pool, capacity * sizeof(Coord));
+    if (stack->array == NULL) {
+        fprintf(stderr, "Pool has no space for stack array in create_stack\n");
+        return NULL;
+    }
+    return stack;
+}
+
+// function to create a stack from the pool whose array starts at the given capacity and grows with malloc as needed, for when the most it could hold is too big to set aside; caller has responsibility to free the array with release_stack before the pool is reset
+Stack* create_growing_stack(Pool *pool, unsigned int capacity)
+{
+    Stack *stack = pool_alloc(pool, sizeof(Stack));
     if (stack == NULL) {
-        fprintf(stderr, "Malloc returned null for stack array in create_stack\n");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Pool has no space for stack in create_growing_stack\n");
+        return NULL;
+    }
+
+    stack->capacity = capacity > 0 ? capacity : 1;
+    stack->top = -1;
+    stack->growable = 1;
+    stack->array = malloc(stack->capacity * sizeof(Coord));
+    if (stack->array == NULL) {
+        fprintf(stderr, "Malloc returned null in create_growing_stack\n");
+        return NULL;
     }
     return stack;
 }
 
+// this function frees the array of a growing stack; does nothing for a stack from the pool; accepts NULL
+void release_stack(Stack *stack)
+{
+    if (stack == NULL || !stack->growable) return;
+    free(stack->array);
+    stack->array = NULL;
+    stack->capacity = 0;
+    stack->top = -1;
+}
+
+// this function doubles the capacity of a growing stack, returning S_ERR_STACK if it cannot grow
+static Status grow_stack(Stack *stack)
+{
+    if (stack->capacity > INT_MAX/2) return S_ERR_STACK;
+    Coord *array = realloc(stack->array, 2 * (size_t)stack->capacity * sizeof(Coord));
+    if (array == NULL) {
+        fprintf(stderr, "Realloc returned null in grow_stack\n");
+        return S_ERR_STACK;
+    }
+    stack->array = array;
+    stack->capacity *= 2;
+    return S_OK;
+}
+
 // this function checks if the stack is full
 static int is_full(Stack *stack) 
 {
@@ -82,13 +168,14 @@ static int is_empty(Stack *stack)
 }
 
 // this function pushes a Coord onto the stack
-void push(Stack *stack, Coord coord) 
+Status push(Stack *stack, Coord coord) 
 {
-    if (is_full(stack)) {
+    if (is_full(stack) && (!stack->growable || grow_stack(stack) != S_OK)) {
         fprintf(stderr, "Stack overflow - cannot push Coord(%d, %d)\n", coord.x, coord.y);
-        exit(EXIT_FAILURE);
+        return S_ERR_STACK;
     }
     stack->array[++stack->top] = coord;
+    return S_OK;
 }
 
 // this function pops a Coord from the stack
@@ -113,9 +200,14 @@ Coord peek(Stack *stack)
     return stack->array[stack->top];
 }
 
-// this function frees the stack memory
-void free_stack(Stack *stack) 
+// this function returns the number of Coords on the stack
+int stack_size(Stack *stack) 
 {
-    free(stack->array);
-    free(stack);
+    return stack->top + 1;
+}
+
+// this function empties the stack so it can be reused
+void clear_stack(Stack *stack) 
+{
+    stack->top = -1;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+// This program compares the pure spiral against marker-directed search (a sensing radius) on the same seeds, reporting the robot's actions until all markers are found, and the shortest tour through the markers as a lower bound
+
+#include "../include/arena.h"
+#include "../include/simulation.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+// totals for one search mode over all the seeds of a formation
+typedef struct {
+    long moves;
+    long turns;
+    int finished;
+} ModeTotals;
+
+// this function returns a sensible number of obstacles for a formation on an arena of the given size
+static int obstacles_for_formation(ObstacleFormation formation, int width, int height)
+{
+    switch (formation) {
+        case O_RANDOM: return width*height/12;
+        case O_WALL: return height - 2;
+        case O_CAVERN_RANDOM: return width*height/24;
+        default: return 0;
+    }
+}
+
+// this function runs one simulation headless and adds its counts to the totals if every marker was found; returns its status
+static Status run_one(SimConfig *config, ModeTotals *totals)
+{
+    Simulation *sim;
+    Status status = sim_create(config, &sim);
+    if (status != S_OK) return status;
+
+    status = sim_run(sim);
+    if (status == S_OK) {
+        totals->moves += sim->robot->moveCount;
+        totals->turns += sim->robot->turnCount;
+        totals->finished++;
+    }
+    sim_destroy(sim);
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5) {
+        fprintf(stderr, "Usage: %s <width> <height> <seeds> <sense radius>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int width = atoi(argv[1]);
+    int height = atoi(argv[2]);
+    int numSeeds = atoi(argv[3]);
+    int senseRadius = atoi(argv[4]);
+
+    const char *names[] = {"none", "random", "wall", "cavern", "cavern_random"};
+    printf("formation      seeds  spiral_actions  directed_actions  saving  tour_actions\n");
+
+    for (ObstacleFormation formation = O_NONE; formation <= O_CAVERN_RANDOM; formation++) {
+        ModeTotals spiral = {0, 0, 0};
+        ModeTotals directed = {0, 0, 0};
+        ModeTotals tour = {0, 0, 0};
+        int compared = 0;
+
+        for (int seed = 1; seed <= numSeeds; seed++) {
+            SimConfig config;
+            default_sim_config(&config);
+            config.arenaWidth = width;
+            config.arenaHeight = height;
+            config.obstacleFormation = formation;
+            config.numObstacles = obstacles_for_formation(formation, width, height);
+            config.seed = seed;
+
+            // only count seeds where both modes found every marker so the totals cover the same arenas
+            ModeTotals spiralRun = {0, 0, 0};
+            ModeTotals directedRun = {0, 0, 0};
+            ModeTotals tourRun = {0, 0, 0};
+            if (run_one(&config, &spiralRun) != S_OK) continue;
+            config.senseRadius = senseRadius;
+            if (run_one(&config, &directedRun) != S_OK) continue;
+            config.senseRadius = 0;
+            config.knownArena = 1;
+            if (run_one(&config, &tourRun) != S_OK) continue;
+
+            spiral.moves += spiralRun.moves;
+            spiral.turns += spiralRun.turns;
+            directed.moves += directedRun.moves;
+            directed.turns += directedRun.turns;
+            tour.moves += tourRun.moves;
+            tour.turns += tourRun.turns;
+            compared++;
+        }
+
+        if (compared == 0) {
+            printf("%-14s %5d  %14s  %16s  %6s  %12s\n", names[formation], 0, "-", "-", "-", "-");
+            continue;
+        }
+        double spiralActions = (double)(spiral.moves + spiral.turns) / compared;
+        double directedActions = (double)(directed.moves + directed.turns) / compared;
+        double tourActions = (double)(tour.moves + tour.turns) / compared;
+        printf("%-14s %5d  %14.1f  %16.1f  %5.1f%%  %12.1f\n", names[formation], compared, spiralActions, directedActions, 100.0 * (1.0 - directedActions / spiralActions), tourActions);
+    }
+
+    return EXIT_SUCCESS;
+}
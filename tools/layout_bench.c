@@ -0,0 +1,191 @@
+// This program runs the same searches with each tile grid layout and reports, per action of the robot, the time taken and the cache misses, either counted by the CPU or modelled from every tile accessed when built with -DTILE_GRID_TRACE
+
+#include "../include/arena.h"
+#include "../include/simulation.h"
+#include "../include/tile_grid.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define MODEL_LINE_SHIFT 6 // 64 byte cache lines
+#define MAX_WAYS 16
+
+// a set associative cache with least recently used replacement, fed with the address of every tile accessed
+typedef struct {
+    int numSets;
+    int numWays;
+    uintptr_t tags[1 << 12][MAX_WAYS]; // tag + 1 so that 0 is an empty way, most recently used first
+    long long accesses;
+    long long misses;
+} CacheModel;
+
+// roughly the data caches of a desktop core
+static CacheModel l1 = {64, 8, {{0}}, 0, 0}; // 32KB
+static CacheModel l2 = {1024, 16, {{0}}, 0, 0}; // 1MB
+
+#ifdef TILE_GRID_TRACE
+// this function looks a line up in the cache, moving it to the front of its set and returning 1 if it was a miss
+static int cache_access(CacheModel *cache, uintptr_t line)
+{
+    uintptr_t *ways = cache->tags[line % cache->numSets];
+    uintptr_t tag = line / cache->numSets + 1;
+    cache->accesses++;
+
+    int found = cache->numWays - 1; // a miss replaces the least recently used way
+    for (int i = 0; i < cache->numWays; i++) {
+        if (ways[i] == tag) {
+            found = i;
+            break;
+        }
+    }
+    int miss = ways[found] != tag;
+    memmove(&ways[1], &ways[0], found * sizeof(uintptr_t));
+    ways[0] = tag;
+    cache->misses += miss;
+    return miss;
+}
+
+// this function is called by get_tile and set_tile with every tile accessed; the L2 only sees what missed in L1
+void tile_grid_trace(const void *address)
+{
+    uintptr_t line = (uintptr_t)address >> MODEL_LINE_SHIFT;
+    if (cache_access(&l1, line)) cache_access(&l2, line);
+}
+#endif
+
+// this function opens a counter of this thread's hardware cache misses; returns -1 if the CPU or kernel does not allow it
+static int open_miss_counter(unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// this function returns what a counter has counted so far, or 0 if it is not open
+static long long read_counter(int fd)
+{
+    long long count = 0;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+    return count;
+}
+
+// this function prints a count per action in a column of the given width, or - if it was not measured
+static void print_rate(long long count, double actions, int measured, int width)
+{
+    if (measured) printf("  %*.3f", width, count / actions);
+    else printf("  %*s", width, "-");
+}
+
+// totals for one layout over all the seeds
+typedef struct {
+    long long actions;
+    double seconds;
+    long long l1Misses; // counted by the CPU
+    long long llcMisses;
+    long long modelAccesses;
+    long long modelL1Misses;
+    long long modelL2Misses;
+    size_t gridBytes;
+    int finished;
+} LayoutTotals;
+
+// this function runs one simulation headless, timing and counting only the search, and adds it to the totals if every marker was found; returns its status
+static Status run_one(SimConfig *config, LayoutTotals *totals, int l1Counter, int llcCounter)
+{
+    Simulation *sim;
+    Status status = sim_create(config, &sim);
+    if (status != S_OK) return status;
+
+    // start every run with a cold model so layouts are compared on the same footing
+    memset(l1.tags, 0, sizeof(l1.tags));
+    memset(l2.tags, 0, sizeof(l2.tags));
+    long long accesses = l1.accesses, l1Misses = l1.misses, l2Misses = l2.misses;
+    long long l1Start = read_counter(l1Counter), llcStart = read_counter(llcCounter);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    status = sim_run(sim);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (status == S_OK) {
+        totals->actions += sim->robot->moveCount + sim->robot->turnCount;
+        totals->seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        totals->l1Misses += read_counter(l1Counter) - l1Start;
+        totals->llcMisses += read_counter(llcCounter) - llcStart;
+        totals->modelAccesses += l1.accesses - accesses;
+        totals->modelL1Misses += l1.misses - l1Misses;
+        totals->modelL2Misses += l2.misses - l2Misses;
+        totals->gridBytes = tile_grid_bytes(&sim->arena->arenaGrid) + tile_grid_bytes(&sim->robot->memory) + tile_grid_bytes(&sim->robot->visitCounts);
+        totals->finished++;
+    }
+    sim_destroy(sim);
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4 && argc != 5) {
+        fprintf(stderr, "Usage: %s <width> <height> <seeds> [formation 0-4]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int width = atoi(argv[1]);
+    int height = atoi(argv[2]);
+    int numSeeds = atoi(argv[3]);
+    ObstacleFormation formation = argc == 5 ? atoi(argv[4]) : O_RANDOM;
+
+    int l1Counter = open_miss_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    int llcCounter = open_miss_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    if (l1Counter < 0 && llcCounter < 0) fprintf(stderr, "Hardware cache counters are not available here, so only the modelled misses (built with -DTILE_GRID_TRACE) are shown\n");
+    if (l1Counter >= 0) ioctl(l1Counter, PERF_EVENT_IOC_ENABLE, 0);
+    if (llcCounter >= 0) ioctl(llcCounter, PERF_EVENT_IOC_ENABLE, 0);
+
+    printf("layout  seeds  actions/run  ns/action  l1_miss/action  llc_miss/action  model_tiles/action  model_l1_miss/action  model_l2_miss/action  grid_bytes\n");
+    GridLayout layouts[] = {G_DENSE, G_TILED, G_MORTON, G_SPARSE};
+    for (int i = 0; i < (int)(sizeof(layouts) / sizeof(layouts[0])); i++) {
+        LayoutTotals totals;
+        memset(&totals, 0, sizeof(totals));
+
+        for (int seed = 1; seed <= numSeeds; seed++) {
+            SimConfig config;
+            default_sim_config(&config);
+            config.arenaWidth = width;
+            config.arenaHeight = height;
+            config.obstacleFormation = formation;
+            config.numObstacles = formation == O_RANDOM ? width*height/12 : formation == O_WALL ? height - 2 : formation == O_CAVERN_RANDOM ? width*height/24 : 0;
+            config.seed = seed;
+            config.gridLayout = layouts[i];
+            run_one(&config, &totals, l1Counter, llcCounter);
+        }
+
+        if (totals.finished == 0 || totals.actions == 0) {
+            printf("%-7s %5d  %11s\n", grid_layout_name(layouts[i]), 0, "-");
+            continue;
+        }
+        double actions = (double)totals.actions;
+        printf("%-7s %5d  %11.0f  %9.1f", grid_layout_name(layouts[i]), totals.finished, actions / totals.finished, 1e9 * totals.seconds / actions);
+        print_rate(totals.l1Misses, actions, l1Counter >= 0, 14);
+        print_rate(totals.llcMisses, actions, llcCounter >= 0, 15);
+        print_rate(totals.modelAccesses, actions, totals.modelAccesses > 0, 18);
+        print_rate(totals.modelL1Misses, actions, totals.modelAccesses > 0, 20);
+        print_rate(totals.modelL2Misses, actions, totals.modelAccesses > 0, 20);
+        printf("  %10zu\n", totals.gridBytes);
+    }
+
+    if (l1Counter >= 0) close(l1Counter);
+    if (llcCounter >= 0) close(llcCounter);
+    return EXIT_SUCCESS;
+}
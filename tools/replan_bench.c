@@ -0,0 +1,257 @@
+// This program compares replanning routes from scratch with A* against repairing them with the incremental search (D* Lite): first on long routes across a known arena where obstacles keep appearing just ahead of the robot, then over whole searches in arenas whose obstacles appear and disappear while the robot is moving, reporting how long replanning and each action take
+
+#include "../include/arena.h"
+#include "../include/pathfind.h"
+#include "../include/robot.h"
+#include "../include/simulation.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define REPAIRS_PER_WALK 64 // obstacles put in the way of each walk at most
+
+// totals for one kind of replanning over all the runs
+typedef struct {
+    const char *name;
+    int incremental;
+    int found; // runs where every marker was found
+    long long actions;
+    double seconds;
+    double *stepSeconds; // time of every action of every run, for the percentiles
+    long long numSteps;
+    long long stepCapacity;
+} ReplanTotals;
+
+// totals for one kind of replanning over all the walks with obstacles put in their way
+typedef struct {
+    const char *name;
+    long long replans;
+    long long expansions;
+    double seconds;
+} RepairTotals;
+
+// this function returns the seconds since an arbitrary point, for timing actions
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// this function compares two times for qsort
+static int compare_seconds(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// this function compares two events by step for qsort
+static int compare_events(const void *a, const void *b)
+{
+    long long x = ((const ObstacleEvent*)a)->step;
+    long long y = ((const ObstacleEvent*)b)->step;
+    return (x > y) - (x < y);
+}
+
+// this function picks a random tile that is not an obstacle in the robot's memory
+static Coord random_open_tile(Rng *rng, Robot *robot)
+{
+    Coord tile;
+    do {
+        tile.x = random_coord(rng, robot->arenaWidth);
+        tile.y = random_coord(rng, robot->arenaHeight);
+    } while (get_tile(&robot->memory, tile.x, tile.y) == R_BLOCKED);
+    return tile;
+}
+
+// this function walks the robot's planner along a route from start to goal, a few tiles at a time, each time putting an obstacle on the route just ahead and timing the replan from there; the obstacles are taken away again at the end so every walk sees the same arena
+static void walk_with_repairs(Planner *planner, Robot *robot, Rng *rng, Coord start, Coord goal, RepairTotals *totals)
+{
+    Coord blocked[REPAIRS_PER_WALK];
+    int numBlocked = 0;
+    Status status = plan_route_to_tile(planner, &robot->memory, start, NORTH, goal);
+    while (status == S_OK && numBlocked < REPAIRS_PER_WALK) {
+        int moves = 1 + next_random(rng) % 8;
+        if (moves + 3 >= planner->routeLength) break; // nearly there
+        Coord pos = planner->route[moves - 1];
+        Coord ahead = planner->route[moves + 2];
+        set_tile(&robot->memory, ahead.x, ahead.y, R_BLOCKED);
+        planner_tile_blocked(planner, ahead.x, ahead.y);
+        blocked[numBlocked++] = ahead;
+
+        double begin = now_seconds();
+        status = plan_route_to_tile(planner, &robot->memory, pos, NORTH, goal);
+        totals->seconds += now_seconds() - begin;
+        totals->expansions += planner->expansions;
+        totals->replans++;
+    }
+
+    for (int i = 0; i < numBlocked; i++) {
+        set_tile(&robot->memory, blocked[i].x, blocked[i].y, R_UNKNOWN);
+        planner_tile_opened(planner, blocked[i].x, blocked[i].y);
+    }
+}
+
+// this function prints a row of the cost of each replan for one kind of replanning
+static void print_repairs(RepairTotals *totals)
+{
+    long long replans = totals->replans > 0 ? totals->replans : 1;
+    printf("%-12s %8lld  %17.1f  %9.1f\n", totals->name, totals->replans, (double)totals->expansions / replans, 1e6 * totals->seconds / replans);
+}
+
+// this function times replanning with and without the incremental search on walks between far apart tiles of a known arena; returns the status of setting up the arena
+static Status run_route_repairs(SimConfig config, int numWalks)
+{
+    config.senseRadius = 1; // so the robot has a planner
+    config.incrementalRoutes = 1;
+    Simulation *sim;
+    Status status = sim_create(&config, &sim);
+    if (status != S_OK) return status;
+    Robot *robot = sim->robot;
+    Planner *planner = robot->planner;
+    DStar *dstar = planner->dstar;
+    learn_arena_obstacles(robot, sim->arena);
+
+    RepairTotals totals[2] = {{"astar", 0, 0, 0}, {"incremental", 0, 0, 0}};
+    for (int i = 0; i < 2; i++) {
+        planner->dstar = i == 1 ? dstar : NULL;
+        Rng rng;
+        seed_rng(&rng, 1); // the same walks for both
+        for (int walk = 0; walk < numWalks; walk++) {
+            Coord start, goal;
+            do {
+                start = random_open_tile(&rng, robot);
+                goal = random_open_tile(&rng, robot);
+            } while (abs(start.x - goal.x) + abs(start.y - goal.y) < (config.arenaWidth + config.arenaHeight) / 2);
+            walk_with_repairs(planner, robot, &rng, start, goal, &totals[i]);
+        }
+    }
+
+    printf("%d x %d arena, %d walks with an obstacle put just ahead every few tiles\n", config.arenaWidth, config.arenaHeight, numWalks);
+    printf("replanning    replans  expansions/replan  us/replan\n");
+    print_repairs(&totals[0]);
+    print_repairs(&totals[1]);
+    sim_destroy(sim);
+    return S_OK;
+}
+
+// this function scripts doors that close on a random tile and open again a while later, changesPer100 of them per hundred actions until the horizon; returns how many events it wrote
+static int generate_doors(Rng *rng, ObstacleEvent *events, int width, int height, long long horizon, int changesPer100)
+{
+    int numEvents = 0;
+    int numDoors = (int)(horizon * changesPer100 / 100);
+    for (int i = 0; i < numDoors; i++) {
+        long long step = next_random(rng) % horizon;
+        int x = random_coord(rng, width);
+        int y = random_coord(rng, height);
+        events[numEvents++] = (ObstacleEvent){step, x, y, 1};
+        events[numEvents++] = (ObstacleEvent){step + 20 + next_random(rng) % 200, x, y, 0};
+    }
+    qsort(events, numEvents, sizeof(ObstacleEvent), compare_events);
+    return numEvents;
+}
+
+// this function runs one simulation to the end, timing every action into the totals; returns its status
+static Status run_timed(const SimConfig *config, ReplanTotals *totals)
+{
+    Simulation *sim;
+    Status status = sim_create(config, &sim);
+    if (status != S_OK) return status;
+
+    double begin = now_seconds();
+    do {
+        double start = now_seconds();
+        status = sim_step(sim);
+        double taken = now_seconds() - start;
+        if (totals->numSteps == totals->stepCapacity) { // double the array as actions are taken
+            totals->stepCapacity = totals->stepCapacity == 0 ? 1 << 16 : 2*totals->stepCapacity;
+            double *grown = realloc(totals->stepSeconds, totals->stepCapacity * sizeof(double));
+            if (grown == NULL) {
+                fprintf(stderr, "Realloc returned null in run_timed\n");
+                sim_destroy(sim);
+                return S_ERR_ALLOC;
+            }
+            totals->stepSeconds = grown;
+        }
+        totals->stepSeconds[totals->numSteps++] = taken;
+    } while (status == S_OK);
+    totals->seconds += now_seconds() - begin;
+
+    totals->actions += sim->robot->moveCount + sim->robot->turnCount;
+    if (status == S_DONE) totals->found++;
+    sim_destroy(sim);
+    return status == S_DONE ? S_OK : status;
+}
+
+// this function prints a row of the time per action for one kind of replanning
+static void print_totals(ReplanTotals *totals, int numRuns)
+{
+    qsort(totals->stepSeconds, totals->numSteps, sizeof(double), compare_seconds);
+    double p99 = totals->numSteps == 0 ? 0 : totals->stepSeconds[(long long)(0.99 * (totals->numSteps - 1))];
+    double worst = totals->numSteps == 0 ? 0 : totals->stepSeconds[totals->numSteps - 1];
+    printf("%-12s %5d/%-5d  %12.0f  %10.2f  %9.2f  %9.1f\n", totals->name, totals->found, numRuns, (double)totals->actions / numRuns,
+        totals->numSteps == 0 ? 0.0 : 1e6 * totals->seconds / totals->numSteps, 1e6 * p99, 1e6 * worst);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || argc > 6) {
+        fprintf(stderr, "Usage: %s <width> <height> <seeds> [doors closing per 100 actions] [sense radius]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    SimConfig config;
+    default_sim_config(&config);
+    config.arenaWidth = atoi(argv[1]);
+    config.arenaHeight = atoi(argv[2]);
+    int numSeeds = atoi(argv[3]);
+    int changesPer100 = argc >= 5 ? atoi(argv[4]) : 5;
+    config.senseRadius = argc >= 6 ? atoi(argv[5]) : 4;
+    config.obstacleFormation = O_RANDOM;
+    config.numObstacles = config.arenaWidth*config.arenaHeight/8;
+    config.numMarkers = 8;
+
+    // the robot takes about three actions per tile, so events are scripted well past the end of most runs
+    long long horizon = 8LL * config.arenaWidth * config.arenaHeight;
+    ObstacleEvent *events = malloc((2 * (horizon * changesPer100 / 100) + 1) * sizeof(ObstacleEvent));
+    if (events == NULL) {
+        fprintf(stderr, "Malloc returned null for events\n");
+        return EXIT_FAILURE;
+    }
+
+    Status status = run_route_repairs(config, numSeeds);
+    if (status != S_OK) {
+        fprintf(stderr, "Could not set up arena: %s\n", status_string(status));
+        free(events);
+        return EXIT_FAILURE;
+    }
+
+    ReplanTotals totals[2] = {{"astar", 0, 0, 0, 0, NULL, 0, 0}, {"incremental", 1, 0, 0, 0, NULL, 0, 0}};
+    int failed = 0;
+    for (int seed = 1; seed <= numSeeds; seed++) {
+        Rng rng;
+        seed_rng(&rng, seed);
+        config.seed = seed;
+        config.obstacleEvents = events;
+        config.numObstacleEvents = generate_doors(&rng, events, config.arenaWidth, config.arenaHeight, horizon, changesPer100);
+        for (int i = 0; i < 2; i++) {
+            config.incrementalRoutes = totals[i].incremental;
+            Status status = run_timed(&config, &totals[i]);
+            if (status != S_OK && status != S_ERR_UNREACHABLE) { // markers can be shut in for good by a door that never opens within the run
+                fprintf(stderr, "Seed %d stopped: %s\n", seed, status_string(status));
+                failed = 1;
+            }
+        }
+    }
+
+    printf("\n%d x %d arena, %d doors closing per 100 actions, sense radius %d\n", config.arenaWidth, config.arenaHeight, changesPer100, config.senseRadius);
+    printf("replanning   found        actions/run  us/action  p99 us     max us\n");
+    for (int i = 0; i < 2; i++) {
+        print_totals(&totals[i], numSeeds);
+        free(totals[i].stepSeconds);
+    }
+    free(events);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
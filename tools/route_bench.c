@@ -0,0 +1,181 @@
+// This program compares route searches (breadth first, A*, jump point search and the hierarchy) over the robot's memory on long routes across an arena the robot knows, reporting how many nodes each expands, how long each takes and how long its routes are, while new obstacles are found between routes
+
+#include "../include/arena.h"
+#include "../include/hierarchy.h"
+#include "../include/jump_grid.h"
+#include "../include/pathfind.h"
+#include "../include/robot.h"
+#include "../include/simulation.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+// totals for one kind of search over all the routes
+typedef struct {
+    const char *name;
+    long long expansions;
+    long long routeMoves;
+    double seconds;
+    int found;
+} SearchTotals;
+
+// this function returns the seconds since an arbitrary point, for timing searches
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// this function picks a random tile that is not an obstacle in the robot's memory
+static Coord random_open_tile(Rng *rng, Robot *robot)
+{
+    Coord tile;
+    do {
+        tile.x = random_coord(rng, robot->arenaWidth);
+        tile.y = random_coord(rng, robot->arenaHeight);
+    } while (get_tile(&robot->memory, tile.x, tile.y) == R_BLOCKED);
+    return tile;
+}
+
+// this function runs a plain breadth first search from start to goal over the robot's memory as a baseline, using the planner's arrays, and adds it to the totals; returns its status
+static Status run_bfs(Planner *planner, Robot *robot, Coord start, Coord goal, SearchTotals *totals)
+{
+    int width = planner->width;
+    int *queue = planner->parent; // the tiles in the order they were reached
+    int *dist = planner->cost;
+    double begin = now_seconds();
+
+    planner->searchId++;
+    int head = 0;
+    int tail = 0;
+    int startTile = start.y*width + start.x;
+    planner->searchMark[startTile] = planner->searchId;
+    dist[startTile] = 0;
+    queue[tail++] = startTile;
+    Status status = S_ERR_UNREACHABLE;
+    while (head < tail) {
+        int tile = queue[head++];
+        Coord coord = {tile % width, tile / width};
+        totals->expansions++;
+        if (coord.x == goal.x && coord.y == goal.y) {
+            totals->routeMoves += dist[tile];
+            totals->found++;
+            status = S_OK;
+            break;
+        }
+        for (Direction dir = NORTH; dir <= WEST; dir++) {
+            Coord next = {coord.x + (dir == EAST) - (dir == WEST), coord.y + (dir == SOUTH) - (dir == NORTH)};
+            if (!check_coord_in_bounds(next, width, planner->height) || get_tile(&robot->memory, next.x, next.y) == R_BLOCKED) continue;
+            int nextTile = next.y*width + next.x;
+            if (planner->searchMark[nextTile] == planner->searchId) continue;
+            planner->searchMark[nextTile] = planner->searchId;
+            dist[nextTile] = dist[tile] + 1;
+            queue[tail++] = nextTile;
+        }
+    }
+    totals->seconds += now_seconds() - begin;
+    return status;
+}
+
+// this function times one route search with the given hierarchy and jump grid (either may be NULL) and adds it to the totals; returns its status
+static Status run_search(Planner *planner, Hierarchy *hierarchy, JumpGrid *jumpGrid, Robot *robot, Coord start, Coord goal, SearchTotals *totals)
+{
+    planner->hierarchy = hierarchy;
+    planner->jumpGrid = jumpGrid;
+    double begin = now_seconds();
+    Status status = plan_route_to_tile(planner, &robot->memory, start, NORTH, goal);
+    totals->seconds += now_seconds() - begin;
+    totals->expansions += planner->expansions;
+    if (status == S_OK) {
+        totals->routeMoves += planner->routeLength;
+        totals->found++;
+    }
+    return status;
+}
+
+// this function prints a row of averages per route for one kind of search
+static void print_totals(SearchTotals *totals, int numRoutes, long long shortestMoves)
+{
+    printf("%-13s %6d  %16.1f  %8.1f  %13.2f%%\n", totals->name, totals->found, (double)totals->expansions / numRoutes, 1e6 * totals->seconds / numRoutes,
+        shortestMoves == 0 ? 0.0 : 100.0 * (totals->routeMoves - shortestMoves) / shortestMoves);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || argc > 6) {
+        fprintf(stderr, "Usage: %s <width> <height> <routes> [formation 0-4] [obstacles found between routes]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    SimConfig config;
+    default_sim_config(&config);
+    config.arenaWidth = atoi(argv[1]);
+    config.arenaHeight = atoi(argv[2]);
+    int numRoutes = atoi(argv[3]);
+    config.obstacleFormation = argc >= 5 ? atoi(argv[4]) : O_RANDOM;
+    int newObstacles = argc >= 6 ? atoi(argv[5]) : 0;
+    config.numObstacles = config.obstacleFormation == O_RANDOM ? config.arenaWidth*config.arenaHeight/6 : config.obstacleFormation == O_WALL ? config.arenaHeight - 2 : config.obstacleFormation == O_CAVERN_RANDOM ? config.arenaWidth*config.arenaHeight/24 : 0;
+    config.senseRadius = 1; // so the robot has a planner
+    config.hierarchicalRoutes = 1;
+    config.jumpPointRoutes = 1;
+
+    Simulation *sim;
+    Status status = sim_create(&config, &sim);
+    if (status != S_OK) {
+        fprintf(stderr, "Could not set up simulation: %s\n", status_string(status));
+        return EXIT_FAILURE;
+    }
+    Robot *robot = sim->robot;
+    Planner *planner = robot->planner;
+    Hierarchy *hierarchy = planner->hierarchy;
+    JumpGrid *jumpGrid = planner->jumpGrid;
+    learn_arena_obstacles(robot, sim->arena);
+
+    // the first route through the hierarchy works out the sectors it searches into
+    Rng rng;
+    seed_rng(&rng, 1);
+    SearchTotals build = {"build", 0, 0, 0, 0};
+    run_search(planner, hierarchy, NULL, robot, random_open_tile(&rng, robot), random_open_tile(&rng, robot), &build);
+    printf("%d x %d arena, %lld of %d sectors worked out in %.1f ms\n", config.arenaWidth, config.arenaHeight, hierarchy->rebuiltSectors, hierarchy->numSectors, 1e3 * build.seconds);
+
+    SearchTotals bfs = {"bfs", 0, 0, 0, 0};
+    SearchTotals astar = {"astar", 0, 0, 0, 0};
+    SearchTotals jps = {"jump_point", 0, 0, 0, 0};
+    SearchTotals hpa = {"hierarchical", 0, 0, 0, 0};
+    long long rebuiltBefore = hierarchy->rebuiltSectors;
+    int mismatches = 0;
+    for (int i = 0; i < numRoutes; i++) {
+        // obstacles found since the last route, which the hierarchy has to catch up with
+        for (int j = 0; j < newObstacles; j++) {
+            Coord tile = random_open_tile(&rng, robot);
+            set_tile(&robot->memory, tile.x, tile.y, R_BLOCKED);
+            planner->hierarchy = hierarchy;
+            planner->jumpGrid = jumpGrid;
+            planner_tile_blocked(planner, tile.x, tile.y);
+        }
+
+        Coord start, goal;
+        do {
+            start = random_open_tile(&rng, robot);
+            goal = random_open_tile(&rng, robot);
+        } while (abs(start.x - goal.x) + abs(start.y - goal.y) < HIERARCHY_MIN_DISTANCE);
+
+        Status bfsStatus = run_bfs(planner, robot, start, goal, &bfs);
+        Status flatStatus = run_search(planner, NULL, NULL, robot, start, goal, &astar);
+        Status jpsStatus = run_search(planner, NULL, jumpGrid, robot, start, goal, &jps);
+        Status hpaStatus = run_search(planner, hierarchy, NULL, robot, start, goal, &hpa);
+        if (flatStatus != bfsStatus || flatStatus != jpsStatus || flatStatus != hpaStatus) mismatches++;
+    }
+
+    printf("search         found  expansions/route  us/route  longer than A*\n");
+    print_totals(&bfs, numRoutes, astar.routeMoves);
+    print_totals(&astar, numRoutes, astar.routeMoves);
+    print_totals(&jps, numRoutes, astar.routeMoves);
+    print_totals(&hpa, numRoutes, astar.routeMoves);
+    printf("%.1f sectors worked out per route, %d routes found by only one search\n", (double)(hierarchy->rebuiltSectors - rebuiltBefore) / numRoutes, mismatches);
+
+    sim_destroy(sim);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
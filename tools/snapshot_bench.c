@@ -0,0 +1,117 @@
+// This program takes snapshots part way through searches, restores each one and runs both the original and the restored simulation to the end, checking they finish in exactly the same state, and reports how big the snapshots are and how long taking and restoring them takes against simulating the run up to that point again
+
+#include "../include/simulation.h"
+#include "../include/snapshot.h"
+#include "../include/utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// this function returns the seconds since an arbitrary point, for timing snapshots
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// this function checks if two snapshots hold exactly the same bytes
+static int same_snapshot(const Snapshot *a, const Snapshot *b)
+{
+    return a->size == b->size && memcmp(a->data, b->data, a->size) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || argc > 6) {
+        fprintf(stderr, "Usage: %s <width> <height> <seeds> [snapshots per run] [layout]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    SimConfig config;
+    default_sim_config(&config);
+    config.arenaWidth = atoi(argv[1]);
+    config.arenaHeight = atoi(argv[2]);
+    int numSeeds = atoi(argv[3]);
+    int perRun = argc >= 5 ? atoi(argv[4]) : 3;
+    if (argc >= 6 && !parse_grid_layout(argv[5], &config.gridLayout)) {
+        fprintf(stderr, "Unknown layout %s\n", argv[5]);
+        return EXIT_FAILURE;
+    }
+    config.obstacleFormation = O_RANDOM;
+    config.numObstacles = config.arenaWidth*config.arenaHeight/8;
+    config.numMarkers = 8;
+    config.senseRadius = 4;
+
+    Snapshot snapshot = {NULL, 0, 0};
+    Snapshot original = {NULL, 0, 0};
+    Snapshot restored = {NULL, 0, 0};
+    long long numSnapshots = 0;
+    double totalBytes = 0;
+    double takeSeconds = 0;
+    double restoreSeconds = 0;
+    double prefixSeconds = 0;
+    int mismatches = 0;
+    for (int seed = 1; seed <= numSeeds; seed++) {
+        config.seed = seed;
+
+        // count the actions of the whole run so the snapshots can be spread along it
+        Simulation *sim;
+        Status status = sim_create(&config, &sim);
+        if (status != S_OK) {
+            fprintf(stderr, "Could not set up seed %d: %s\n", seed, status_string(status));
+            return EXIT_FAILURE;
+        }
+        long long numActions = 0;
+        while (sim_step(sim) == S_OK) numActions++;
+        sim_destroy(sim);
+
+        for (int i = 1; i <= perRun; i++) {
+            long long at = numActions * i / (perRun + 1);
+            double begin = now_seconds();
+            sim_create(&config, &sim);
+            for (long long action = 0; action < at; action++) sim_step(sim);
+            prefixSeconds += now_seconds() - begin;
+
+            begin = now_seconds();
+            status = take_snapshot(sim, &snapshot);
+            takeSeconds += now_seconds() - begin;
+            Simulation *fork = NULL;
+            begin = now_seconds();
+            if (status == S_OK) status = sim_restore(&snapshot, NULL, &fork);
+            restoreSeconds += now_seconds() - begin;
+            if (status != S_OK) {
+                fprintf(stderr, "Could not snapshot seed %d: %s\n", seed, status_string(status));
+                sim_destroy(sim);
+                free_snapshot(&snapshot);
+                return EXIT_FAILURE;
+            }
+            numSnapshots++;
+            totalBytes += snapshot.size;
+
+            // both carry on to the end, which must leave them the same
+            while (sim_step(sim) == S_OK);
+            while (sim_step(fork) == S_OK);
+            if (take_snapshot(sim, &original) != S_OK || take_snapshot(fork, &restored) != S_OK || !same_snapshot(&original, &restored)) {
+                fprintf(stderr, "Seed %d restored after %lld actions finished differently\n", seed, at);
+                mismatches++;
+            }
+            sim_destroy(sim);
+            sim_destroy(fork);
+        }
+    }
+
+    long long numTiles = (long long)config.arenaWidth * config.arenaHeight;
+    printf("%d x %d arena (%s), %lld snapshots over %d seeds\n", config.arenaWidth, config.arenaHeight, grid_layout_name(config.gridLayout), numSnapshots, numSeeds);
+    printf("snapshot size    %10.0f bytes (%.2f bits per tile)\n", totalBytes / numSnapshots, 8 * totalBytes / numSnapshots / numTiles);
+    printf("take             %10.1f us\n", 1e6 * takeSeconds / numSnapshots);
+    printf("restore          %10.1f us\n", 1e6 * restoreSeconds / numSnapshots);
+    printf("simulate prefix  %10.1f us\n", 1e6 * prefixSeconds / numSnapshots);
+    printf("%d restored runs finished differently\n", mismatches);
+
+    free_snapshot(&snapshot);
+    free_snapshot(&original);
+    free_snapshot(&restored);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,425 @@
+// This program runs the search headless over every combination of a range of settings, spread across threads, and writes a CSV of how each run went
+
+#include "../include/arena.h"
+#include "../include/heatmap.h"
+#include "../include/simulation.h"
+#include "../include/utils.h"
+#include "work_deque.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// an inclusive range of values stepped through by the sweep
+typedef struct {
+    double min;
+    double max;
+    double step;
+} Range;
+
+// every setting of the sweep, read from key=value arguments
+typedef struct {
+    Range size; // square arena width and height
+    Range density; // fraction of tiles that are obstacles, or of the arena height a wall covers
+    int formations[5];
+    int numFormations;
+    Range markers;
+    int numSeeds;
+    int numThreads;
+    int senseRadius;
+    int turnAwareRoutes;
+    int knownArena;
+    int carryCapacity;
+    int hierarchicalRoutes;
+    int jumpPointRoutes;
+    int incrementalRoutes;
+    const char *eventsPath; // obstacle events applied to every run, or NULL for none
+    ObstacleEvent *events;
+    int numEvents;
+    GridLayout layout;
+    const char *outPath;
+} SweepSettings;
+
+// one run of the sweep and what happened in it
+typedef struct {
+    SimConfig config;
+    Status status;
+    int moves;
+    int turns;
+    int knownTiles;
+    int markersFound; // picked up, whether or not they have been delivered
+    int trips; // times markers were dropped off at the depot
+    int maxVisits; // most times one tile was moved onto
+    int revisits; // moves onto a tile already moved onto
+    long elapsedMicros;
+} Job;
+
+struct Batch;
+
+// a worker thread with its own deque of jobs, which other workers steal from once theirs are empty
+typedef struct {
+    WorkDeque deque;
+    Rng rng; // picks which worker to steal from first
+    int jobsRun;
+    int steals;
+    struct Batch *batch;
+} Worker;
+
+// all of the jobs and the workers running them
+typedef struct Batch {
+    Job *jobs;
+    int numJobs;
+    Worker *workers;
+    int numWorkers;
+} Batch;
+
+// functions for reading the arguments:
+
+// this function reads a range given as MIN:MAX:STEP or a single value, returning 0 if it is not valid
+static int parse_range(const char *text, Range *range)
+{
+    int count = sscanf(text, "%lf:%lf:%lf", &range->min, &range->max, &range->step);
+    if (count == 1) {
+        range->max = range->min;
+        range->step = 1;
+        return 1;
+    }
+    return count == 3 && range->step > 0 && range->max >= range->min;
+}
+
+// this function reads a comma separated list of obstacle formations, returning 0 if it is not valid
+static int parse_formations(const char *text, SweepSettings *settings)
+{
+    settings->numFormations = 0;
+    const char *pos = text;
+    while (*pos != '\0') {
+        int formation = atoi(pos);
+        if (formation < O_NONE || formation > O_CAVERN_RANDOM || settings->numFormations == 5) return 0;
+        settings->formations[settings->numFormations++] = formation;
+        pos = strchr(pos, ',');
+        if (pos == NULL) break;
+        pos++;
+    }
+    return settings->numFormations > 0;
+}
+
+// this function fills the settings from key=value arguments, returning 0 if any are not valid
+static int parse_settings(int argc, char *argv[], SweepSettings *settings)
+{
+    // defaults
+    parse_range("16", &settings->size);
+    parse_range("0:0.2:0.05", &settings->density);
+    parse_formations("0,1,2,3,4", settings);
+    parse_range("8", &settings->markers);
+    settings->numSeeds = 20;
+    settings->numThreads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    settings->senseRadius = 0;
+    settings->turnAwareRoutes = 0;
+    settings->knownArena = 0;
+    settings->carryCapacity = 0;
+    settings->hierarchicalRoutes = 0;
+    settings->jumpPointRoutes = 0;
+    settings->incrementalRoutes = 0;
+    settings->eventsPath = NULL;
+    settings->events = NULL;
+    settings->numEvents = 0;
+    settings->layout = G_DENSE;
+    settings->outPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        char *value = strchr(argv[i], '=');
+        if (value == NULL) return 0;
+        *value++ = '\0';
+        const char *key = argv[i];
+
+        int valid = 1;
+        if (strcmp(key, "size") == 0) valid = parse_range(value, &settings->size);
+        else if (strcmp(key, "density") == 0) valid = parse_range(value, &settings->density);
+        else if (strcmp(key, "formations") == 0) valid = parse_formations(value, settings);
+        else if (strcmp(key, "markers") == 0) valid = parse_range(value, &settings->markers);
+        else if (strcmp(key, "seeds") == 0) valid = (settings->numSeeds = atoi(value)) > 0;
+        else if (strcmp(key, "threads") == 0) valid = (settings->numThreads = atoi(value)) > 0;
+        else if (strcmp(key, "radius") == 0) settings->senseRadius = atoi(value);
+        else if (strcmp(key, "turnaware") == 0) settings->turnAwareRoutes = atoi(value);
+        else if (strcmp(key, "known") == 0) settings->knownArena = atoi(value);
+        else if (strcmp(key, "capacity") == 0) valid = (settings->carryCapacity = atoi(value)) >= 0;
+        else if (strcmp(key, "hierarchical") == 0) settings->hierarchicalRoutes = atoi(value);
+        else if (strcmp(key, "jump") == 0) settings->jumpPointRoutes = atoi(value);
+        else if (strcmp(key, "incremental") == 0) settings->incrementalRoutes = atoi(value);
+        else if (strcmp(key, "events") == 0) settings->eventsPath = value;
+        else if (strcmp(key, "layout") == 0) valid = parse_grid_layout(value, &settings->layout);
+        else if (strcmp(key, "out") == 0) settings->outPath = value;
+        else valid = 0;
+
+        if (!valid) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// functions for building and running the jobs:
+
+// this function returns the number of values in a range
+static int range_count(Range range)
+{
+    return (int)((range.max - range.min) / range.step + 1e-9) + 1;
+}
+
+// this function returns the ith value of a range
+static double range_value(Range range, int i)
+{
+    return range.min + i*range.step;
+}
+
+// this function fills in one job per combination of the settings, returning the array or NULL if malloc fails; caller has responsibility to free
+static Job* build_jobs(SweepSettings *settings, int *numJobs)
+{
+    int numSizes = range_count(settings->size);
+    int numDensities = range_count(settings->density);
+    int numMarkerCounts = range_count(settings->markers);
+    *numJobs = numSizes * numDensities * settings->numFormations * numMarkerCounts * settings->numSeeds;
+
+    Job *jobs = malloc(*numJobs * sizeof(Job));
+    if (jobs == NULL) {
+        fprintf(stderr, "Malloc returned null in build_jobs\n");
+        return NULL;
+    }
+
+    int job = 0;
+    for (int s = 0; s < numSizes; s++) {
+        for (int d = 0; d < numDensities; d++) {
+            for (int f = 0; f < settings->numFormations; f++) {
+                for (int m = 0; m < numMarkerCounts; m++) {
+                    for (int seed = 1; seed <= settings->numSeeds; seed++) {
+                        SimConfig *config = &jobs[job++].config;
+                        default_sim_config(config);
+                        config->arenaWidth = (int)range_value(settings->size, s);
+                        config->arenaHeight = config->arenaWidth;
+                        config->obstacleFormation = settings->formations[f];
+                        config->numObstacles = (int)(range_value(settings->density, d) * config->arenaWidth * config->arenaHeight);
+                        if (config->obstacleFormation == O_WALL) { // a single wall cannot reach the top, so scale it by the height instead
+                            config->numObstacles = min((int)(range_value(settings->density, d) * config->arenaHeight), config->arenaHeight - 1);
+                        }
+                        config->numMarkers = (int)range_value(settings->markers, m);
+                        config->seed = seed;
+                        config->senseRadius = settings->senseRadius;
+                        config->turnAwareRoutes = settings->turnAwareRoutes;
+                        config->knownArena = settings->knownArena;
+                        config->carryCapacity = settings->carryCapacity;
+                        config->hierarchicalRoutes = settings->hierarchicalRoutes;
+                        config->jumpPointRoutes = settings->jumpPointRoutes;
+                        config->incrementalRoutes = settings->incrementalRoutes;
+                        config->obstacleEvents = settings->events;
+                        config->numObstacleEvents = settings->numEvents;
+                        config->gridLayout = settings->layout;
+                    }
+                }
+            }
+        }
+    }
+    return jobs;
+}
+
+// this function returns the microseconds since an arbitrary fixed point, for timing runs
+static long now_micros()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec*1000000L + time.tv_nsec/1000;
+}
+
+// this function runs one job, reusing the worker's simulation (and so its pool) when there is one
+static void run_job(Job *job, Simulation **sim)
+{
+    long start = now_micros();
+    if (*sim == NULL) {
+        job->status = sim_create(&job->config, sim);
+    }
+    else {
+        job->status = sim_reset(*sim, &job->config);
+    }
+    int setUp = job->status == S_OK; // otherwise the simulation may still hold the last job's robot
+    if (setUp) job->status = sim_run(*sim);
+    job->elapsedMicros = now_micros() - start;
+
+    job->moves = 0;
+    job->turns = 0;
+    job->knownTiles = 0;
+    job->markersFound = 0;
+    job->trips = 0;
+    job->maxVisits = 0;
+    job->revisits = 0;
+    if (setUp) {
+        job->moves = (*sim)->robot->moveCount;
+        job->turns = (*sim)->robot->turnCount;
+        job->knownTiles = (*sim)->robot->knownTiles;
+        job->markersFound = (*sim)->robot->markerCount + (*sim)->arena->numDelivered;
+        job->trips = (*sim)->robot->trips;
+        job->maxVisits = max_visit_count((*sim)->robot);
+        job->revisits = revisit_count((*sim)->robot);
+    }
+}
+
+// this function steals a job from another worker, starting from a random one, returning WD_EMPTY once every other deque is empty
+static int steal_job(Worker *self)
+{
+    Batch *batch = self->batch;
+    int aborted;
+    do {
+        aborted = 0;
+        int first = next_random(&self->rng) % batch->numWorkers;
+        for (int i = 0; i < batch->numWorkers; i++) {
+            Worker *victim = &batch->workers[(first + i) % batch->numWorkers];
+            if (victim == self) continue;
+
+            int job = work_deque_steal(&victim->deque);
+            if (job >= 0) {
+                self->steals++;
+                return job;
+            }
+            if (job == WD_ABORT) aborted = 1;
+        }
+    } while (aborted); // no jobs are added once the workers start, so only give up when every deque was seen empty
+
+    return WD_EMPTY;
+}
+
+// this function is run by each worker thread, running jobs from its own deque and then stealing until there are none left
+static void* worker(void *arg)
+{
+    Worker *self = arg;
+    Simulation *sim = NULL;
+    while (1) {
+        int job = work_deque_take(&self->deque);
+        if (job == WD_EMPTY) job = steal_job(self);
+        if (job == WD_EMPTY) break;
+
+        run_job(&self->batch->jobs[job], &sim);
+        self->jobsRun++;
+    }
+    sim_destroy(sim);
+    return NULL;
+}
+
+// this function creates the workers and deals the jobs out to their deques in contiguous blocks, returning 0 on failure; jobs next to each other have similar settings, so the blocks are uneven on purpose and stealing evens them out
+static int setup_workers(Batch *batch, int numWorkers)
+{
+    batch->numWorkers = numWorkers;
+    batch->workers = malloc(numWorkers * sizeof(Worker));
+    if (batch->workers == NULL) {
+        fprintf(stderr, "Malloc returned null in setup_workers\n");
+        return 0;
+    }
+
+    int blockSize = (batch->numJobs + numWorkers - 1) / numWorkers;
+    for (int i = 0; i < numWorkers; i++) {
+        Worker *worker = &batch->workers[i];
+        worker->batch = batch;
+        worker->jobsRun = 0;
+        worker->steals = 0;
+        seed_rng(&worker->rng, i + 1);
+        if (!create_work_deque(&worker->deque, blockSize)) {
+            for (int j = 0; j < i; j++) free_work_deque(&batch->workers[j].deque);
+            free(batch->workers);
+            return 0;
+        }
+
+        // pushed in reverse so the owner takes its block in order
+        int first = i*blockSize;
+        int last = first + blockSize < batch->numJobs ? first + blockSize : batch->numJobs;
+        for (int job = last - 1; job >= first; job--) work_deque_push(&worker->deque, job);
+    }
+    return 1;
+}
+
+// this function frees the workers and their deques
+static void free_workers(Batch *batch)
+{
+    for (int i = 0; i < batch->numWorkers; i++) free_work_deque(&batch->workers[i].deque);
+    free(batch->workers);
+}
+
+// this function writes one CSV row per job, in the order the jobs were built
+static void write_csv(FILE *out, Job *jobs, int numJobs)
+{
+    fprintf(out, "width,height,formation,obstacles,markers,seed,sense_radius,turn_aware,known_arena,carry_capacity,status,moves,turns,actions,known_tiles,coverage,markers_found,trips,max_visits,revisits,micros\n");
+    for (int i = 0; i < numJobs; i++) {
+        Job *job = &jobs[i];
+        SimConfig *config = &job->config;
+        int numTiles = config->arenaWidth * config->arenaHeight;
+        fprintf(out, "%d,%d,%d,%d,%d,%u,%d,%d,%d,%d,%s,%d,%d,%d,%d,%.4f,%d,%d,%d,%d,%ld\n",
+            config->arenaWidth, config->arenaHeight, config->obstacleFormation, config->numObstacles, config->numMarkers, config->seed,
+            config->senseRadius, config->turnAwareRoutes, config->knownArena, config->carryCapacity, status_string(job->status),
+            job->moves, job->turns, job->moves + job->turns, job->knownTiles, (double)job->knownTiles / numTiles, job->markersFound, job->trips, job->maxVisits, job->revisits, job->elapsedMicros);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    SweepSettings settings;
+    if (!parse_settings(argc, argv, &settings)) {
+        fprintf(stderr, "Usage: %s [size=MIN:MAX:STEP] [density=MIN:MAX:STEP] [formations=0,1,...] [markers=MIN:MAX:STEP] [seeds=N] [threads=N] [radius=N] [turnaware=0|1] [known=0|1] [capacity=N] [hierarchical=0|1] [jump=0|1] [incremental=0|1] [events=FILE] [layout=dense|sparse|tiled|morton] [out=FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (settings.eventsPath != NULL) {
+        Status status = load_obstacle_events(settings.eventsPath, &settings.events, &settings.numEvents);
+        if (status != S_OK) {
+            fprintf(stderr, "Could not load obstacle events from %s: %s\n", settings.eventsPath, status_string(status));
+            return EXIT_FAILURE;
+        }
+    }
+
+    Batch batch;
+    batch.jobs = build_jobs(&settings, &batch.numJobs);
+    if (batch.jobs == NULL) {
+        free(settings.events);
+        return EXIT_FAILURE;
+    }
+    if (!setup_workers(&batch, settings.numThreads)) {
+        free(batch.jobs);
+        free(settings.events);
+        return EXIT_FAILURE;
+    }
+
+    pthread_t *threads = malloc(settings.numThreads * sizeof(pthread_t));
+    if (threads == NULL) {
+        fprintf(stderr, "Malloc returned null for threads\n");
+        free_workers(&batch);
+        free(batch.jobs);
+        free(settings.events);
+        return EXIT_FAILURE;
+    }
+    long start = now_micros();
+    for (int i = 0; i < settings.numThreads; i++) {
+        pthread_create(&threads[i], NULL, worker, &batch.workers[i]);
+    }
+    for (int i = 0; i < settings.numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    fprintf(stderr, "Ran %d simulations on %d threads in %.2f s\n", batch.numJobs, settings.numThreads, (now_micros() - start) / 1e6);
+    for (int i = 0; i < settings.numThreads; i++) {
+        fprintf(stderr, "  thread %d: %d jobs, %d stolen\n", i, batch.workers[i].jobsRun, batch.workers[i].steals);
+    }
+
+    FILE *out = stdout;
+    if (settings.outPath != NULL) {
+        out = fopen(settings.outPath, "w");
+        if (out == NULL) {
+            fprintf(stderr, "Could not open %s for writing\n", settings.outPath);
+            out = stdout;
+        }
+    }
+    write_csv(out, batch.jobs, batch.numJobs);
+    if (out != stdout) fclose(out);
+
+    free_workers(&batch);
+    free(threads);
+    free(batch.jobs);
+    free(settings.events);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+// This file contains a lock free work stealing deque (Chase and Lev, with the memory orderings of Le et al.) used to spread simulation jobs across threads
+
+#include "work_deque.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+// this function allocates a deque that can hold at least capacity jobs at once, returning 0 if malloc fails; caller has responsibility to free with free_work_deque
+int create_work_deque(WorkDeque *deque, long capacity)
+{
+    long size = 1;
+    while (size < capacity) size *= 2;
+
+    deque->buffer = malloc(size * sizeof(atomic_int));
+    if (deque->buffer == NULL) {
+        fprintf(stderr, "Malloc returned null in create_work_deque\n");
+        return 0;
+    }
+    for (long i = 0; i < size; i++) atomic_init(&deque->buffer[i], WD_EMPTY);
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    deque->mask = size - 1;
+    return 1;
+}
+
+// this function frees the deque's buffer
+void free_work_deque(WorkDeque *deque)
+{
+    free(deque->buffer);
+    deque->buffer = NULL;
+}
+
+// this function adds a job to the bottom of the deque, returning 0 if it is full; must only be called by the owner
+int work_deque_push(WorkDeque *deque, int job)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top > deque->mask) return 0; // jobs are all pushed up front, so there is no need to grow
+
+    atomic_store_explicit(&deque->buffer[bottom & deque->mask], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // the job must be visible before a thief can see the new bottom
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return 1;
+}
+
+// this function takes the newest job from the bottom of the deque, returning WD_EMPTY if there is none; must only be called by the owner
+int work_deque_take(WorkDeque *deque)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst); // claim the job before looking at what thieves have taken
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) { // already empty
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return WD_EMPTY;
+    }
+
+    int job = atomic_load_explicit(&deque->buffer[bottom & deque->mask], memory_order_relaxed);
+    if (top == bottom) {
+        // the last job, so race any thieves for it through top
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            job = WD_EMPTY;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+// this function steals the oldest job from the top of the deque, returning WD_EMPTY if there is none or WD_ABORT if another thread got to it first; can be called by any thread
+int work_deque_steal(WorkDeque *deque)
+{
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) return WD_EMPTY;
+
+    int job = atomic_load_explicit(&deque->buffer[top & deque->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return WD_ABORT;
+    }
+    return job;
+}
@@ -0,0 +1,26 @@
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include <stdatomic.h>
+
+// results of taking or stealing from a deque that are not job indices
+typedef enum {
+    WD_EMPTY = -1,
+    WD_ABORT = -2 // lost a race with another thief or the owner, so worth trying again
+} WorkDequeResult;
+
+// a Chase-Lev work stealing deque of job indices: only its owner pushes and takes (at the bottom), any thread can steal (from the top)
+typedef struct {
+    atomic_long top;
+    atomic_long bottom;
+    atomic_int *buffer;
+    long mask; // capacity - 1, the capacity being a power of two
+} WorkDeque;
+
+int create_work_deque(WorkDeque*, long);
+void free_work_deque(WorkDeque*);
+int work_deque_push(WorkDeque*, int);
+int work_deque_take(WorkDeque*);
+int work_deque_steal(WorkDeque*);
+
+#endif